@@ -0,0 +1,46 @@
+#include "src/pch.h"
+#include "src/core/util/AtomicStackAllocator.h"
+#include "src/core/util/StackAllocator.h"
+#include "AllocatorBenchmark.h"
+
+namespace energonsoftware {
+
+static void allocate_loop(MemoryAllocator& allocator, unsigned int thread)
+{
+    // NOTE: the memory isn't touched, otherwise this just measures page faults
+    for(size_t i=0; i<AllocatorBenchmark::AllocationsPerThread; ++i) {
+        allocator.allocate(AllocatorBenchmark::AllocationSize);
+    }
+}
+
+AllocatorBenchmark::AllocatorBenchmark()
+    : Benchmark("allocator")
+{
+}
+
+AllocatorBenchmark::~AllocatorBenchmark() throw()
+{
+}
+
+void AllocatorBenchmark::run()
+{
+    for(unsigned int threads=1; threads<=MaxThreads; threads <<= 1) {
+        run_allocator("stack", MemoryAllocator::AllocatorTypeStack, threads);
+        run_allocator("atomic_stack", MemoryAllocator::AllocatorTypeAtomicStack, threads);
+    }
+}
+
+void AllocatorBenchmark::run_allocator(const std::string& variant, MemoryAllocator::AllocatorType type, unsigned int threads)
+{
+    const size_t operations = threads * AllocationsPerThread;
+
+    // NOTE: StackAllocator asserts that there's always room left over
+    boost::shared_ptr<MemoryAllocator> allocator(MemoryAllocator::new_allocator(type, (operations + 1) * AllocationSize));
+
+    const double seconds = run_threads(threads, boost::bind(&allocate_loop, boost::ref(*allocator), _1));
+    assert(allocator->allocation_count() == operations);
+
+    report(variant, threads, operations, seconds);
+}
+
+}
@@ -0,0 +1,34 @@
+#if !defined __ALLOCATORBENCHMARK_H__
+#define __ALLOCATORBENCHMARK_H__
+
+#include "src/core/util/MemoryAllocator.h"
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+// contended allocation throughput of the locked
+// StackAllocator vs the lock-free AtomicStackAllocator
+class AllocatorBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        AllocationsPerThread = 250000,
+        AllocationSize = 32,
+        MaxThreads = 16
+    };
+
+public:
+    AllocatorBenchmark();
+    virtual ~AllocatorBenchmark() throw();
+
+public:
+    virtual void run();
+
+private:
+    void run_allocator(const std::string& variant, MemoryAllocator::AllocatorType type, unsigned int threads);
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "src/pch.h"
+#include <iomanip>
+#include <iostream>
+#include "src/core/util/util.h"
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+volatile float g_sink = 0.0f;
+
+static void run_thread(boost::barrier& start, const boost::function<void (unsigned int)>& func, unsigned int index)
+{
+    start.wait();
+    func(index);
+}
+
+double Benchmark::run_threads(unsigned int count, const boost::function<void (unsigned int)>& func)
+{
+    boost::barrier start(count + 1);
+
+    boost::thread_group threads;
+    for(unsigned int i=0; i<count; ++i) {
+        threads.create_thread(boost::bind(&run_thread, boost::ref(start), boost::cref(func), i));
+    }
+
+    start.wait();
+    const double begin = get_time();
+    threads.join_all();
+    return get_time() - begin;
+}
+
+Benchmark::Benchmark(const std::string& name)
+    : _name(name)
+{
+}
+
+Benchmark::~Benchmark() throw()
+{
+}
+
+void Benchmark::report(const std::string& variant, unsigned int threads, size_t operations, double seconds)
+{
+    Result result;
+    result.variant = variant;
+    result.threads = threads;
+    result.operations = operations;
+    result.seconds = seconds;
+    _results.push_back(result);
+
+    std::cout << std::setw(28) << std::left << (_name + "/" + variant)
+        << " threads: " << std::setw(3) << threads
+        << std::fixed << std::setprecision(2)
+        << " " << std::setw(10) << std::right << (result.operations_per_second() / 1000000.0) << " Mops/s"
+        << " " << std::setw(10) << ((seconds * 1000000000.0) / std::max(operations, static_cast<size_t>(1))) << " ns/op"
+        << std::endl;
+}
+
+}
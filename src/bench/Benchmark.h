@@ -0,0 +1,56 @@
+#if !defined __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+namespace energonsoftware {
+
+// results are accumulated here so the compiler can't throw the work away
+extern volatile float g_sink;
+
+/*
+Base class for the microbenchmarks run by the bench target.
+
+Subclasses time whatever they need to in run() and hand each measurement to report().
+*/
+class Benchmark
+{
+public:
+    struct Result
+    {
+        std::string variant;
+        unsigned int threads;
+        size_t operations;
+        double seconds;
+
+        double operations_per_second() const { return seconds > 0.0 ? operations / seconds : 0.0; }
+    };
+
+public:
+    // runs func(thread index) on count threads that all start at once
+    // and returns the wall clock time (in seconds) until they all finish
+    static double run_threads(unsigned int count, const boost::function<void (unsigned int)>& func);
+
+public:
+    explicit Benchmark(const std::string& name);
+    virtual ~Benchmark() throw();
+
+public:
+    const std::string& name() const { return _name; }
+    const std::vector<Result>& results() const { return _results; }
+
+    virtual void run() = 0;
+
+protected:
+    void report(const std::string& variant, unsigned int threads, size_t operations, double seconds);
+
+private:
+    std::string _name;
+    std::vector<Result> _results;
+
+private:
+    Benchmark();
+    DISALLOW_COPY_AND_ASSIGN(Benchmark);
+};
+
+}
+
+#endif
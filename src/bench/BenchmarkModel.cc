@@ -0,0 +1,98 @@
+#include "src/pch.h"
+#include <fstream>
+#include "src/core/common.h"
+#include "BenchmarkModel.h"
+
+namespace energonsoftware {
+
+const char* const BenchmarkModelNames[] = { "cyberdemon", "hellknight", "imp", "lostsoul", "pinky" };
+const size_t BenchmarkModelCount = sizeof(BenchmarkModelNames) / sizeof(BenchmarkModelNames[0]);
+
+static Vector3 read_vector(std::istream& in)
+{
+    std::string paren;
+    float x, y, z;
+    in >> paren >> x >> y >> z >> paren;
+    return Vector3(x, y, z);
+}
+
+static void pose_mesh(const BenchmarkModel& model, BenchmarkMesh& mesh)
+{
+    BOOST_FOREACH(Vertex& vertex, mesh.vertices) {
+        Position position;
+        for(int i=0; i<vertex.weight_count; ++i) {
+            const size_t w = vertex.weight_start + i;
+            const int joint = mesh.weight_joints[w];
+            position += ((model.joint_orientations[joint] * mesh.weight_positions[w]) + model.joint_positions[joint]) * mesh.weight_biases[w];
+        }
+        vertex.position = position;
+    }
+}
+
+boost::filesystem::path benchmark_model_path(const std::string& name)
+{
+    return model_dir() / "monsters" / name / (name + ".md5mesh");
+}
+
+bool load_md5mesh(const boost::filesystem::path& filename, BenchmarkModel& model)
+{
+    std::ifstream in(filename.string().c_str());
+    if(!in) {
+        return false;
+    }
+
+    bool in_joints = false, in_mesh = false;
+
+    std::string line;
+    while(std::getline(in, line)) {
+        std::istringstream tokens(line);
+        std::string token;
+        if(!(tokens >> token)) {
+            continue;
+        }
+
+        if("joints" == token) {
+            in_joints = true;
+        } else if("mesh" == token) {
+            in_mesh = true;
+            model.meshes.push_back(BenchmarkMesh());
+        } else if("}" == token) {
+            if(in_mesh) {
+                pose_mesh(model, model.meshes.back());
+            }
+            in_joints = in_mesh = false;
+        } else if(in_joints) {
+            int parent;
+            tokens >> parent;
+            model.joint_positions.push_back(read_vector(tokens));
+            model.joint_orientations.push_back(Quaternion(read_vector(tokens)));
+        } else if(!in_mesh) {
+            continue;
+        } else if("vert" == token) {
+            std::string paren;
+            float s, t;
+
+            Vertex vertex;
+            tokens >> vertex.index >> paren >> s >> t >> paren >> vertex.weight_start >> vertex.weight_count;
+            vertex.texture_coords = Vector2(s, t);
+            model.meshes.back().vertices.push_back(vertex);
+        } else if("tri" == token) {
+            Triangle triangle;
+            tokens >> triangle.index >> triangle.v1 >> triangle.v2 >> triangle.v3;
+            model.meshes.back().triangles.push_back(triangle);
+        } else if("weight" == token) {
+            int index, joint;
+            float bias;
+            tokens >> index >> joint >> bias;
+
+            BenchmarkMesh& mesh(model.meshes.back());
+            mesh.weight_joints.push_back(joint);
+            mesh.weight_biases.push_back(bias);
+            mesh.weight_positions.push_back(read_vector(tokens));
+        }
+    }
+
+    return !model.joint_positions.empty() && !model.meshes.empty();
+}
+
+}
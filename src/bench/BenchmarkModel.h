@@ -0,0 +1,39 @@
+#if !defined __BENCHMARKMODEL_H__
+#define __BENCHMARKMODEL_H__
+
+#include "src/core/math/Geometry.h"
+#include "src/core/math/Quaternion.h"
+
+namespace energonsoftware {
+
+// just enough of an md5mesh for the benchmarks to use without an Engine
+struct BenchmarkMesh
+{
+    // positioned in the bind pose
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> triangles;
+
+    std::vector<int> weight_joints;
+    std::vector<float> weight_biases;
+    std::vector<Position> weight_positions;
+};
+
+struct BenchmarkModel
+{
+    std::vector<Position> joint_positions;
+    std::vector<Quaternion> joint_orientations;
+    std::vector<BenchmarkMesh> meshes;
+};
+
+// the models in share/gled the benchmarks load
+extern const char* const BenchmarkModelNames[];
+extern const size_t BenchmarkModelCount;
+
+// the path of one of the BenchmarkModelNames models
+boost::filesystem::path benchmark_model_path(const std::string& name);
+
+bool load_md5mesh(const boost::filesystem::path& filename, BenchmarkModel& model);
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include "src/pch.h"
+#include <iostream>
+#include "src/core/math/Matrix4.h"
+#include "src/core/physics/AABB.h"
+#include "src/core/physics/Frustum.h"
+#include "src/core/thread/BaseThread.h"
+#include "src/core/thread/ThreadPool.h"
+#include "src/core/util/util.h"
+#include "src/engine/scene/SceneCuller.h"
+#include "CullingBenchmark.h"
+
+namespace energonsoftware {
+
+// stand in for Renderable / Pickable, with the same virtual lookups and casts
+class BenchmarkRenderable
+{
+public:
+    BenchmarkRenderable(const Position& position, const AABB& bounds) : _position(position), _bounds(bounds) {}
+    virtual ~BenchmarkRenderable() throw() {}
+
+public:
+    const Position& position() const { return _position; }
+    const AABB& relative_bounds() const { return _bounds; }
+    AABB absolute_bounds() const { return _position + _bounds; }
+
+    virtual bool is_transparent() const { return false; }
+
+private:
+    Position _position;
+    AABB _bounds;
+};
+
+class BenchmarkPickable
+{
+public:
+    virtual ~BenchmarkPickable() throw() {}
+};
+
+class BenchmarkActor : public BenchmarkRenderable, public BenchmarkPickable
+{
+public:
+    BenchmarkActor(const Position& position, const AABB& bounds) : BenchmarkRenderable(position, bounds) {}
+    virtual ~BenchmarkActor() throw() {}
+};
+
+// see Camera::check_clipping()
+static int check_clipping(const Vector4& clipped)
+{
+    int code = 0;
+    if(clipped.x() < -clipped.w()) code |= 0x01;
+    if(clipped.x() >  clipped.w()) code |= 0x02;
+    if(clipped.y() < -clipped.w()) code |= 0x04;
+    if(clipped.y() >  clipped.w()) code |= 0x08;
+    if(clipped.z() < -clipped.w()) code |= 0x10;
+    if(clipped.z() >  clipped.w()) code |= 0x20;
+    return code;
+}
+
+// see Camera::visible()
+static bool visible(const Matrix4& clipping, const AABB& bounds)
+{
+    const Position p1(bounds.minimum().homogeneous_position()),
+        p2(bounds.minimum().x(), bounds.minimum().y(), bounds.maximum().z(), 1.0f),
+        p3(bounds.minimum().x(), bounds.maximum().y(), bounds.minimum().z(), 1.0f),
+        p4(bounds.minimum().x(), bounds.maximum().y(), bounds.maximum().z(), 1.0f),
+        p5(bounds.maximum().x(), bounds.minimum().y(), bounds.minimum().z(), 1.0f),
+        p6(bounds.maximum().x(), bounds.minimum().y(), bounds.maximum().z(), 1.0f),
+        p7(bounds.maximum().x(), bounds.maximum().y(), bounds.minimum().z(), 1.0f),
+        p8(bounds.maximum().homogeneous_position());
+
+    return (check_clipping(clipping * p1) & check_clipping(clipping * p2) & check_clipping(clipping * p3)
+        & check_clipping(clipping * p4) & check_clipping(clipping * p5) & check_clipping(clipping * p6)
+        & check_clipping(clipping * p7) & check_clipping(clipping * p8)) == 0;
+}
+
+struct CompareBenchmarkRenderables
+{
+    explicit CompareBenchmarkRenderables(const Position& eye) : _eye(eye) {}
+
+    bool operator()(const boost::shared_ptr<const BenchmarkRenderable> lhs, const boost::shared_ptr<const BenchmarkRenderable> rhs) const
+    {
+        return lhs->absolute_bounds().distance(_eye) < rhs->absolute_bounds().distance(_eye);
+    }
+
+private:
+    Position _eye;
+};
+
+static std::string count_name(size_t count)
+{
+    std::stringstream name;
+    if(count >= 1000) {
+        name << (count / 1000) << "k";
+    } else {
+        name << count;
+    }
+    return name.str();
+}
+
+CullingBenchmark::CullingBenchmark()
+    : Benchmark("culling")
+{
+}
+
+CullingBenchmark::~CullingBenchmark() throw()
+{
+}
+
+void CullingBenchmark::run()
+{
+    run_count(1000);
+    run_count(10000);
+    run_count(100000);
+}
+
+void CullingBenchmark::run_count(size_t count)
+{
+    // boxes scattered around a camera at the origin looking down -z,
+    // half of them pickable like the scene's actors
+    std::srand(1234);
+    std::vector<boost::shared_ptr<BenchmarkRenderable> > renderables;
+    std::vector<uint32_t> flags;
+    for(size_t i=0; i<count; ++i) {
+        const Position position(
+            (std::rand() / static_cast<float>(RAND_MAX)) * 1000.0f - 500.0f,
+            (std::rand() / static_cast<float>(RAND_MAX)) * 1000.0f - 500.0f,
+            (std::rand() / static_cast<float>(RAND_MAX)) * 1000.0f - 500.0f);
+        const AABB bounds(Position(-1.0f, -1.0f, -1.0f), Position(1.0f, 2.0f, 1.0f));
+
+        if(i & 1) {
+            renderables.push_back(boost::shared_ptr<BenchmarkRenderable>(new BenchmarkActor(position, bounds)));
+            flags.push_back(SceneCuller::FlagPickable);
+        } else {
+            renderables.push_back(boost::shared_ptr<BenchmarkRenderable>(new BenchmarkRenderable(position, bounds)));
+            flags.push_back(0);
+        }
+    }
+
+    const Matrix4 clipping(Matrix4::perspective(60.0f, 4.0f / 3.0f));
+    const Position eye;
+    const size_t frames = std::max(static_cast<size_t>(TotalEntries) / count, static_cast<size_t>(MinFrames));
+    const std::string suffix("/" + count_name(count));
+
+    // the old serial scene graph walk for reference
+    std::vector<boost::shared_ptr<BenchmarkRenderable> > visible_renderables, pickable_renderables, lit_renderables;
+    double start = get_time();
+    for(size_t frame=0; frame<frames; ++frame) {
+        visible_renderables.clear();
+        pickable_renderables.clear();
+        lit_renderables.clear();
+
+        BOOST_FOREACH(boost::shared_ptr<BenchmarkRenderable> renderable, renderables) {
+            if(visible(clipping, renderable->absolute_bounds())) {
+                if(renderable->is_transparent()) {
+                    continue;
+                }
+
+                visible_renderables.push_back(renderable);
+
+                boost::shared_ptr<BenchmarkPickable> pickable(boost::dynamic_pointer_cast<BenchmarkPickable, BenchmarkRenderable>(renderable));
+                if(pickable) {
+                    pickable_renderables.push_back(renderable);
+                }
+            }
+            lit_renderables.push_back(renderable);
+        }
+        std::sort(visible_renderables.begin(), visible_renderables.end(), CompareBenchmarkRenderables(eye));
+    }
+    report("serial" + suffix, 1, count * frames, get_time() - start);
+
+    SceneCuller culler;
+    const unsigned int cores = std::max(boost::thread::hardware_concurrency(), 1u);
+    for(unsigned int threads=1; ; threads <<= 1) {
+        threads = std::min(threads, cores);
+
+        // NOTE: the calling thread helps, so the pool needs one less thread
+        ThreadPool pool(threads - 1);
+        pool.start(BaseThreadFactory());
+
+        start = get_time();
+        for(size_t frame=0; frame<frames; ++frame) {
+            culler.clear();
+            culler.reserve(count);
+            for(size_t i=0; i<count; ++i) {
+                culler.add(renderables[i]->position(), renderables[i]->relative_bounds(), flags[i]);
+            }
+            culler.cull(pool, Frustum(clipping), eye);
+        }
+        report("culler" + suffix, threads, count * frames, get_time() - start);
+
+        if(culler.visible().size() != visible_renderables.size() || culler.pickable().size() != pickable_renderables.size()) {
+            std::cerr << "culler disagrees with the serial walk: visible " << culler.visible().size() << " vs " << visible_renderables.size()
+                << ", pickable " << culler.pickable().size() << " vs " << pickable_renderables.size() << std::endl;
+        }
+
+        if(threads == cores) {
+            break;
+        }
+    }
+}
+
+}
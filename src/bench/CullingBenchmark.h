@@ -0,0 +1,33 @@
+#if !defined __CULLINGBENCHMARK_H__
+#define __CULLINGBENCHMARK_H__
+
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+// frustum culling the scene graph (what Scene::create_scene_graph() runs every frame),
+// the old per-renderable shared_ptr walk vs the flat parallel SceneCuller
+class CullingBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        // renderables culled per variant, split into frames
+        TotalEntries = 4000000,
+        MinFrames = 10
+    };
+
+public:
+    CullingBenchmark();
+    virtual ~CullingBenchmark() throw();
+
+public:
+    virtual void run();
+
+private:
+    void run_count(size_t count);
+};
+
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "src/pch.h"
+#include "src/core/math/Matrix4.h"
+#include "src/core/math/Plane.h"
+#include "src/core/math/Quaternion.h"
+#include "src/core/math/simd_util.h"
+#include "src/core/physics/AABB.h"
+#include "src/core/util/util.h"
+#include "MathBenchmark.h"
+
+namespace energonsoftware {
+
+static float random_float()
+{
+    return (std::rand() / static_cast<float>(RAND_MAX)) * 2.0f - 1.0f;
+}
+
+static Vector4 random_vector()
+{
+    return Vector4(random_float(), random_float(), random_float(), 1.0f);
+}
+
+static Matrix4 random_matrix()
+{
+    float m[16];
+    for(int i=0; i<16; ++i) {
+        m[i] = random_float();
+    }
+    return Matrix4(m);
+}
+
+MathBenchmark::MathBenchmark()
+    : Benchmark("math")
+{
+}
+
+MathBenchmark::~MathBenchmark() throw()
+{
+}
+
+void MathBenchmark::run()
+{
+    std::srand(1234);
+
+    run_vector();
+    run_matrix();
+    run_quaternion();
+    run_bounds();
+}
+
+void MathBenchmark::run_vector()
+{
+    std::vector<Vector4> a, b;
+    for(size_t i=0; i<InputCount; ++i) {
+        a.push_back(random_vector());
+        b.push_back(random_vector());
+    }
+
+    float sum = 0.0f;
+    double start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        sum += a[i % InputCount] * b[(i + 1) % InputCount];
+    }
+    report("dot", 1, Operations, get_time() - start);
+
+    Vector4 v;
+    start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        v += a[i % InputCount] ^ b[(i + 1) % InputCount];
+    }
+    report("cross", 1, Operations, get_time() - start);
+    sum += v.x();
+
+    v = Vector4();
+    start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        v += a[i % InputCount].normalized();
+    }
+    report("normalize", 1, Operations, get_time() - start);
+    sum += v.x();
+
+    g_sink = g_sink + sum;
+}
+
+void MathBenchmark::run_matrix()
+{
+    std::vector<Matrix4> a, b;
+    std::vector<Vector4> v;
+    for(size_t i=0; i<InputCount; ++i) {
+        a.push_back(random_matrix());
+        b.push_back(random_matrix());
+        v.push_back(random_vector());
+    }
+
+    // transform_points() works on packed xyz
+    std::vector<float> points(InputCount * 3);
+    for(size_t i=0; i<InputCount; ++i) {
+        points[(i * 3) + 0] = v[i].x();
+        points[(i * 3) + 1] = v[i].y();
+        points[(i * 3) + 2] = v[i].z();
+    }
+    const size_t batches = Operations / InputCount;
+
+    float sum = 0.0f;
+
+    // every kernel level simd_util can dispatch to
+    const SIMDLevel level = simd_level();
+    for(int l=SIMDScalar; l<=supported_simd_level(); ++l) {
+        const std::string name(simd_level_name(simd_level(static_cast<SIMDLevel>(l))));
+
+        Matrix4 m;
+        double start = get_time();
+        for(size_t i=0; i<Operations; ++i) {
+            m = a[i % InputCount] * b[(i + 1) % InputCount];
+            sum += m(0, 0);
+        }
+        report("mat4_mul/" + name, 1, Operations, get_time() - start);
+
+        std::vector<float> transformed(points.size());
+        start = get_time();
+        for(size_t i=0; i<batches; ++i) {
+            transform_points(a[i % InputCount], &points[0], &transformed[0], InputCount);
+            sum += transformed[0];
+        }
+        report("transform_points/" + name, 1, batches * InputCount, get_time() - start);
+    }
+    simd_level(level);
+
+    Vector4 r;
+    double start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        r += a[i % InputCount] * v[(i + 1) % InputCount];
+    }
+    report("mat4_vec", 1, Operations, get_time() - start);
+    sum += r.x();
+
+    g_sink = g_sink + sum;
+}
+
+void MathBenchmark::run_quaternion()
+{
+    std::vector<Quaternion> a, b;
+    std::vector<float> t;
+    for(size_t i=0; i<InputCount; ++i) {
+        a.push_back(Quaternion::new_euler(random_float(), random_float(), random_float()));
+        b.push_back(Quaternion::new_euler(random_float(), random_float(), random_float()));
+        t.push_back((random_float() + 1.0f) * 0.5f);
+    }
+
+    Quaternion q;
+    double start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        q = a[i % InputCount].slerp(b[(i + 1) % InputCount], t[i % InputCount]);
+    }
+    report("slerp", 1, Operations, get_time() - start);
+    g_sink = g_sink + q.scalar();
+
+    start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        q = a[i % InputCount].lerp(b[(i + 1) % InputCount], t[i % InputCount]);
+    }
+    report("nlerp", 1, Operations, get_time() - start);
+    g_sink = g_sink + q.scalar();
+
+    // flat poses, with b a small step away from a like neighboring keyframes
+    const size_t stride = pose_stride(InputCount);
+    std::vector<float> pa(pose_size(InputCount)), pb(pa.size()), pout(pa.size());
+    for(size_t i=0; i<InputCount; ++i) {
+        b[i] = (a[i] * Quaternion::new_euler(random_float() * 0.1f, random_float() * 0.1f, random_float() * 0.1f)).normalized();
+
+        pa[(PoseOrientationX * stride) + i] = a[i].vector().x();
+        pa[(PoseOrientationY * stride) + i] = a[i].vector().y();
+        pa[(PoseOrientationZ * stride) + i] = a[i].vector().z();
+        pa[(PoseOrientationW * stride) + i] = a[i].scalar();
+        pb[(PoseOrientationX * stride) + i] = b[i].vector().x();
+        pb[(PoseOrientationY * stride) + i] = b[i].vector().y();
+        pb[(PoseOrientationZ * stride) + i] = b[i].vector().z();
+        pb[(PoseOrientationW * stride) + i] = b[i].scalar();
+    }
+    const size_t batches = Operations / InputCount;
+
+    const SIMDLevel level = simd_level();
+    for(int l=SIMDScalar; l<=supported_simd_level(); ++l) {
+        const std::string name(simd_level_name(simd_level(static_cast<SIMDLevel>(l))));
+
+        start = get_time();
+        for(size_t i=0; i<batches; ++i) {
+            blend_poses(&pa[0], &pb[0], t[i % InputCount], &pout[0], stride);
+            g_sink = g_sink + pout[PoseOrientationW * stride];
+        }
+        report("blend_poses/" + name, 1, batches * InputCount, get_time() - start);
+    }
+    simd_level(level);
+}
+
+void MathBenchmark::run_bounds()
+{
+    std::vector<Point3> points;
+    std::vector<Plane> planes;
+    for(size_t i=0; i<InputCount; ++i) {
+        points.push_back(Point3(random_float() * 100.0f, random_float() * 100.0f, random_float() * 100.0f, 1.0f));
+        planes.push_back(Plane(Vector3(random_float(), random_float(), random_float()) + Vector3(0.0f, 2.0f, 0.0f), random_float()));
+    }
+
+    AABB bounds;
+    double start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        if(0 == (i % InputCount)) {
+            bounds = AABB();
+        }
+        bounds.update(points[i % InputCount]);
+    }
+    report("aabb_update", 1, Operations, get_time() - start);
+
+    Point3 closest;
+    start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        closest += bounds.closest_point(points[(i * 7) % InputCount] * 2.0f);
+    }
+    report("aabb_closest_point", 1, Operations, get_time() - start);
+    g_sink = g_sink + closest.x();
+
+    float sum = 0.0f;
+    start = get_time();
+    for(size_t i=0; i<Operations; ++i) {
+        sum += planes[i % InputCount].distance(points[(i + 1) % InputCount]);
+    }
+    report("plane_distance", 1, Operations, get_time() - start);
+    g_sink = g_sink + sum;
+}
+
+}
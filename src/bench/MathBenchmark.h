@@ -0,0 +1,38 @@
+#if !defined __MATHBENCHMARK_H__
+#define __MATHBENCHMARK_H__
+
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+// the src/core/math and AABB kernels in isolation
+// NOTE: build with sse=0 to get the scalar numbers to compare against
+class MathBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        // inputs per array, small enough to stay in cache
+        InputCount = 1024,
+
+        // operations timed per kernel
+        Operations = 10000000
+    };
+
+public:
+    MathBenchmark();
+    virtual ~MathBenchmark() throw();
+
+public:
+    virtual void run();
+
+private:
+    void run_vector();
+    void run_matrix();
+    void run_quaternion();
+    void run_bounds();
+};
+
+}
+
+#endif
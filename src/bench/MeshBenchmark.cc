@@ -0,0 +1,380 @@
+#include "src/pch.h"
+#include <iostream>
+#include "src/core/util/util.h"
+#include "BenchmarkModel.h"
+#include "MeshBenchmark.h"
+
+namespace energonsoftware {
+
+// a grid of quads that don't share vertices, like an unwelded import
+static BenchmarkMesh grid_mesh(size_t size)
+{
+    BenchmarkMesh mesh;
+    for(size_t y=0; y<size; ++y) {
+        for(size_t x=0; x<size; ++x) {
+            const int base = static_cast<int>(mesh.vertices.size());
+            for(int corner=0; corner<4; ++corner) {
+                const float cx = static_cast<float>(x + (corner & 1)), cy = static_cast<float>(y + (corner >> 1));
+
+                Vertex vertex;
+                vertex.index = base + corner;
+                vertex.position = Position(cx, cy, 0.0f);
+                vertex.texture_coords = Vector2(cx / size, cy / size);
+                mesh.vertices.push_back(vertex);
+            }
+
+            Triangle triangle;
+            triangle.index = static_cast<int>(mesh.triangles.size());
+            triangle.v1 = base; triangle.v2 = base + 1; triangle.v3 = base + 3;
+            mesh.triangles.push_back(triangle);
+
+            triangle.index++;
+            triangle.v1 = base; triangle.v2 = base + 3; triangle.v3 = base + 2;
+            mesh.triangles.push_back(triangle);
+        }
+    }
+    return mesh;
+}
+
+// a grid of quads sharing their vertices, with at least triangle_count triangles
+static BenchmarkMesh shared_grid_mesh(size_t triangle_count)
+{
+    size_t size = 1;
+    while(size * size * 2 < triangle_count) {
+        size++;
+    }
+
+    BenchmarkMesh mesh;
+    for(size_t y=0; y<=size; ++y) {
+        for(size_t x=0; x<=size; ++x) {
+            Vertex vertex;
+            vertex.index = static_cast<int>(mesh.vertices.size());
+            vertex.position = Position(static_cast<float>(x), static_cast<float>(y), 0.0f);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    for(size_t y=0; y<size; ++y) {
+        for(size_t x=0; x<size; ++x) {
+            const int base = static_cast<int>((y * (size + 1)) + x);
+
+            Triangle triangle;
+            triangle.index = static_cast<int>(mesh.triangles.size());
+            triangle.v1 = base; triangle.v2 = base + 1; triangle.v3 = base + static_cast<int>(size) + 2;
+            mesh.triangles.push_back(triangle);
+
+            triangle.index++;
+            triangle.v1 = base; triangle.v2 = base + static_cast<int>(size) + 2; triangle.v3 = base + static_cast<int>(size) + 1;
+            mesh.triangles.push_back(triangle);
+        }
+    }
+    return mesh;
+}
+
+static std::string grid_name(size_t size)
+{
+    std::stringstream name;
+    name << "grid" << size << "x" << size;
+    return name.str();
+}
+
+// Mesh::weld_vertices() as it was, comparing every pair of vertices
+// and then rescanning the triangles for every welded vertex
+static size_t weld_vertices_pairwise(std::vector<Vertex>& vertices, std::vector<Triangle>& triangles)
+{
+    const int vcount = static_cast<int>(vertices.size());
+
+    boost::unordered_map<int, int> welded;
+    for(int i=0; i<vcount; ++i) {
+        for(int j=i+1; j<vcount; ++j) {
+            const Vertex &v1(vertices[i]), &v2(vertices[j]);
+            if(v1.position.distance_squared(v2.position) < WeldDistanceSquared
+                && v1.texture_coords.distance_squared(v2.texture_coords) < WeldDistanceSquared)
+            {
+                welded[v1.index] = v2.index;
+            }
+        }
+    }
+
+    if(welded.empty()) {
+        return vertices.size();
+    }
+
+    const size_t tcount = triangles.size();
+    size_t j=0;
+    for(int i=0; i<vcount; ++i) {
+        int old_index = i, new_index;
+        if(welded.end() == welded.find(vertices[i].index)) {
+            vertices[j] = vertices[i];
+            vertices[j].index = static_cast<int>(j);
+            new_index = static_cast<int>(j++);
+        } else {
+            new_index = welded.at(i);
+        }
+
+        for(size_t t=0; t<tcount; ++t) {
+            Triangle& triangle(triangles[t]);
+            if(triangle.v1 == old_index) {
+                triangle.v1 = new_index;
+            } else if(triangle.v2 == old_index) {
+                triangle.v2 = new_index;
+            } else if(triangle.v3 == old_index) {
+                triangle.v3 = new_index;
+            }
+        }
+    }
+
+    return j;
+}
+
+static std::string triangle_count_name(size_t count)
+{
+    std::stringstream name;
+    if(count >= 1000000) {
+        name << (count / 1000000) << "m";
+    } else if(count >= 1000) {
+        name << (count / 1000) << "k";
+    } else {
+        name << count;
+    }
+    return name.str();
+}
+
+// Mesh::compute_edges() as it was, searching every edge for each backwards triangle edge
+static void compute_edges_linear_match(std::vector<Edge>& edges, int v1, int v2, int t)
+{
+    BOOST_FOREACH(Edge& edge, edges) {
+        if(edge.v1 == v1 && edge.v2 == v2 && edge.t2 < 0) {
+            edge.t2 = t;
+            return;
+        }
+    }
+
+    const Edge edge = { v1, v2, t, -1 };
+    edges.push_back(edge);
+}
+
+static void compute_edges_linear(const std::vector<Triangle>& triangles, std::vector<Edge>& edges)
+{
+    edges.clear();
+    for(size_t i=0; i<triangles.size(); ++i) {
+        const Triangle& triangle(triangles[i]);
+        const int t = static_cast<int>(i);
+        if(triangle.v1 < triangle.v2) {
+            const Edge edge = { triangle.v1, triangle.v2, t, -1 };
+            edges.push_back(edge);
+        }
+        if(triangle.v2 < triangle.v3) {
+            const Edge edge = { triangle.v2, triangle.v3, t, -1 };
+            edges.push_back(edge);
+        }
+        if(triangle.v3 < triangle.v1) {
+            const Edge edge = { triangle.v3, triangle.v1, t, -1 };
+            edges.push_back(edge);
+        }
+    }
+
+    for(size_t i=0; i<triangles.size(); ++i) {
+        const Triangle& triangle(triangles[i]);
+        const int t = static_cast<int>(i);
+        if(triangle.v1 > triangle.v2) {
+            compute_edges_linear_match(edges, triangle.v2, triangle.v1, t);
+        }
+        if(triangle.v2 > triangle.v3) {
+            compute_edges_linear_match(edges, triangle.v3, triangle.v2, t);
+        }
+        if(triangle.v3 > triangle.v1) {
+            compute_edges_linear_match(edges, triangle.v1, triangle.v3, t);
+        }
+    }
+}
+
+static bool same_edges(const std::vector<Edge>& a, const std::vector<Edge>& b)
+{
+    if(a.size() != b.size()) {
+        return false;
+    }
+
+    for(size_t i=0; i<a.size(); ++i) {
+        if(a[i].v1 != b[i].v1 || a[i].v2 != b[i].v2 || a[i].t1 != b[i].t1 || a[i].t2 != b[i].t2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MeshBenchmark::MeshBenchmark()
+    : Benchmark("mesh")
+{
+}
+
+MeshBenchmark::~MeshBenchmark() throw()
+{
+}
+
+void MeshBenchmark::run()
+{
+    for(size_t i=0; i<BenchmarkModelCount; ++i) {
+        const boost::filesystem::path filename(benchmark_model_path(BenchmarkModelNames[i]));
+
+        BenchmarkModel model;
+        if(!load_md5mesh(filename, model)) {
+            std::cerr << "Could not load " << filename << ", skipping" << std::endl;
+            continue;
+        }
+        run_weld(BenchmarkModelNames[i], model.meshes, Repeats, true);
+        run_edges(BenchmarkModelNames[i], model.meshes, Repeats, true);
+        run_cache(BenchmarkModelNames[i], model.meshes, Repeats);
+        run_pack(BenchmarkModelNames[i], model.meshes, Repeats);
+    }
+
+    run_weld(grid_name(SmallGridSize), std::vector<BenchmarkMesh>(1, grid_mesh(SmallGridSize)), 1, true);
+    run_weld(grid_name(LargeGridSize), std::vector<BenchmarkMesh>(1, grid_mesh(LargeGridSize)), 1, false);
+
+    run_edges(triangle_count_name(SmallEdgeTriangles), std::vector<BenchmarkMesh>(1, shared_grid_mesh(SmallEdgeTriangles)), 1, true);
+    run_edges(triangle_count_name(MediumEdgeTriangles), std::vector<BenchmarkMesh>(1, shared_grid_mesh(MediumEdgeTriangles)), 1, false);
+    run_edges(triangle_count_name(LargeEdgeTriangles), std::vector<BenchmarkMesh>(1, shared_grid_mesh(LargeEdgeTriangles)), 1, false);
+
+    // the worst case for the cache, triangles in no particular order
+    BenchmarkMesh shuffled(shared_grid_mesh(CacheTriangles));
+    std::srand(1234);
+    std::random_shuffle(shuffled.triangles.begin(), shuffled.triangles.end());
+    run_cache(triangle_count_name(CacheTriangles) + "/shuffled", std::vector<BenchmarkMesh>(1, shuffled), 1);
+}
+
+void MeshBenchmark::run_weld(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats, bool pairwise)
+{
+    size_t vcount = 0;
+    BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+        vcount += mesh.vertices.size();
+    }
+
+    // NOTE: the copies are part of the timing for both, like loading would be
+    size_t pairwise_welded = 0;
+    if(pairwise) {
+        const double start = get_time();
+        for(size_t i=0; i<repeats; ++i) {
+            pairwise_welded = 0;
+            BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+                std::vector<Vertex> vertices(mesh.vertices);
+                std::vector<Triangle> triangles(mesh.triangles);
+                pairwise_welded += weld_vertices_pairwise(vertices, triangles);
+            }
+        }
+        report("weld/" + name + "/pairwise", 1, repeats * vcount, get_time() - start);
+    }
+
+    size_t welded = 0;
+    const double start = get_time();
+    for(size_t i=0; i<repeats; ++i) {
+        welded = 0;
+        BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+            std::vector<Vertex> vertices(mesh.vertices);
+            std::vector<Triangle> triangles(mesh.triangles);
+            welded += weld_vertices(&vertices[0], vertices.size(), triangles.empty() ? NULL : &triangles[0], triangles.size());
+        }
+    }
+    report("weld/" + name + "/hashed", 1, repeats * vcount, get_time() - start);
+
+    if(pairwise && welded != pairwise_welded) {
+        std::cerr << name << " welded down to " << welded << " vertices, pairwise welding kept " << pairwise_welded << std::endl;
+    }
+}
+
+void MeshBenchmark::run_edges(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats, bool linear)
+{
+    size_t tcount = 0;
+    BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+        tcount += mesh.triangles.size();
+    }
+
+    std::vector<std::vector<Edge> > linear_edges(meshes.size());
+    if(linear) {
+        const double start = get_time();
+        for(size_t i=0; i<repeats; ++i) {
+            for(size_t j=0; j<meshes.size(); ++j) {
+                compute_edges_linear(meshes[j].triangles, linear_edges[j]);
+            }
+        }
+        report("edges/" + name + "/linear", 1, repeats * tcount, get_time() - start);
+    }
+
+    std::vector<std::vector<Edge> > edges(meshes.size());
+    const double start = get_time();
+    for(size_t i=0; i<repeats; ++i) {
+        for(size_t j=0; j<meshes.size(); ++j) {
+            compute_edges(meshes[j].triangles.empty() ? NULL : &meshes[j].triangles[0], meshes[j].triangles.size(), edges[j]);
+        }
+    }
+    report("edges/" + name + "/hashed", 1, repeats * tcount, get_time() - start);
+
+    if(linear) {
+        for(size_t j=0; j<meshes.size(); ++j) {
+            if(!same_edges(edges[j], linear_edges[j])) {
+                std::cerr << name << " mesh " << j << " edges don't match the linear search" << std::endl;
+            }
+        }
+    }
+}
+
+void MeshBenchmark::run_cache(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats)
+{
+    size_t tcount = 0, original_misses = 0;
+    BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+        tcount += mesh.triangles.size();
+        original_misses += vertex_cache_misses(mesh.triangles.empty() ? NULL : &mesh.triangles[0], mesh.triangles.size(), mesh.vertices.size());
+    }
+
+    // NOTE: the copies are part of the timing, like loading would be
+    size_t misses = 0;
+    const double start = get_time();
+    for(size_t i=0; i<repeats; ++i) {
+        misses = 0;
+        BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+            if(mesh.triangles.empty()) {
+                continue;
+            }
+
+            std::vector<Vertex> vertices(mesh.vertices);
+            std::vector<Triangle> triangles(mesh.triangles);
+            optimize_vertex_cache(&triangles[0], triangles.size(), vertices.size());
+            optimize_vertex_fetch(&vertices[0], vertices.size(), &triangles[0], triangles.size());
+            misses += vertex_cache_misses(&triangles[0], triangles.size(), vertices.size());
+        }
+    }
+    report("cache/" + name, 1, repeats * tcount, get_time() - start);
+
+    std::cout << name << " vertex cache ACMR " << (original_misses / static_cast<float>(tcount))
+        << " -> " << (misses / static_cast<float>(tcount)) << std::endl;
+}
+
+void MeshBenchmark::run_pack(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats)
+{
+    size_t vcount = 0;
+    BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+        vcount += mesh.vertices.size();
+    }
+
+    // room for the vertex buffer and the debugging line buffers
+    boost::shared_ptr<MemoryAllocator> allocator(MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeStack,
+        (vcount * (sizeof(PackedVertex) + (2 * 2 * 3 * sizeof(float)))) + 4096));
+    Geometry geometry(vcount, *allocator);
+
+    const double start = get_time();
+    for(size_t i=0; i<repeats; ++i) {
+        size_t vstart = 0;
+        BOOST_FOREACH(const BenchmarkMesh& mesh, meshes) {
+            geometry.copy_vertices(&mesh.vertices[0], mesh.vertices.size(), vstart);
+            vstart += mesh.vertices.size();
+        }
+    }
+    report("pack/" + name, 1, repeats * vcount, get_time() - start);
+
+    // what an animated model uploads every frame, against the separate
+    // position, normal, tangent and texture coordinate float arrays
+    const size_t unpacked = vcount * (3 + 3 + 4 + 2) * sizeof(float);
+    std::cout << name << " uploads " << geometry.vertex_buffer_size() << " bytes per frame ("
+        << unpacked << " as float arrays)" << std::endl;
+}
+
+}
@@ -0,0 +1,50 @@
+#if !defined __MESHBENCHMARK_H__
+#define __MESHBENCHMARK_H__
+
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+struct BenchmarkMesh;
+
+// the load-time mesh processing in Model::add_mesh() (welding, vertex cache
+// optimization and edge adjacency), run on the share/gled models and on synthetic grids,
+// and packing the vertices for upload like Model::calculate_vertices()
+class MeshBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        // times each model mesh is processed
+        Repeats = 10,
+
+        // quads per side of the synthetic grids, the pairwise weld only runs on the small one
+        SmallGridSize = 64,
+        LargeGridSize = 512,
+
+        // triangle counts for the edge adjacency, the linear search only runs on the first
+        SmallEdgeTriangles = 10000,
+        MediumEdgeTriangles = 100000,
+        LargeEdgeTriangles = 1000000,
+
+        // triangle count of the shuffled grid for the vertex cache optimization
+        CacheTriangles = 100000
+    };
+
+public:
+    MeshBenchmark();
+    virtual ~MeshBenchmark() throw();
+
+public:
+    virtual void run();
+
+private:
+    void run_weld(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats, bool pairwise);
+    void run_edges(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats, bool linear);
+    void run_cache(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats);
+    void run_pack(const std::string& name, const std::vector<BenchmarkMesh>& meshes, size_t repeats);
+};
+
+}
+
+#endif
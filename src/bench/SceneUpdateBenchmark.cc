@@ -0,0 +1,88 @@
+#include "src/pch.h"
+#include "src/core/physics/Physical.h"
+#include "src/core/thread/BaseThread.h"
+#include "src/core/thread/ThreadPool.h"
+#include "src/core/util/util.h"
+#include "SceneUpdateBenchmark.h"
+
+namespace energonsoftware {
+
+// stands in for an Actor, with about as much work per step
+class BenchmarkPhysical : public Physical
+{
+public:
+    enum
+    {
+        ThinkIterations = 32
+    };
+
+public:
+    BenchmarkPhysical()
+        : Physical()
+    {
+        velocity(Vector3(1.0f, 0.0f, 1.0f));
+    }
+
+    virtual ~BenchmarkPhysical() throw()
+    {
+    }
+
+private:
+    virtual bool on_simulate(double dt)
+    {
+        for(size_t i=0; i<ThinkIterations; ++i) {
+            yaw(dt);
+        }
+        bounds(AABB(Position(-1.0f, -1.0f, -1.0f), Position(1.0f, 1.0f, 1.0f)));
+        return true;
+    }
+};
+
+SceneUpdateBenchmark::SceneUpdateBenchmark()
+    : Benchmark("scene_update")
+{
+}
+
+SceneUpdateBenchmark::~SceneUpdateBenchmark() throw()
+{
+}
+
+void SceneUpdateBenchmark::run()
+{
+    std::vector<boost::shared_ptr<Physical> > physicals;
+    for(size_t i=0; i<PhysicalCount; ++i) {
+        physicals.push_back(boost::shared_ptr<Physical>(new BenchmarkPhysical()));
+    }
+
+    const double dt = 1.0 / 60.0;
+
+    // the old serial update for reference
+    double start = get_time();
+    for(size_t i=0; i<TickCount; ++i) {
+        BOOST_FOREACH(boost::shared_ptr<Physical> physical, physicals) {
+            physical->simulate(i * dt, dt);
+        }
+    }
+    report("serial", 1, PhysicalCount * TickCount, get_time() - start);
+
+    const unsigned int cores = std::max(boost::thread::hardware_concurrency(), 1u);
+    for(unsigned int threads=1; ; threads <<= 1) {
+        threads = std::min(threads, cores);
+
+        // NOTE: the calling thread helps, so the pool needs one less thread
+        ThreadPool pool(threads - 1);
+        pool.start(BaseThreadFactory());
+
+        start = get_time();
+        for(size_t i=0; i<TickCount; ++i) {
+            Physical::simulate_all(pool, physicals, i * dt, dt);
+        }
+        report("simulate_all", threads, PhysicalCount * TickCount, get_time() - start);
+
+        if(threads == cores) {
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,29 @@
+#if !defined __SCENEUPDATEBENCHMARK_H__
+#define __SCENEUPDATEBENCHMARK_H__
+
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+// scaling of Physical::simulate_all() (what Scene::update()
+// runs every tick) from 1 thread up to the number of cores
+class SceneUpdateBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        PhysicalCount = 4096,
+        TickCount = 100
+    };
+
+public:
+    SceneUpdateBenchmark();
+    virtual ~SceneUpdateBenchmark() throw();
+
+public:
+    virtual void run();
+};
+
+}
+
+#endif
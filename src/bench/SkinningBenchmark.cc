@@ -0,0 +1,178 @@
+#include "src/pch.h"
+#include <iostream>
+#include "src/core/math/simd_util.h"
+#include "src/core/util/util.h"
+#include "BenchmarkModel.h"
+#include "SkinningBenchmark.h"
+
+namespace energonsoftware {
+
+// a whole model's weights in vertex order
+struct BenchmarkSkin
+{
+    size_t joint_count;
+    std::vector<float> pose;
+
+    // the reference data, laid out like Weight
+    std::vector<int> joints;
+    std::vector<float> biases;
+    std::vector<Vector3> positions, normals;
+
+    // the palette data
+    std::vector<SkinWeight> skin_weights;
+    std::vector<uint32_t> skin_counts;
+
+    BenchmarkSkin() : joint_count(0) {}
+};
+
+static void build_skin(const BenchmarkModel& model, BenchmarkSkin& skin)
+{
+    skin.joint_count = model.joint_positions.size();
+
+    const size_t stride = pose_stride(skin.joint_count);
+    skin.pose.assign(pose_size(skin.joint_count), 0.0f);
+    std::fill(skin.pose.begin() + (PoseOrientationW * stride), skin.pose.end(), 1.0f);
+    for(size_t i=0; i<skin.joint_count; ++i) {
+        skin.pose[(PosePositionX * stride) + i] = model.joint_positions[i].x();
+        skin.pose[(PosePositionY * stride) + i] = model.joint_positions[i].y();
+        skin.pose[(PosePositionZ * stride) + i] = model.joint_positions[i].z();
+        skin.pose[(PoseOrientationX * stride) + i] = model.joint_orientations[i].vector().x();
+        skin.pose[(PoseOrientationY * stride) + i] = model.joint_orientations[i].vector().y();
+        skin.pose[(PoseOrientationZ * stride) + i] = model.joint_orientations[i].vector().z();
+        skin.pose[(PoseOrientationW * stride) + i] = model.joint_orientations[i].scalar();
+    }
+
+    BOOST_FOREACH(const BenchmarkMesh& mesh, model.meshes) {
+        BOOST_FOREACH(const Vertex& vertex, mesh.vertices) {
+            skin.skin_counts.push_back(vertex.weight_count);
+            for(int j=0; j<vertex.weight_count; ++j) {
+                const size_t w = vertex.weight_start + j;
+                skin.joints.push_back(mesh.weight_joints[w]);
+                skin.biases.push_back(mesh.weight_biases[w]);
+                skin.positions.push_back(mesh.weight_positions[w]);
+            }
+        }
+    }
+
+    // NOTE: the joint-space normals only need to be plausible for timing
+    for(size_t i=0; i<skin.positions.size(); ++i) {
+        skin.normals.push_back(skin.positions[i].length_squared() > 0.0f ? skin.positions[i].normalized() : Vector3(0.0f, 0.0f, 1.0f));
+
+        SkinWeight weight = SkinWeight();
+        for(int k=0; k<3; ++k) {
+            weight.position[k] = skin.positions[i][k] * skin.biases[i];
+            weight.normal[k] = weight.tangent[k] = weight.bitangent[k] = skin.normals[i][k];
+        }
+        weight.position[3] = skin.biases[i];
+        weight.joint = skin.joints[i];
+        skin.skin_weights.push_back(weight);
+    }
+}
+
+// the per-weight path Mesh::position_vertices() used to take
+static void skin_quaternion(const BenchmarkSkin& skin, SkinnedVertex* out)
+{
+    const size_t stride = pose_stride(skin.joint_count);
+    const float* const pose = &skin.pose[0];
+
+    size_t w = 0;
+    for(size_t i=0; i<skin.skin_counts.size(); ++i) {
+        Position position;
+        Vector3 normal, tangent, bitangent;
+        for(uint32_t j=0; j<skin.skin_counts[i]; ++j, ++w) {
+            const int joint = skin.joints[w];
+
+            Quaternion orientation;
+            orientation.vector() = Vector3(pose[(PoseOrientationX * stride) + joint], pose[(PoseOrientationY * stride) + joint], pose[(PoseOrientationZ * stride) + joint]);
+            orientation.scalar(pose[(PoseOrientationW * stride) + joint]);
+            const Position joint_position(pose[(PosePositionX * stride) + joint], pose[(PosePositionY * stride) + joint], pose[(PosePositionZ * stride) + joint]);
+
+            position += ((orientation * skin.positions[w]) + joint_position) * skin.biases[w];
+            normal += (orientation * skin.normals[w]);
+            tangent += (orientation * skin.normals[w]);
+            bitangent += (orientation * skin.normals[w]);
+        }
+        normal.normalize();
+        tangent.normalize();
+        bitangent.normalize();
+
+        for(int k=0; k<3; ++k) {
+            out[i].position[k] = position[k];
+            out[i].normal[k] = normal[k];
+            out[i].tangent[k] = tangent[k];
+            out[i].bitangent[k] = bitangent[k];
+        }
+    }
+}
+
+SkinningBenchmark::SkinningBenchmark()
+    : Benchmark("skinning")
+{
+}
+
+SkinningBenchmark::~SkinningBenchmark() throw()
+{
+}
+
+void SkinningBenchmark::run()
+{
+    for(size_t i=0; i<BenchmarkModelCount; ++i) {
+        run_model(BenchmarkModelNames[i]);
+    }
+}
+
+void SkinningBenchmark::run_model(const std::string& name)
+{
+    const boost::filesystem::path filename(benchmark_model_path(name));
+
+    BenchmarkModel model;
+    if(!load_md5mesh(filename, model)) {
+        std::cerr << "Could not load " << filename << ", skipping" << std::endl;
+        return;
+    }
+
+    BenchmarkSkin skin;
+    build_skin(model, skin);
+
+    const size_t vcount = skin.skin_counts.size();
+    const size_t frames = std::max(static_cast<size_t>(Vertices) / vcount, static_cast<size_t>(1));
+
+    std::vector<SkinnedVertex> expected(vcount), skinned(vcount);
+    double start = get_time();
+    for(size_t i=0; i<frames; ++i) {
+        skin_quaternion(skin, &expected[0]);
+        g_sink = g_sink + expected[0].position[0];
+    }
+    report(name + "/quaternion", 1, frames * vcount, get_time() - start);
+
+    // the palette is rebuilt every frame, just like Model::calculate_vertices()
+    std::vector<float> palette(skin.joint_count * PaletteMatrixSize);
+    const size_t stride = pose_stride(skin.joint_count);
+
+    const SIMDLevel level = simd_level();
+    for(int l=SIMDScalar; l<=supported_simd_level(); ++l) {
+        const std::string level_name(simd_level_name(simd_level(static_cast<SIMDLevel>(l))));
+
+        start = get_time();
+        for(size_t i=0; i<frames; ++i) {
+            pose_palette(&skin.pose[0], stride, skin.joint_count, &palette[0]);
+            skin_vertices(&palette[0], &skin.skin_weights[0], &skin.skin_counts[0], vcount, &skinned[0]);
+            g_sink = g_sink + skinned[0].position[0];
+        }
+        report(name + "/palette/" + level_name, 1, frames * vcount, get_time() - start);
+
+        // both paths should land in the same place
+        float error = 0.0f;
+        for(size_t i=0; i<vcount; ++i) {
+            for(int k=0; k<3; ++k) {
+                error = std::max(error, std::fabs(skinned[i].position[k] - expected[i].position[k]));
+            }
+        }
+        if(error > 0.01f) {
+            std::cerr << name << "/palette/" << level_name << " is off by up to " << error << std::endl;
+        }
+    }
+    simd_level(level);
+}
+
+}
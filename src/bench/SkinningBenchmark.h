@@ -0,0 +1,32 @@
+#if !defined __SKINNINGBENCHMARK_H__
+#define __SKINNINGBENCHMARK_H__
+
+#include "Benchmark.h"
+
+namespace energonsoftware {
+
+// skins the monster models in the bind pose, comparing the per-weight
+// quaternion path with the matrix palette kernels at every SIMD level
+class SkinningBenchmark : public Benchmark
+{
+public:
+    enum
+    {
+        // vertices skinned per variant
+        Vertices = 2000000
+    };
+
+public:
+    SkinningBenchmark();
+    virtual ~SkinningBenchmark() throw();
+
+public:
+    virtual void run();
+
+private:
+    void run_model(const std::string& name);
+};
+
+}
+
+#endif
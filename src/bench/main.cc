@@ -0,0 +1,126 @@
+#include "src/pch.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include "AllocatorBenchmark.h"
+#include "CullingBenchmark.h"
+#include "MathBenchmark.h"
+#include "MeshBenchmark.h"
+#include "SceneUpdateBenchmark.h"
+#include "SkinningBenchmark.h"
+#include "src/core/math/simd_util.h"
+
+void print_help()
+{
+    std::cerr << "Usage: bench [--json <file>] [benchmark ...]" << std::endl << std::endl
+        << "Runs every benchmark if none are given." << std::endl << std::endl
+        << "Options:" << std::endl
+        << "\t--json <file>     also write the results to file as JSON" << std::endl << std::endl
+        << "Benchmarks:" << std::endl
+        << "\tallocator         contended stack allocation, 1 to 16 threads" << std::endl
+        << "\tculling           scene graph frustum culling, 1k to 100k renderables" << std::endl
+        << "\tmath              vector, matrix, quaternion, plane and AABB kernels" << std::endl
+        << "\tmesh              load-time welding and edge adjacency, models and synthetic grids" << std::endl
+        << "\tscene_update      parallel physical simulation, 1 to N cores" << std::endl
+        << "\tskinning          quaternion vs. matrix palette skinning of the monster models" << std::endl;
+}
+
+// escapes the few characters benchmark and variant names could contain
+std::string json_string(const std::string& value)
+{
+    std::string escaped("\"");
+    BOOST_FOREACH(char ch, value) {
+        if(ch == '"' || ch == '\\') {
+            escaped += '\\';
+        }
+        escaped += ch;
+    }
+    return escaped + "\"";
+}
+
+bool write_json(const std::string& filename, const std::vector<boost::shared_ptr<energonsoftware::Benchmark> >& benchmarks)
+{
+    std::ofstream out(filename.c_str());
+    if(!out) {
+        std::cerr << "Could not open " << filename << " for writing!" << std::endl;
+        return false;
+    }
+
+    // the build settings, so runs from sse and scalar builds can be told apart
+    out << "{" << std::endl
+#if defined USE_SSE
+        << "  \"sse\": true," << std::endl
+#else
+        << "  \"sse\": false," << std::endl
+#endif
+#if defined NDEBUG
+        << "  \"release\": true," << std::endl
+#else
+        << "  \"release\": false," << std::endl
+#endif
+        << "  \"simd\": " << json_string(energonsoftware::simd_level_name(energonsoftware::supported_simd_level())) << "," << std::endl
+        << "  \"results\": [";
+
+    out << std::setprecision(9);
+
+    bool first = true;
+    BOOST_FOREACH(boost::shared_ptr<energonsoftware::Benchmark> benchmark, benchmarks) {
+        BOOST_FOREACH(const energonsoftware::Benchmark::Result& result, benchmark->results()) {
+            out << (first ? "" : ",") << std::endl
+                << "    { \"benchmark\": " << json_string(benchmark->name())
+                << ", \"variant\": " << json_string(result.variant)
+                << ", \"threads\": " << result.threads
+                << ", \"operations\": " << result.operations
+                << ", \"seconds\": " << result.seconds
+                << ", \"ops_per_second\": " << result.operations_per_second()
+                << ", \"ns_per_op\": " << ((result.seconds * 1000000000.0) / std::max(result.operations, static_cast<size_t>(1)))
+                << " }";
+            first = false;
+        }
+    }
+
+    out << std::endl << "  ]" << std::endl << "}" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<boost::shared_ptr<energonsoftware::Benchmark> > benchmarks;
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::AllocatorBenchmark()));
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::CullingBenchmark()));
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::MathBenchmark()));
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::MeshBenchmark()));
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::SceneUpdateBenchmark()));
+    benchmarks.push_back(boost::shared_ptr<energonsoftware::Benchmark>(new energonsoftware::SkinningBenchmark()));
+
+    std::string json;
+    std::set<std::string> selected;
+    for(int i=1; i<argc; ++i) {
+        const std::string arg(argv[i]);
+        if(arg == "-h" || arg == "--help") {
+            print_help();
+            return 0;
+        } else if(arg == "--json") {
+            if(++i >= argc) {
+                print_help();
+                return 1;
+            }
+            json = argv[i];
+            continue;
+        }
+        selected.insert(arg);
+    }
+
+    BOOST_FOREACH(boost::shared_ptr<energonsoftware::Benchmark> benchmark, benchmarks) {
+        if(selected.empty() || selected.find(benchmark->name()) != selected.end()) {
+            benchmark->run();
+        }
+    }
+
+    if(!json.empty() && !write_json(json, benchmarks)) {
+        return 1;
+    }
+
+    return 0;
+}
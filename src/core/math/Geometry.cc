@@ -137,11 +137,6 @@ void Edge::destroy_array(Edge* const edges, size_t count, MemoryAllocator* const
     operator delete[](edges, 16, *allocator);
 }*/
 
-Edge::Edge()
-    : v1(-1), v2(-1), t1(-1), t2(-1)
-{
-}
-
 std::string Edge::str() const
 {
     std::stringstream ss;
@@ -217,33 +212,499 @@ void compute_tangents(boost::shared_array<Triangle> triangles, size_t triangle_c
     }
 }
 
+// weld cells are twice the weld distance wide, so a vertex can only
+// match vertices in its own cell or the neighbors on its nearer side of each axis
+static const float WeldCellScale = 0.5f / std::sqrt(WeldDistanceSquared);
+
+static inline void weld_cells(float value, int& cell, int& neighbor)
+{
+    const float scaled = value * WeldCellScale;
+    const float floored = std::floor(scaled);
+    cell = static_cast<int>(floored);
+    neighbor = (scaled - floored) < 0.5f ? cell - 1 : cell + 1;
+}
+
+static inline size_t weld_hash(int x, int y, int z)
+{
+    return static_cast<size_t>((static_cast<unsigned int>(x) * 73856093u) ^ (static_cast<unsigned int>(y) * 19349663u) ^ (static_cast<unsigned int>(z) * 83492791u));
+}
+
+size_t weld_vertices(Vertex* const vertices, size_t vertex_count, Triangle* const triangles, size_t triangle_count)
+{
+    if(0 == vertex_count) {
+        return 0;
+    }
+
+    // the surviving vertices are hashed by position cell
+    // NOTE: buckets are chained through next rather than allocating nodes
+    size_t bucket_count = 1;
+    while(bucket_count < vertex_count * 2) {
+        bucket_count <<= 1;
+    }
+    std::vector<int> buckets(bucket_count, -1);
+    std::vector<int> next(vertex_count, -1);
+
+    // old vertex index -> welded vertex index
+    std::vector<int> remap(vertex_count, -1);
+
+    // welded vertex index -> old vertex index
+    std::vector<int> survivors;
+    survivors.reserve(vertex_count);
+
+    for(size_t i=0; i<vertex_count; ++i) {
+        const Vertex& vertex(vertices[i]);
+
+        int cells[3][2];
+        weld_cells(vertex.position.x(), cells[0][0], cells[0][1]);
+        weld_cells(vertex.position.y(), cells[1][0], cells[1][1]);
+        weld_cells(vertex.position.z(), cells[2][0], cells[2][1]);
+
+        int match = -1;
+        for(int n=0; n<8 && match < 0; ++n) {
+            const size_t bucket = weld_hash(cells[0][n & 1], cells[1][(n >> 1) & 1], cells[2][(n >> 2) & 1]) & (bucket_count - 1);
+            for(int j=buckets[bucket]; j >= 0; j=next[j]) {
+                const Vertex& other(vertices[survivors[j]]);
+                if(vertex.position.distance_squared(other.position) < WeldDistanceSquared
+                    && vertex.texture_coords.distance_squared(other.texture_coords) < WeldDistanceSquared)
+                {
+                    match = j;
+                    break;
+                }
+            }
+        }
+
+        if(match >= 0) {
+            remap[i] = match;
+            continue;
+        }
+
+        const int index = static_cast<int>(survivors.size());
+        survivors.push_back(static_cast<int>(i));
+        remap[i] = index;
+
+        const size_t bucket = weld_hash(cells[0][0], cells[1][0], cells[2][0]) & (bucket_count - 1);
+        next[index] = buckets[bucket];
+        buckets[bucket] = index;
+    }
+
+    if(survivors.size() == vertex_count) {
+        return vertex_count;
+    }
+
+    // compact the vertices in place (survivors are in order, so j never passes i)
+    for(size_t j=0; j<survivors.size(); ++j) {
+        if(static_cast<size_t>(survivors[j]) != j) {
+            vertices[j] = vertices[survivors[j]];
+        }
+        vertices[j].index = static_cast<int>(j);
+    }
+
+    // and then remap the triangles in a single pass
+    for(size_t i=0; i<triangle_count; ++i) {
+        Triangle& triangle(triangles[i]);
+        triangle.v1 = remap[triangle.v1];
+        triangle.v2 = remap[triangle.v2];
+        triangle.v3 = remap[triangle.v3];
+    }
+
+    return survivors.size();
+}
+
+// an open-addressed edge hash slot, keyed on the edge's (v1, v2)
+struct EdgeSlot
+{
+    int v1, v2;
+
+    // the first edge with this key, the rest are chained from it
+    int edge;
+};
+
+static inline size_t edge_hash(int v1, int v2)
+{
+    return static_cast<size_t>((static_cast<unsigned int>(v1) * 73856093u) ^ (static_cast<unsigned int>(v2) * 19349663u));
+}
+
+// finds the slot for an edge key, which is empty (edge < 0) if the key isn't in the table
+static inline EdgeSlot& find_edge_slot(std::vector<EdgeSlot>& slots, int v1, int v2)
+{
+    const size_t mask = slots.size() - 1;
+    for(size_t i=edge_hash(v1, v2) & mask; ; i=(i + 1) & mask) {
+        EdgeSlot& slot(slots[i]);
+        if(slot.edge < 0 || (slot.v1 == v1 && slot.v2 == v2)) {
+            return slot;
+        }
+    }
+}
+
+static inline void add_edge(std::vector<Edge>& edges, std::vector<int>& next, EdgeSlot& slot, int v1, int v2, int t)
+{
+    const Edge edge = { v1, v2, t, -1 };
+
+    // edges with the same key are chained newest first
+    const int index = static_cast<int>(edges.size());
+    edges.push_back(edge);
+    next.push_back(slot.edge);
+
+    slot.v1 = v1;
+    slot.v2 = v2;
+    slot.edge = index;
+}
+
+static inline void match_edge(std::vector<Edge>& edges, std::vector<int>& next, std::vector<EdgeSlot>& slots, int v1, int v2, int t)
+{
+    EdgeSlot& slot(find_edge_slot(slots, v1, v2));
+
+    // the oldest unmatched edge gets the triangle
+    int match = -1;
+    for(int i=slot.edge; i >= 0; i=next[i]) {
+        if(edges[i].t2 < 0) {
+            match = i;
+        }
+    }
+
+    if(match >= 0) {
+        edges[match].t2 = t;
+        return;
+    }
+
+    // didn't find a match, so this is a one-winged edge
+    // TODO: not sure if I'm setting the v1/v2 properties correctly
+    add_edge(edges, next, slot, v1, v2, t);
+}
+
+void compute_edges(const Triangle* const triangles, size_t triangle_count, std::vector<Edge>& edges)
+{
+    edges.clear();
+    if(0 == triangle_count) {
+        return;
+    }
+
+    // every triangle edge could be unique, keep the table at most 3/4 full
+    size_t slot_count = 1;
+    while(slot_count < triangle_count * 4) {
+        slot_count <<= 1;
+    }
+    const EdgeSlot empty = { -1, -1, -1 };
+    std::vector<EdgeSlot> slots(slot_count, empty);
+
+    // the edge chains, parallel to edges
+    std::vector<int> next;
+
+    // most edges are shared by two triangles
+    edges.reserve((triangle_count * 3) / 2 + 1);
+    next.reserve(edges.capacity());
+
+    // edges that run forwards in their triangle's winding
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        const int t = static_cast<int>(i);
+
+        if(triangle.v1 < triangle.v2) {
+            add_edge(edges, next, find_edge_slot(slots, triangle.v1, triangle.v2), triangle.v1, triangle.v2, t);
+        }
+
+        if(triangle.v2 < triangle.v3) {
+            add_edge(edges, next, find_edge_slot(slots, triangle.v2, triangle.v3), triangle.v2, triangle.v3, t);
+        }
+
+        if(triangle.v3 < triangle.v1) {
+            add_edge(edges, next, find_edge_slot(slots, triangle.v3, triangle.v1), triangle.v3, triangle.v1, t);
+        }
+    }
+
+    // and then match up the edges that run backwards
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        const int t = static_cast<int>(i);
+
+        if(triangle.v1 > triangle.v2) {
+            match_edge(edges, next, slots, triangle.v2, triangle.v1, t);
+        }
+
+        if(triangle.v2 > triangle.v3) {
+            match_edge(edges, next, slots, triangle.v3, triangle.v2, t);
+        }
+
+        if(triangle.v3 > triangle.v1) {
+            match_edge(edges, next, slots, triangle.v1, triangle.v3, t);
+        }
+    }
+}
+
+size_t vertex_cache_misses(const Triangle* const triangles, size_t triangle_count, size_t vertex_count, size_t cache_size)
+{
+    // a vertex is still in the FIFO if fewer than cache_size misses came after its own
+    // NOTE: stamps are 1-based so 0 means the vertex was never transformed
+    std::vector<size_t> stamps(vertex_count, 0);
+
+    size_t misses = 0;
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        const int v[3] = { triangle.v1, triangle.v2, triangle.v3 };
+        for(int j=0; j<3; ++j) {
+            size_t& stamp(stamps[v[j]]);
+            if(0 == stamp || misses - stamp >= cache_size) {
+                stamp = ++misses;
+            }
+        }
+    }
+    return misses;
+}
+
+// the LRU cache the scores model, bigger than any real FIFO
+// so that triangles a few steps away still pull towards the cache
+static const int ForsythCacheSize = 32;
+
+// the valence boost levels off well before this
+static const int ForsythMaxValence = 64;
+
+static float forsyth_vertex_score(const float* const cache_scores, const float* const valence_scores, int cache_position, int active_triangles)
+{
+    if(0 == active_triangles) {
+        // nothing left to draw with it
+        return -1.0f;
+    }
+
+    const float score = cache_position < 0 ? 0.0f : cache_scores[cache_position];
+    return score + valence_scores[std::min(active_triangles, ForsythMaxValence - 1)];
+}
+
+void optimize_vertex_cache(Triangle* const triangles, size_t triangle_count, size_t vertex_count)
+{
+    if(triangle_count < 2) {
+        return;
+    }
+
+    // score tables, see the paper for where the constants come from
+    float cache_scores[ForsythCacheSize];
+    for(int i=0; i<ForsythCacheSize; ++i) {
+        // the last triangle's vertices get a fixed score so that
+        // triangles sharing just one edge with it aren't favored too much
+        cache_scores[i] = i < 3 ? 0.75f : std::pow(1.0f - ((i - 3) / static_cast<float>(ForsythCacheSize - 3)), 1.5f);
+    }
+
+    // boost vertices with few triangles left to finish them off
+    float valence_scores[ForsythMaxValence];
+    valence_scores[0] = 0.0f;
+    for(int i=1; i<ForsythMaxValence; ++i) {
+        valence_scores[i] = 2.0f / std::sqrt(static_cast<float>(i));
+    }
+
+    // the triangles still to draw that use each vertex, packed into one array
+    std::vector<int> active(vertex_count, 0);
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        active[triangle.v1]++;
+        active[triangle.v2]++;
+        active[triangle.v3]++;
+    }
+
+    std::vector<int> offsets(vertex_count + 1, 0);
+    for(size_t i=0; i<vertex_count; ++i) {
+        offsets[i + 1] = offsets[i] + active[i];
+    }
+
+    std::vector<int> adjacency(triangle_count * 3);
+    {
+        std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for(size_t i=0; i<triangle_count; ++i) {
+            const Triangle& triangle(triangles[i]);
+            adjacency[fill[triangle.v1]++] = static_cast<int>(i);
+            adjacency[fill[triangle.v2]++] = static_cast<int>(i);
+            adjacency[fill[triangle.v3]++] = static_cast<int>(i);
+        }
+    }
+
+    std::vector<int> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for(size_t i=0; i<vertex_count; ++i) {
+        vertex_scores[i] = forsyth_vertex_score(cache_scores, valence_scores, -1, active[i]);
+    }
+
+    int best = -1;
+    float best_score = -1.0f;
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        const float score = vertex_scores[triangle.v1] + vertex_scores[triangle.v2] + vertex_scores[triangle.v3];
+        if(score > best_score) {
+            best = static_cast<int>(i);
+            best_score = score;
+        }
+    }
+
+    std::vector<int> order;
+    order.reserve(triangle_count);
+    std::vector<bool> added(triangle_count, false);
+
+    // the cache, plus room for the vertices the next triangle pushes out
+    int cache[ForsythCacheSize + 3];
+    int cache_count = 0;
+
+    size_t next_unadded = 0;
+    while(order.size() < triangle_count) {
+        if(best < 0) {
+            // nothing in the cache has triangles left, so rather than
+            // rescoring every triangle just carry on with the next one in the original order
+            while(added[next_unadded]) {
+                next_unadded++;
+            }
+            best = static_cast<int>(next_unadded);
+        }
+
+        added[best] = true;
+        order.push_back(best);
+
+        const Triangle& triangle(triangles[best]);
+        const int v[3] = { triangle.v1, triangle.v2, triangle.v3 };
+
+        // take the triangle off of its vertices
+        for(int j=0; j<3; ++j) {
+            int* const begin = &adjacency[0] + offsets[v[j]];
+            int* const end = begin + active[v[j]];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            active[v[j]]--;
+        }
+
+        // and move its vertices to the front of the cache
+        int updated[ForsythCacheSize + 3];
+        int updated_count = 0;
+        for(int j=0; j<3; ++j) {
+            if(std::find(updated, updated + updated_count, v[j]) == updated + updated_count) {
+                updated[updated_count++] = v[j];
+            }
+        }
+        for(int j=0; j<cache_count; ++j) {
+            if(cache[j] != v[0] && cache[j] != v[1] && cache[j] != v[2]) {
+                updated[updated_count++] = cache[j];
+            }
+        }
+
+        // rescore everything that was in the cache (including anything pushed out of it)
+        cache_count = std::min(updated_count, ForsythCacheSize);
+        for(int j=0; j<updated_count; ++j) {
+            const int vertex = updated[j];
+            cache_positions[vertex] = j < ForsythCacheSize ? j : -1;
+            vertex_scores[vertex] = forsyth_vertex_score(cache_scores, valence_scores, cache_positions[vertex], active[vertex]);
+            if(j < ForsythCacheSize) {
+                cache[j] = vertex;
+            }
+        }
+
+        // the next triangle is the best one touching those vertices
+        best = -1;
+        best_score = -1.0f;
+        for(int j=0; j<updated_count; ++j) {
+            const int vertex = updated[j];
+            for(int k=offsets[vertex]; k<offsets[vertex] + active[vertex]; ++k) {
+                const Triangle& candidate(triangles[adjacency[k]]);
+                const float score = vertex_scores[candidate.v1] + vertex_scores[candidate.v2] + vertex_scores[candidate.v3];
+                if(score > best_score) {
+                    best = adjacency[k];
+                    best_score = score;
+                }
+            }
+        }
+    }
+
+    const std::vector<Triangle> original(triangles, triangles + triangle_count);
+    for(size_t i=0; i<triangle_count; ++i) {
+        triangles[i] = original[order[i]];
+        triangles[i].index = static_cast<int>(i);
+    }
+}
+
+static inline int fetch_index(std::vector<int>& remap, int& next, int vertex)
+{
+    if(remap[vertex] < 0) {
+        remap[vertex] = next++;
+    }
+    return remap[vertex];
+}
+
+void optimize_vertex_fetch(Vertex* const vertices, size_t vertex_count, Triangle* const triangles, size_t triangle_count)
+{
+    // old vertex index -> new vertex index
+    std::vector<int> remap(vertex_count, -1);
+
+    int next = 0;
+    for(size_t i=0; i<triangle_count; ++i) {
+        Triangle& triangle(triangles[i]);
+        triangle.v1 = fetch_index(remap, next, triangle.v1);
+        triangle.v2 = fetch_index(remap, next, triangle.v2);
+        triangle.v3 = fetch_index(remap, next, triangle.v3);
+    }
+
+    // unused vertices keep their order at the end
+    for(size_t i=0; i<vertex_count; ++i) {
+        fetch_index(remap, next, static_cast<int>(i));
+    }
+
+    const std::vector<Vertex> original(vertices, vertices + vertex_count);
+    for(size_t i=0; i<vertex_count; ++i) {
+        Vertex& vertex(vertices[remap[i]]);
+        vertex = original[i];
+        vertex.index = remap[i];
+    }
+}
+
 void Geometry::destroy(Geometry* const geometry, MemoryAllocator* const allocator)
 {
     geometry->~Geometry();
     operator delete(geometry, *allocator);
 }
 
-Geometry::Geometry(size_t vertex_count, MemoryAllocator& allocator)
-    : _vertex_count(0), _vertex_buffer_size(0), _normal_buffer_size(0), _tangent_buffer_size(0), _texture_buffer_size(0)
+static VertexLayout packed_vertex_layout()
+{
+    VertexLayout layout;
+    layout.add("vertex", VertexLayout::Float, 3)
+        .add("normal", VertexLayout::Int2_10_10_10, 4, true)
+        .add("tangent", VertexLayout::Int2_10_10_10, 4, true)
+        .add("texture_coord", VertexLayout::HalfFloat, 2)
+        .stride(sizeof(PackedVertex));
+    return layout;
+}
+
+static VertexLayout static_vertex_layout()
+{
+    VertexLayout layout;
+    layout.add("vertex", VertexLayout::Float, 3)
+        .add("normal", VertexLayout::Int2_10_10_10, 4, true)
+        .add("tangent", VertexLayout::Int2_10_10_10, 4, true)
+        .add("texture_coord", VertexLayout::Float, 2)
+        .stride(sizeof(StaticVertex));
+    return layout;
+}
+
+static const VertexLayout g_packed_vertex_layout(packed_vertex_layout());
+static const VertexLayout g_static_vertex_layout(static_vertex_layout());
+
+const VertexLayout& Geometry::layout(VertexFormat format)
+{
+    return StaticVertices == format ? g_static_vertex_layout : g_packed_vertex_layout;
+}
+
+Geometry::Geometry(size_t vertex_count, MemoryAllocator& allocator, VertexFormat format)
+    : _vertex_format(format), _vertex_count(0), _index_count(0), _index_size(0)
 {
     allocate_buffers(vertex_count, allocator);
 }
 
-Geometry::Geometry(const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator)
-    : _vertex_count(0), _vertex_buffer_size(0), _normal_buffer_size(0), _tangent_buffer_size(0), _texture_buffer_size(0)
+Geometry::Geometry(const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator, VertexFormat format)
+    : _vertex_format(format), _vertex_count(0), _index_count(0), _index_size(0)
 {
     allocate_buffers(vertex_count, allocator);
     copy_vertices(vertices, vertex_count, 0);
 }
 
-Geometry::Geometry(size_t triangle_count, size_t vertex_count, MemoryAllocator& allocator)
-    : _vertex_count(0), _vertex_buffer_size(0), _normal_buffer_size(0), _tangent_buffer_size(0), _texture_buffer_size(0)
+Geometry::Geometry(size_t triangle_count, size_t vertex_count, MemoryAllocator& allocator, VertexFormat format)
+    : _vertex_format(format), _vertex_count(0), _index_count(0), _index_size(0)
 {
     allocate_buffers(triangle_count, vertex_count, allocator);
 }
 
-Geometry::Geometry(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator)
-    : _vertex_count(0), _vertex_buffer_size(0), _normal_buffer_size(0), _tangent_buffer_size(0), _texture_buffer_size(0)
+Geometry::Geometry(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count,
+        MemoryAllocator& allocator, VertexFormat format)
+    : _vertex_format(format), _vertex_count(0), _index_count(0), _index_size(0)
 {
     allocate_buffers(triangle_count, vertex_count, allocator);
     copy_triangles(triangles, triangle_count, vertices, vertex_count, 0);
@@ -258,41 +719,51 @@ void Geometry::allocate_buffers(size_t vertex_count, MemoryAllocator& allocator)
     boost::lock_guard<boost::recursive_mutex> guard(_mutex);
 
     _vertex_count = vertex_count;
+    if(StaticVertices == _vertex_format) {
+        _static_vertex_buffer.reset(new(allocator) StaticVertex[_vertex_count], boost::bind(&MemoryAllocator::release, &allocator, _1));
+    } else {
+        _vertex_buffer.reset(new(allocator) PackedVertex[_vertex_count], boost::bind(&MemoryAllocator::release, &allocator, _1));
+    }
 
-    _vertex_buffer_size = _vertex_count * 3;
-    _vertex_buffer.reset(new(allocator) float[_vertex_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
-
-    _normal_buffer_size = _vertex_count * 3;
-    _normal_buffer.reset(new(allocator) float[_normal_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
     _normal_line_buffer.reset(new(allocator) float[_vertex_count * 2 * 3], boost::bind(&MemoryAllocator::release, &allocator, _1));
-
-    _tangent_buffer_size = _vertex_count * 4;
-    _tangent_buffer.reset(new(allocator) float[_tangent_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
     _tangent_line_buffer.reset(new(allocator) float[_vertex_count * 2 * 3], boost::bind(&MemoryAllocator::release, &allocator, _1));
-
-    _texture_buffer_size = _vertex_count * 2;
-    _texture_buffer.reset(new(allocator) float[_texture_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
 }
 
 void Geometry::allocate_buffers(size_t triangle_count, size_t vertex_count, MemoryAllocator& allocator)
 {
     boost::lock_guard<boost::recursive_mutex> guard(_mutex);
 
-    _vertex_count = triangle_count * 3;
+    allocate_buffers(vertex_count, allocator);
+
+    // short indices halve the index buffer for anything that fits
+    _index_count = triangle_count * 3;
+    _index_size = vertex_count <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+    _index_buffer.reset(new(allocator) unsigned char[index_buffer_size()], boost::bind(&MemoryAllocator::release, &allocator, _1));
+}
 
-    _vertex_buffer_size = _vertex_count * 3;
-    _vertex_buffer.reset(new(allocator) float[_vertex_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
+const void* Geometry::vertex_data() const
+{
+    if(StaticVertices == _vertex_format) {
+        return _static_vertex_buffer.get();
+    }
+    return _vertex_buffer.get();
+}
 
-    _normal_buffer_size = _vertex_count * 3;
-    _normal_buffer.reset(new(allocator) float[_normal_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
-    _normal_line_buffer.reset(new(allocator) float[_vertex_count * 2 * 3], boost::bind(&MemoryAllocator::release, &allocator, _1));
+template<typename T>
+static inline void pack_position_normal_tangent(const Vertex& vertex, T& packed)
+{
+    packed.position[0] = vertex.position.x();
+    packed.position[1] = vertex.position.y();
+    packed.position[2] = vertex.position.z();
 
-    _tangent_buffer_size = _vertex_count * 4;
-    _tangent_buffer.reset(new(allocator) float[_tangent_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
-    _tangent_line_buffer.reset(new(allocator) float[_vertex_count * 2 * 3], boost::bind(&MemoryAllocator::release, &allocator, _1));
+    const Vector3& normal(vertex.normal);
+    packed.normal = pack_snorm_2_10_10_10(normal.x(), normal.y(), normal.z(), 0.0f);
 
-    _texture_buffer_size = _vertex_count * 2;
-    _texture_buffer.reset(new(allocator) float[_tangent_buffer_size], boost::bind(&MemoryAllocator::release, &allocator, _1));
+    // Mathematics for 3D Game Programming and Computer Graphics, section 7.8.3
+    const Vector3& tangent(vertex.tangent);
+    const Vector3& bitangent(normal ^ tangent);
+    packed.tangent = pack_snorm_2_10_10_10(tangent.x(), tangent.y(), tangent.z(),
+        bitangent.opposite_direction(vertex.bitangent) ? -1.0f : 1.0f);
 }
 
 void Geometry::copy_vertices(const Vertex* const vertices, size_t vertex_count, size_t start)
@@ -301,7 +772,7 @@ void Geometry::copy_vertices(const Vertex* const vertices, size_t vertex_count,
 
     // fill the normal/tangent line buffers (for debugging)
     float *nlb = _normal_line_buffer.get(), *tnlb = _tangent_line_buffer.get();
-    for(size_t i=0; i<_vertex_count; ++i) {
+    for(size_t i=0; i<vertex_count; ++i) {
         const Vertex& vertex(vertices[i]);
 
         const size_t idx = (start * 2 * 3) + (i * 2 * 3);
@@ -317,125 +788,72 @@ void Geometry::copy_vertices(const Vertex* const vertices, size_t vertex_count,
         *(tnlb + idx + 2) = p.z(); *(tnlb + idx + 5) = p.z() + t.z();
     }
 
-    // fill the vertex buffers
-    float *va = _vertex_buffer.get(), *na = _normal_buffer.get(), *tna = _tangent_buffer.get(), *ta = _texture_buffer.get();
-    for(size_t i=0; i<_vertex_count; ++i) {
-        const Vertex& vertex(vertices[i]);
-
-        const size_t vidx = (start * 3) + (i * 3);
-        *(va + vidx + 0) = vertex.position.x();
-        *(va + vidx + 1) = vertex.position.y();
-        *(va + vidx + 2) = vertex.position.z();
+    // fill the vertex buffer
+    if(StaticVertices == _vertex_format) {
+        StaticVertex* const vb = _static_vertex_buffer.get() + start;
+        for(size_t i=0; i<vertex_count; ++i) {
+            const Vertex& vertex(vertices[i]);
+            StaticVertex& packed(vb[i]);
 
-        const Vector3& normal(vertex.normal);
-        *(na + vidx + 0) = normal.x();
-        *(na + vidx + 1) = normal.y();
-        *(na + vidx + 2) = normal.z();
+            pack_position_normal_tangent(vertex, packed);
+            packed.texture_coords[0] = vertex.texture_coords.x();
+            packed.texture_coords[1] = vertex.texture_coords.y();
+        }
+        return;
+    }
 
-        const size_t tnidx = (start * 4) + (i * 4);
+    PackedVertex* const vb = _vertex_buffer.get() + start;
+    for(size_t i=0; i<vertex_count; ++i) {
+        const Vertex& vertex(vertices[i]);
+        PackedVertex& packed(vb[i]);
 
-        // Mathematics for 3D Game Programming and Computer Graphics, section 7.8.3
-        const Vector3& tangent(vertex.tangent);
-        const Vector3& bitangent(normal ^ tangent);
-        *(tna + tnidx + 0) = tangent.x();
-        *(tna + tnidx + 1) = tangent.y();
-        *(tna + tnidx + 2) = tangent.z();
-        *(tna + tnidx + 3) = bitangent.opposite_direction(vertex.bitangent) ? -1.0f : 1.0f;
+        pack_position_normal_tangent(vertex, packed);
+        packed.texture_coords[0] = pack_half(vertex.texture_coords.x());
+        packed.texture_coords[1] = pack_half(vertex.texture_coords.y());
+    }
+}
 
-        const size_t tidx = (start * 2) + (i * 2);
-        *(ta + tidx + 0) = vertex.texture_coords.x();
-        *(ta + tidx + 1) = vertex.texture_coords.y();
+template<typename T>
+static void copy_triangle_indices(const Triangle* const triangles, size_t triangle_count, size_t vstart, T* indices)
+{
+    for(size_t i=0; i<triangle_count; ++i) {
+        const Triangle& triangle(triangles[i]);
+        *(indices++) = static_cast<T>(vstart + triangle.v1);
+        *(indices++) = static_cast<T>(vstart + triangle.v2);
+        *(indices++) = static_cast<T>(vstart + triangle.v3);
     }
 }
 
-void Geometry::copy_triangles(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, size_t start)
+void Geometry::copy_indices(const Triangle* const triangles, size_t triangle_count, size_t vstart, size_t istart)
 {
     boost::lock_guard<boost::recursive_mutex> guard(_mutex);
 
-    // fill the normal/tangent line buffers (for debugging)
-    float *nlb = _normal_line_buffer.get(), *tnlb = _tangent_line_buffer.get();
-    for(size_t i=0; i<vertex_count; ++i) {
-        const Vertex& vertex(vertices[i]);
-
-        const size_t idx = (start * 2 * 3) + i * 2 * 3;
-        const Position& p(vertex.position);
-        const Vector3 &n(vertex.normal), &t(vertex.tangent);
-
-        *(nlb + idx + 0) = p.x(); *(nlb + idx + 3) = p.x() + n.x();
-        *(nlb + idx + 1) = p.y(); *(nlb + idx + 4) = p.y() + n.y();
-        *(nlb + idx + 2) = p.z(); *(nlb + idx + 5) = p.z() + n.z();
-
-        *(tnlb + idx + 0) = p.x(); *(tnlb + idx + 3) = p.x() + t.x();
-        *(tnlb + idx + 1) = p.y(); *(tnlb + idx + 4) = p.y() + t.y();
-        *(tnlb + idx + 2) = p.z(); *(tnlb + idx + 5) = p.z() + t.z();
+    assert(istart + (triangle_count * 3) <= _index_count);
+    if(sizeof(uint16_t) == _index_size) {
+        copy_triangle_indices(triangles, triangle_count, vstart, reinterpret_cast<uint16_t*>(_index_buffer.get()) + istart);
+    } else {
+        copy_triangle_indices(triangles, triangle_count, vstart, reinterpret_cast<uint32_t*>(_index_buffer.get()) + istart);
     }
+}
 
-    // fill the vertex buffers
-    float *vb = _vertex_buffer.get(), *nb = _normal_buffer.get(), *tnb = _tangent_buffer.get(), *tb = _texture_buffer.get();
-    for(size_t i=0; i<triangle_count; ++i) {
-        const Triangle& triangle(triangles[i]);
-        const Vertex &v1(vertices[triangle.v1]), &v2(vertices[triangle.v2]), &v3(vertices[triangle.v3]);
-
-        const size_t idx = (start * 3) + (i * 3 * 3);
-
-        *(vb + idx + 0) = v1.position.x();
-        *(vb + idx + 1) = v1.position.y();
-        *(vb + idx + 2) = v1.position.z();
-        *(vb + idx + 3) = v2.position.x();
-        *(vb + idx + 4) = v2.position.y();
-        *(vb + idx + 5) = v2.position.z();
-        *(vb + idx + 6) = v3.position.x();
-        *(vb + idx + 7) = v3.position.y();
-        *(vb + idx + 8) = v3.position.z();
-
-        const Vector3 &n1(v1.normal), &n2(v2.normal), &n3(v3.normal);
-        *(nb + idx + 0) = n1.x();
-        *(nb + idx + 1) = n1.y();
-        *(nb + idx + 2) = n1.z();
-        *(nb + idx + 3) = n2.x();
-        *(nb + idx + 4) = n2.y();
-        *(nb + idx + 5) = n2.z();
-        *(nb + idx + 6) = n3.x();
-        *(nb + idx + 7) = n3.y();
-        *(nb + idx + 8) = n3.z();
-
-        const size_t tnidx = (start * 4) + (i * 3 * 4);
-
-        // Mathematics for 3D Game Programming and Computer Graphics, section 7.8.3
-        const Vector3 &t1(v1.tangent), &t2(v2.tangent), &t3(v3.tangent);
-        const Vector3 b1(n1 ^ t1), b2(n2 ^ t2), b3(n3 ^ t3);
-        *(tnb + tnidx + 0)  = t1.x();
-        *(tnb + tnidx + 1)  = t1.y();
-        *(tnb + tnidx + 2)  = t1.z();
-        *(tnb + tnidx + 3)  = b1.opposite_direction(v1.bitangent) ? -1.0f : 1.0f;
-        *(tnb + tnidx + 4)  = t2.x();
-        *(tnb + tnidx + 5)  = t2.y();
-        *(tnb + tnidx + 6)  = t2.z();
-        *(tnb + tnidx + 7)  = b2.opposite_direction(v2.bitangent) ? -1.0f : 1.0f;
-        *(tnb + tnidx + 8)  = t3.x();
-        *(tnb + tnidx + 9)  = t3.y();
-        *(tnb + tnidx + 10) = t3.z();
-        *(tnb + tnidx + 11) = b3.opposite_direction(v3.bitangent) ? -1.0f : 1.0f;
-
-        const size_t tidx = (start * 2) + (i * 3 * 2);
-
-        *(tb + tidx + 0) = v1.texture_coords.x();
-        *(tb + tidx + 1) = v1.texture_coords.y();
-        *(tb + tidx + 2) = v2.texture_coords.x();
-        *(tb + tidx + 3) = v2.texture_coords.y();
-        *(tb + tidx + 4) = v3.texture_coords.x();
-        *(tb + tidx + 5) = v3.texture_coords.y();
-    }
+void Geometry::copy_triangles(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, size_t vstart, size_t istart)
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    copy_vertices(vertices, vertex_count, vstart);
+    copy_indices(triangles, triangle_count, vstart, istart);
 }
 
 std::string Geometry::str() const
 {
     std::stringstream ss;
-    ss << "Geometry vertex_count=" << _vertex_count << "\nVertices (" << _vertex_buffer_size << "):\n";
-    for(size_t i=0; i<_vertex_buffer_size; i+=3) {
-        ss << "(" << _vertex_buffer[i+0]
-            << ", " << _vertex_buffer[i+1]
-            << ", " << _vertex_buffer[i+2] << "), ";
+    ss << "Geometry vertex_count=" << _vertex_count << ", index_count=" << _index_count << "\nVertices (" << vertex_buffer_size() << " bytes):\n";
+    const float* position = reinterpret_cast<const float*>(vertex_data());
+    const size_t stride = vertex_layout().stride() / sizeof(float);
+    for(size_t i=0; i<_vertex_count; ++i, position+=stride) {
+        ss << "(" << position[0]
+            << ", " << position[1]
+            << ", " << position[2] << "), ";
     }
     return ss.str();
 }
@@ -2,6 +2,7 @@
 #define __GEOMETRY_H__
 
 #include "src/core/math/Vector.h"
+#include "src/core/math/VertexLayout.h"
 
 namespace energonsoftware {
 
@@ -61,28 +62,108 @@ struct Edge
     static Edge* create_array(size_t count, MemoryAllocator& allocator);
     static void destroy_array(Edge* const edge, size_t count, MemoryAllocator* const allocator);*/
 
+    // NOTE: this is POD so that edge arrays stay compact,
+    // edges are (v1, v2) in t1's winding, and t2 is -1 for one-winged edges
     int v1, v2;
     int t1, t2;
 
-    Edge();
-    virtual ~Edge() throw() {}
-
     std::string str() const;
 };
 
 void compute_tangents(boost::shared_array<Triangle> triangles, size_t triange_count, boost::shared_array<Vertex> vertices, size_t vertex_count, MemoryAllocator& allocator, bool smooth=false);
 
+// vertices closer than this (squared) in both position and texture coordinates are welded
+const float WeldDistanceSquared = 0.001f;
+
+// welds matching vertices together, compacting the vertex array in place
+// and pointing the triangles at the surviving vertices, returns the new vertex count
+// NOTE: this assumes each vertex index is its position in the array
+size_t weld_vertices(Vertex* const vertices, size_t vertex_count, Triangle* const triangles, size_t triangle_count);
+
+// builds the edge adjacency (for shadow silhouettes) of a set of triangles
+// Mathematics for 3D Game Programming and Computer Graphics, section 10.3.3
+void compute_edges(const Triangle* const triangles, size_t triangle_count, std::vector<Edge>& edges);
+
+// the FIFO post-transform vertex cache size that the ACMR is measured against
+const size_t PostTransformCacheSize = 16;
+
+// how many vertices a FIFO post-transform cache of cache_size
+// misses drawing the triangles in order (divide by the triangle count for the ACMR)
+size_t vertex_cache_misses(const Triangle* const triangles, size_t triangle_count, size_t vertex_count, size_t cache_size=PostTransformCacheSize);
+
+// reorders the triangles to make better use of the post-transform vertex cache
+// Tom Forsyth, Linear-Speed Vertex Cache Optimisation
+void optimize_vertex_cache(Triangle* const triangles, size_t triangle_count, size_t vertex_count);
+
+// reorders the vertices into the order the triangles first use them
+// (so fetching them walks forward through memory) and remaps the triangles
+// NOTE: this assumes each vertex index is its position in the array
+void optimize_vertex_fetch(Vertex* const vertices, size_t vertex_count, Triangle* const triangles, size_t triangle_count);
+
+// the interleaved vertex format Geometry emits, see Geometry::layout()
+struct PackedVertex
+{
+    float position[3];
+
+    // signed normalized 10:10:10:2, the tangent's w is the bitangent sign
+    uint32_t normal, tangent;
+
+    // half floats
+    uint16_t texture_coords[2];
+};
+
+// the interleaved vertex format Geometry emits for static map geometry
+// NOTE: map texture coordinates tile well outside of [0, 1],
+// where half floats don't have the precision for them
+struct StaticVertex
+{
+    float position[3];
+
+    // signed normalized 10:10:10:2, the tangent's w is the bitangent sign
+    uint32_t normal, tangent;
+
+    float texture_coords[2];
+};
+
+/*
+Vertex buffers ready to upload
+
+The vertices are packed into a single interleaved buffer
+(see PackedVertex) that's half the size of the float arrays
+the Vertex attributes would take, so it's bound with one layout
+and animated models upload half as much every frame.
+Static map geometry uses StaticVertex instead, which keeps
+the texture coordinates as full floats.
+
+Geometry built from triangles is indexed: the vertex buffer holds each
+unique vertex once and the triangles live in a separate index buffer,
+which uses 16-bit indices when every vertex can be reached with them.
+Geometry built from just vertices isn't indexed (index_count() is 0).
+*/
 class Geometry
 {
 public:
     static void destroy(Geometry* const weight, MemoryAllocator* const allocator);
 
+    enum VertexFormat
+    {
+        // PackedVertex, for model meshes
+        PackedVertices,
+
+        // StaticVertex, for map geometry
+        StaticVertices
+    };
+
+    // the layout of a vertex buffer in the given format
+    static const VertexLayout& layout(VertexFormat format=PackedVertices);
+
 public:
-    explicit Geometry(size_t vertex_count, MemoryAllocator& allocator);
-    Geometry(const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator);
+    explicit Geometry(size_t vertex_count, MemoryAllocator& allocator, VertexFormat format=PackedVertices);
+    Geometry(const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator, VertexFormat format=PackedVertices);
 
-    Geometry(size_t triangle_count, size_t vertex_count, MemoryAllocator& allocator);
-    Geometry(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, MemoryAllocator& allocator);
+    Geometry(size_t triangle_count, size_t vertex_count, MemoryAllocator& allocator, VertexFormat format=PackedVertices);
+    Geometry(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count,
+        MemoryAllocator& allocator, VertexFormat format=PackedVertices);
 
     virtual ~Geometry() throw();
 
@@ -91,25 +172,43 @@ public:
 
     size_t vertex_count() const { return _vertex_count; }
 
+    VertexFormat vertex_format() const { return _vertex_format; }
+    const VertexLayout& vertex_layout() const { return layout(_vertex_format); }
+
+    size_t index_count() const { return _index_count; }
+    bool is_indexed() const { return _index_count > 0; }
+
+    // bytes per index, 2 or 4 (0 if the geometry isn't indexed)
+    size_t index_size() const { return _index_size; }
+
     // NOTE: must lock before using these!
-    size_t vertex_buffer_size() const { return _vertex_buffer_size; }
-    boost::shared_array<float> vertex_buffer() const { return _vertex_buffer; }
 
-    size_t normal_buffer_size() const { return _normal_buffer_size; }
-    boost::shared_array<float> normal_buffer() const { return _normal_buffer; }
+    // in bytes
+    size_t vertex_buffer_size() const { return _vertex_count * vertex_layout().stride(); }
 
-    size_t tangent_buffer_size() const { return _tangent_buffer_size; }
-    boost::shared_array<float> tangent_buffer() const { return _tangent_buffer; }
+    // whichever of the vertex buffers the format uses, for uploading
+    const void* vertex_data() const;
 
-    size_t texture_buffer_size() const { return _texture_buffer_size; }
-    boost::shared_array<float> texture_buffer() const { return _texture_buffer; }
+    // NOTE: only the buffer for the geometry's vertex format is allocated
+    boost::shared_array<PackedVertex> vertex_buffer() const { return _vertex_buffer; }
+    boost::shared_array<StaticVertex> static_vertex_buffer() const { return _static_vertex_buffer; }
+
+    // in bytes
+    size_t index_buffer_size() const { return _index_count * _index_size; }
+    boost::shared_array<unsigned char> index_buffer() const { return _index_buffer; }
 
     // for debugging
     boost::shared_array<float> normal_line_buffer() const { return _normal_line_buffer; }
     boost::shared_array<float> tangent_line_buffer() const { return _tangent_line_buffer; }
 
+    // start is the first vertex to write
     void copy_vertices(const Vertex* const vertices, size_t vertex_count, size_t start=0);
-    void copy_triangles(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, size_t start=0);
+
+    // vstart is added to each triangle's vertex indices, istart is the first index to write
+    void copy_indices(const Triangle* const triangles, size_t triangle_count, size_t vstart=0, size_t istart=0);
+
+    // copies both the vertices and the triangles
+    void copy_triangles(const Triangle* const triangles, size_t triangle_count, const Vertex* const vertices, size_t vertex_count, size_t vstart=0, size_t istart=0);
 
     std::string str() const;
 
@@ -120,19 +219,14 @@ private:
 private:
     boost::recursive_mutex _mutex;
 
-    size_t _vertex_count;
+    VertexFormat _vertex_format;
 
-    size_t _vertex_buffer_size;
-    boost::shared_array<float> _vertex_buffer;
-
-    size_t _normal_buffer_size;
-    boost::shared_array<float> _normal_buffer;
-
-    size_t _tangent_buffer_size;
-    boost::shared_array<float> _tangent_buffer;
+    size_t _vertex_count;
+    boost::shared_array<PackedVertex> _vertex_buffer;
+    boost::shared_array<StaticVertex> _static_vertex_buffer;
 
-    size_t _texture_buffer_size;
-    boost::shared_array<float> _texture_buffer;
+    size_t _index_count, _index_size;
+    boost::shared_array<unsigned char> _index_buffer;
 
     // debugging stuffs
     boost::shared_array<float> _normal_line_buffer;
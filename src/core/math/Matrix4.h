@@ -3,6 +3,7 @@
 
 #include "Matrix3.h"
 #include "Vector.h"
+#include "simd_util.h"
 
 namespace energonsoftware {
 
@@ -249,22 +250,7 @@ public:
     Matrix4 operator*(const Matrix4& rhs) const
     {
         Matrix4 n;
-        n._m[0]  = _m[0]  * rhs._m[0] + _m[1]  * rhs._m[4] + _m[2]  * rhs._m[8]  + _m[3]  * rhs._m[12];
-        n._m[1]  = _m[0]  * rhs._m[1] + _m[1]  * rhs._m[5] + _m[2]  * rhs._m[9]  + _m[3]  * rhs._m[13];
-        n._m[2]  = _m[0]  * rhs._m[2] + _m[1]  * rhs._m[6] + _m[2]  * rhs._m[10] + _m[3]  * rhs._m[14];
-        n._m[3]  = _m[0]  * rhs._m[3] + _m[1]  * rhs._m[7] + _m[2]  * rhs._m[11] + _m[3]  * rhs._m[15];
-        n._m[4]  = _m[4]  * rhs._m[0] + _m[5]  * rhs._m[4] + _m[6]  * rhs._m[8]  + _m[7]  * rhs._m[12];
-        n._m[5]  = _m[4]  * rhs._m[1] + _m[5]  * rhs._m[5] + _m[6]  * rhs._m[9]  + _m[7]  * rhs._m[13];
-        n._m[6]  = _m[4]  * rhs._m[2] + _m[5]  * rhs._m[6] + _m[6]  * rhs._m[10] + _m[7]  * rhs._m[14];
-        n._m[7]  = _m[4]  * rhs._m[3] + _m[5]  * rhs._m[7] + _m[6]  * rhs._m[11] + _m[7]  * rhs._m[15];
-        n._m[8]  = _m[8]  * rhs._m[0] + _m[9]  * rhs._m[4] + _m[10] * rhs._m[8]  + _m[11] * rhs._m[12];
-        n._m[9]  = _m[8]  * rhs._m[1] + _m[9]  * rhs._m[5] + _m[10] * rhs._m[9]  + _m[11] * rhs._m[13];
-        n._m[10] = _m[8]  * rhs._m[2] + _m[9]  * rhs._m[6] + _m[10] * rhs._m[10] + _m[11] * rhs._m[14];
-        n._m[11] = _m[8]  * rhs._m[3] + _m[9]  * rhs._m[7] + _m[10] * rhs._m[11] + _m[11] * rhs._m[15];
-        n._m[12] = _m[12] * rhs._m[0] + _m[13] * rhs._m[4] + _m[14] * rhs._m[8]  + _m[15] * rhs._m[12];
-        n._m[13] = _m[12] * rhs._m[1] + _m[13] * rhs._m[5] + _m[14] * rhs._m[9]  + _m[15] * rhs._m[13];
-        n._m[14] = _m[12] * rhs._m[2] + _m[13] * rhs._m[6] + _m[14] * rhs._m[10] + _m[15] * rhs._m[14];
-        n._m[15] = _m[12] * rhs._m[3] + _m[13] * rhs._m[7] + _m[14] * rhs._m[11] + _m[15] * rhs._m[15];
+        matrix4_multiply(_m, rhs._m, n._m);
         return n;
     }
 
@@ -276,37 +262,23 @@ public:
     Vector4 operator*(const Vector4& rhs) const
     {
         Vector4 v;
-/*#if defined USE_SSE
-        __m128 A1 = _mm_load_ps(_m + 0);
-        __m128 A2 = _mm_load_ps(_m + 4);
-        __m128 A3 = _mm_load_ps(_m + 8);
-        __m128 A4 = _mm_load_ps(_m + 12);
+#if defined USE_SSE
+        // NOTE: this is too small to be worth dispatching through simd_util
+        const __m128 V = _mm_load_ps(rhs._value);
+
+        const __m128 R1 = _mm_mul_ps(_mm_load_ps(_m + 0), V);
+        const __m128 R2 = _mm_mul_ps(_mm_load_ps(_m + 4), V);
+        const __m128 R3 = _mm_mul_ps(_mm_load_ps(_m + 8), V);
+        const __m128 R4 = _mm_mul_ps(_mm_load_ps(_m + 12), V);
 
-        __m128 X = _mm_set1_ps(rhs.x());
-        __m128 Y = _mm_set1_ps(rhs.y());
-        __m128 Z = _mm_set1_ps(rhs.z());
-        __m128 W = _mm_set1_ps(rhs.w());
-
-        __m128 R11 = _mm_mul_ps(A1, X);
-        __m128 R21 = _mm_mul_ps(A2, Y);
-        __m128 R31 = _mm_mul_ps(A3, Z);
-        __m128 R41 = _mm_mul_ps(A4, W);
-
-        __m128 R12 = _mm_hadd_ps(R11, R11);
-        __m128 R22 = _mm_hadd_ps(R21, R21);
-        __m128 R32 = _mm_hadd_ps(R31, R31);
-        __m128 R42 = _mm_hadd_ps(R41, R41);
-
-        _mm_store_ps(v._value + 0, _mm_hadd_ps(R12, R12));
-        _mm_store_ps(v._value + 1, _mm_hadd_ps(R22, R22));
-        _mm_store_ps(v._value + 2, _mm_hadd_ps(R32, R32));
-        _mm_store_ps(v._value + 3, _mm_hadd_ps(R42, R42));
-#else*/
+        // (x1+x2, x3+x4, y1+y2, y3+y4), (z1+z2, z3+z4, w1+w2, w3+w4) => (x, y, z, w)
+        _mm_store_ps(v._value, _mm_hadd_ps(_mm_hadd_ps(R1, R2), _mm_hadd_ps(R3, R4)));
+#else
         v.x(rhs * (_m + 0));
         v.y(rhs * (_m + 4));
         v.z(rhs * (_m + 8));
         v.w(rhs * (_m + 12));
-//#endif
+#endif
         return v;
     }
 
@@ -33,6 +33,7 @@ public:
     virtual ~Quaternion() throw() {}
 
 public:
+    void scalar(float scalar) { _scalar = scalar; }
     float scalar() const { return _scalar; }
 
     Vector3& vector() { return _vector; }
@@ -0,0 +1,175 @@
+#include "src/pch.h"
+#include "VertexLayout.h"
+
+namespace energonsoftware {
+
+size_t VertexLayout::type_size(AttributeType type)
+{
+    switch(type)
+    {
+    case Float:
+        return sizeof(float);
+    case HalfFloat:
+        return sizeof(uint16_t);
+    case Int2_10_10_10:
+        return sizeof(uint32_t);
+    }
+    return 0;
+}
+
+VertexLayout::VertexLayout()
+    : _stride(0)
+{
+}
+
+VertexLayout::~VertexLayout() throw()
+{
+}
+
+const VertexLayout::Attribute* VertexLayout::find_attribute(const std::string& name) const
+{
+    BOOST_FOREACH(const Attribute& attribute, _attributes) {
+        if(attribute.name == name) {
+            return &attribute;
+        }
+    }
+    return NULL;
+}
+
+VertexLayout& VertexLayout::add(const std::string& name, AttributeType type, size_t size, bool normalized)
+{
+    Attribute attribute;
+    attribute.name = name;
+    attribute.type = type;
+    attribute.size = Int2_10_10_10 == type ? 4 : size;
+    attribute.normalized = normalized;
+    attribute.offset = _stride;
+    _attributes.push_back(attribute);
+
+    _stride += Int2_10_10_10 == type ? type_size(type) : type_size(type) * size;
+    return *this;
+}
+
+VertexLayout& VertexLayout::stride(size_t stride)
+{
+    _stride = std::max(_stride, stride);
+    return *this;
+}
+
+std::string VertexLayout::str() const
+{
+    static const char* TypeNames[] = { "float", "half", "int2_10_10_10" };
+
+    std::stringstream ss;
+    ss << "VertexLayout(stride=" << _stride;
+    BOOST_FOREACH(const Attribute& attribute, _attributes) {
+        ss << ", " << attribute.name << "=" << TypeNames[attribute.type];
+        if(Int2_10_10_10 != attribute.type) {
+            ss << attribute.size;
+        }
+        ss << (attribute.normalized ? "n" : "") << "@" << attribute.offset;
+    }
+    ss << ")";
+    return ss.str();
+}
+
+// http://fgiesen.wordpress.com/2012/03/28/half-to-float-done-quic/
+uint16_t pack_half(float value)
+{
+    static const uint32_t F32Infinity = 255 << 23;
+    static const uint32_t F16Maximum = (127 + 16) << 23;
+    static const uint32_t DenormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+
+    const uint32_t sign = f & 0x80000000;
+    f ^= sign;
+
+    uint32_t h;
+    if(f >= F16Maximum) {
+        // Inf or NaN (NaN stays quiet)
+        h = f > F32Infinity ? 0x7e00 : 0x7c00;
+    } else if(f < (113 << 23)) {
+        // subnormal or zero, let the float add do the rounding
+        float magic;
+        std::memcpy(&magic, &DenormMagic, sizeof(magic));
+
+        float v;
+        std::memcpy(&v, &f, sizeof(v));
+        v += magic;
+        std::memcpy(&h, &v, sizeof(h));
+        h -= DenormMagic;
+    } else {
+        // rebias the exponent and round the mantissa to nearest even
+        const uint32_t odd = (f >> 13) & 1;
+        f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+        f += odd;
+        h = f >> 13;
+    }
+    return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+float unpack_half(uint16_t value)
+{
+    static const uint32_t ShiftedExponent = 0x7c00 << 13;
+    static const uint32_t Magic = 113 << 23;
+
+    uint32_t f = (value & 0x7fff) << 13;
+    const uint32_t exponent = ShiftedExponent & f;
+    f += (127 - 15) << 23;
+
+    if(exponent == ShiftedExponent) {
+        // Inf or NaN
+        f += (128 - 16) << 23;
+    } else if(0 == exponent) {
+        // subnormal, renormalize
+        f += 1 << 23;
+
+        float v, magic;
+        std::memcpy(&v, &f, sizeof(v));
+        std::memcpy(&magic, &Magic, sizeof(magic));
+        v -= magic;
+        std::memcpy(&f, &v, sizeof(f));
+    }
+    f |= static_cast<uint32_t>(value & 0x8000) << 16;
+
+    float result;
+    std::memcpy(&result, &f, sizeof(result));
+    return result;
+}
+
+static uint32_t pack_snorm10(float value)
+{
+    const float v = std::min(std::max(value, -1.0f), 1.0f) * 511.0f;
+    const int c = static_cast<int>(v < 0.0f ? v - 0.5f : v + 0.5f);
+    return static_cast<uint32_t>(c) & 0x3ff;
+}
+
+static float unpack_snorm10(uint32_t value)
+{
+    // sign extend the 10 bits
+    const int c = static_cast<int>(value << 22) >> 22;
+    return std::max(c / 511.0f, -1.0f);
+}
+
+uint32_t pack_snorm_2_10_10_10(float x, float y, float z, float w)
+{
+    // NOTE: -1 is stored as -2 since GL versions before 4.2 map the 2-bit
+    // values to (2c + 1) / 3, which only gives exactly -1 for -2,
+    // while newer versions clamp -2 to -1 as well
+    const uint32_t pw = w < 0.0f ? 0x2 : (w > 0.0f ? 0x1 : 0x0);
+    return pack_snorm10(x) | (pack_snorm10(y) << 10) | (pack_snorm10(z) << 20) | (pw << 30);
+}
+
+void unpack_snorm_2_10_10_10(uint32_t value, float& x, float& y, float& z, float& w)
+{
+    x = unpack_snorm10(value & 0x3ff);
+    y = unpack_snorm10((value >> 10) & 0x3ff);
+    z = unpack_snorm10((value >> 20) & 0x3ff);
+
+    const int c = static_cast<int>(value) >> 30;
+    w = std::max(static_cast<float>(c), -1.0f);
+}
+
+}
@@ -0,0 +1,78 @@
+#if !defined __VERTEXLAYOUT_H__
+#define __VERTEXLAYOUT_H__
+
+namespace energonsoftware {
+
+/*
+Describes the attributes interleaved in a single vertex buffer
+
+Each attribute is named after the shader attribute it feeds
+and sits at a fixed byte offset in every vertex.
+The renderer turns the attribute types into their GL equivalents,
+see RenderCommandBuffer::vertex_layout().
+*/
+class VertexLayout
+{
+public:
+    enum AttributeType
+    {
+        Float,
+        HalfFloat,
+
+        // signed x:y:z:w = 10:10:10:2 packed into 32 bits, always 4 components
+        Int2_10_10_10
+    };
+
+    struct Attribute
+    {
+        std::string name;
+        AttributeType type;
+        size_t size;
+        bool normalized;
+
+        // in bytes from the start of the vertex
+        size_t offset;
+    };
+
+    // the size of a single component (of the whole thing for packed types)
+    static size_t type_size(AttributeType type);
+
+public:
+    VertexLayout();
+    virtual ~VertexLayout() throw();
+
+public:
+    // the distance in bytes between consecutive vertices
+    size_t stride() const { return _stride; }
+
+    size_t attribute_count() const { return _attributes.size(); }
+    const Attribute& attribute(size_t idx) const { return _attributes[idx]; }
+
+    // NULL if there isn't an attribute with the given name
+    const Attribute* find_attribute(const std::string& name) const;
+
+    // appends an attribute after the ones already added
+    VertexLayout& add(const std::string& name, AttributeType type, size_t size, bool normalized=false);
+
+    // NOTE: this is for vertex structs with padding, it can only grow the stride
+    VertexLayout& stride(size_t stride);
+
+    std::string str() const;
+
+private:
+    std::vector<Attribute> _attributes;
+    size_t _stride;
+};
+
+// IEEE 754 half precision floats (rounded to nearest even)
+uint16_t pack_half(float value);
+float unpack_half(uint16_t value);
+
+// packs a vector with components in [-1, 1] into signed 10:10:10:2
+// NOTE: w only has the values -1, 0 and 1
+uint32_t pack_snorm_2_10_10_10(float x, float y, float z, float w);
+void unpack_snorm_2_10_10_10(uint32_t value, float& x, float& y, float& z, float& w);
+
+}
+
+#endif
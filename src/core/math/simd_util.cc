@@ -0,0 +1,774 @@
+#include "src/pch.h"
+#if defined _MSC_VER
+    #include <intrin.h>
+#endif
+#include <immintrin.h>
+#include "Matrix4.h"
+#include "simd_util.h"
+
+// AVX2 kernels are compiled for AVX2 regardless of the build flags
+// and only ever called if the cpu supports it
+#if defined _MSC_VER
+    #define TARGET_AVX2
+#else
+    #define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace energonsoftware {
+
+/*
+Scalar kernels
+*/
+
+static void matrix4_multiply_scalar(const float* lhs, const float* rhs, float* out)
+{
+    for(int r=0; r<4; ++r) {
+        const float* const row = lhs + (r * 4);
+        for(int c=0; c<4; ++c) {
+            out[(r * 4) + c] = row[0] * rhs[c] + row[1] * rhs[4 + c] + row[2] * rhs[8 + c] + row[3] * rhs[12 + c];
+        }
+    }
+}
+
+static void transform_points_scalar(const float* m, const float* in, float* out, size_t n)
+{
+    for(size_t i=0; i<n; ++i, in+=3, out+=3) {
+        const float x = in[0], y = in[1], z = in[2];
+        out[0] = m[0] * x + m[1] * y + m[2]  * z + m[3];
+        out[1] = m[4] * x + m[5] * y + m[6]  * z + m[7];
+        out[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+    }
+}
+
+// nlerp is used when the orientations are at least this close (cos of the half angle),
+// which keeps its error under about 0.1 degrees
+static const float NlerpMinDot = 0.96f;
+
+static void slerp_joint(const float* a, const float* b, float t, float* out, size_t stride, size_t idx)
+{
+    const float* const aq = a + (PoseOrientationX * stride) + idx;
+    const float* const bq = b + (PoseOrientationX * stride) + idx;
+
+    float d = aq[0] * bq[0] + aq[stride] * bq[stride] + aq[stride * 2] * bq[stride * 2] + aq[stride * 3] * bq[stride * 3];
+
+    // rotate the shorter way around
+    const float sign = d < 0.0f ? -1.0f : 1.0f;
+    d = std::min(d * sign, 1.0f);
+
+    float wa = 1.0f - t, wb = t;
+    const float angle = std::acos(d);
+    const float sangle = std::sin(angle);
+    if(sangle > 0.001f) {
+        wa = std::sin(wa * angle) / sangle;
+        wb = std::sin(wb * angle) / sangle;
+    }
+    wb *= sign;
+
+    float* const oq = out + (PoseOrientationX * stride) + idx;
+    const float x = wa * aq[0] + wb * bq[0], y = wa * aq[stride] + wb * bq[stride],
+        z = wa * aq[stride * 2] + wb * bq[stride * 2], w = wa * aq[stride * 3] + wb * bq[stride * 3];
+    oq[0] = x;
+    oq[stride] = y;
+    oq[stride * 2] = z;
+    oq[stride * 3] = w;
+}
+
+static void blend_poses_scalar(const float* a, const float* b, float t, float* out, size_t stride)
+{
+    for(size_t s=PosePositionX; s<=PosePositionZ; ++s) {
+        const size_t start = s * stride;
+        for(size_t i=start; i<start+stride; ++i) {
+            out[i] = a[i] + (b[i] - a[i]) * t;
+        }
+    }
+
+    const float* const ax = a + (PoseOrientationX * stride);
+    const float* const bx = b + (PoseOrientationX * stride);
+    float* const ox = out + (PoseOrientationX * stride);
+    for(size_t i=0; i<stride; ++i) {
+        const float d = ax[i] * bx[i] + ax[stride + i] * bx[stride + i]
+            + ax[(stride * 2) + i] * bx[(stride * 2) + i] + ax[(stride * 3) + i] * bx[(stride * 3) + i];
+        if(std::fabs(d) < NlerpMinDot) {
+            slerp_joint(a, b, t, out, stride, i);
+            continue;
+        }
+
+        const float wa = 1.0f - t, wb = d < 0.0f ? -t : t;
+        const float x = wa * ax[i] + wb * bx[i], y = wa * ax[stride + i] + wb * bx[stride + i],
+            z = wa * ax[(stride * 2) + i] + wb * bx[(stride * 2) + i], w = wa * ax[(stride * 3) + i] + wb * bx[(stride * 3) + i];
+        const float scale = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+        ox[i] = x * scale;
+        ox[stride + i] = y * scale;
+        ox[(stride * 2) + i] = z * scale;
+        ox[(stride * 3) + i] = w * scale;
+    }
+}
+
+static void pose_palette_scalar(const float* pose, size_t stride, size_t count, float* palette)
+{
+    for(size_t i=0; i<count; ++i, palette+=PaletteMatrixSize) {
+        const float x = pose[(PoseOrientationX * stride) + i], y = pose[(PoseOrientationY * stride) + i],
+            z = pose[(PoseOrientationZ * stride) + i], w = pose[(PoseOrientationW * stride) + i];
+
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, xz = x * z, yz = y * z;
+        const float wx = w * x, wy = w * y, wz = w * z;
+
+        palette[0]  = 1.0f - 2.0f * (yy + zz);
+        palette[1]  = 2.0f * (xy + wz);
+        palette[2]  = 2.0f * (xz - wy);
+        palette[3]  = 0.0f;
+
+        palette[4]  = 2.0f * (xy - wz);
+        palette[5]  = 1.0f - 2.0f * (xx + zz);
+        palette[6]  = 2.0f * (yz + wx);
+        palette[7]  = 0.0f;
+
+        palette[8]  = 2.0f * (xz + wy);
+        palette[9]  = 2.0f * (yz - wx);
+        palette[10] = 1.0f - 2.0f * (xx + yy);
+        palette[11] = 0.0f;
+
+        palette[12] = pose[(PosePositionX * stride) + i];
+        palette[13] = pose[(PosePositionY * stride) + i];
+        palette[14] = pose[(PosePositionZ * stride) + i];
+        palette[15] = 0.0f;
+    }
+}
+
+static void skin_vertices_scalar(const float* palette, const SkinWeight* weights, const uint32_t* weight_counts, size_t count, SkinnedVertex* out)
+{
+    for(size_t i=0; i<count; ++i, ++out) {
+        float p[3] = { 0.0f, 0.0f, 0.0f }, n[3] = { 0.0f, 0.0f, 0.0f },
+            t[3] = { 0.0f, 0.0f, 0.0f }, b[3] = { 0.0f, 0.0f, 0.0f };
+
+        for(uint32_t j=0; j<weight_counts[i]; ++j, ++weights) {
+            const float* const m = palette + (weights->joint * PaletteMatrixSize);
+            for(int r=0; r<3; ++r) {
+                p[r] += m[r] * weights->position[0] + m[4 + r] * weights->position[1] + m[8 + r] * weights->position[2] + m[12 + r] * weights->position[3];
+                n[r] += m[r] * weights->normal[0] + m[4 + r] * weights->normal[1] + m[8 + r] * weights->normal[2];
+                t[r] += m[r] * weights->tangent[0] + m[4 + r] * weights->tangent[1] + m[8 + r] * weights->tangent[2];
+                b[r] += m[r] * weights->bitangent[0] + m[4 + r] * weights->bitangent[1] + m[8 + r] * weights->bitangent[2];
+            }
+        }
+
+        const float nscale = 1.0f / std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        const float tscale = 1.0f / std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+        const float bscale = 1.0f / std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+        for(int r=0; r<3; ++r) {
+            out->position[r] = p[r];
+            out->normal[r] = n[r] * nscale;
+            out->tangent[r] = t[r] * tscale;
+            out->bitangent[r] = b[r] * bscale;
+        }
+        out->position[3] = out->normal[3] = out->tangent[3] = out->bitangent[3] = 0.0f;
+    }
+}
+
+/*
+SSE3 kernels
+*/
+
+#if defined USE_SSE
+static void matrix4_multiply_sse3(const float* lhs, const float* rhs, float* out)
+{
+    // each row of the result is a combination of the rows of rhs
+    const __m128 B0 = _mm_loadu_ps(rhs + 0);
+    const __m128 B1 = _mm_loadu_ps(rhs + 4);
+    const __m128 B2 = _mm_loadu_ps(rhs + 8);
+    const __m128 B3 = _mm_loadu_ps(rhs + 12);
+
+    for(int r=0; r<4; ++r) {
+        const float* const row = lhs + (r * 4);
+        __m128 R = _mm_mul_ps(_mm_set1_ps(row[0]), B0);
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(row[1]), B1));
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(row[2]), B2));
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(row[3]), B3));
+        _mm_storeu_ps(out + (r * 4), R);
+    }
+}
+
+static void transform_points_sse3(const float* m, const float* in, float* out, size_t n)
+{
+    // columns of the upper 3x4
+    const __m128 C0 = _mm_setr_ps(m[0], m[4], m[8],  0.0f);
+    const __m128 C1 = _mm_setr_ps(m[1], m[5], m[9],  0.0f);
+    const __m128 C2 = _mm_setr_ps(m[2], m[6], m[10], 0.0f);
+    const __m128 C3 = _mm_setr_ps(m[3], m[7], m[11], 0.0f);
+
+    for(size_t i=0; i<n; ++i, in+=3, out+=3) {
+        __m128 R = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(in[0]), C0), C3);
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(in[1]), C1));
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(in[2]), C2));
+
+        // store x, y and then z without touching the next point
+        _mm_storel_pi(reinterpret_cast<__m64*>(out), R);
+        _mm_store_ss(out + 2, _mm_movehl_ps(R, R));
+    }
+}
+
+static void blend_poses_sse3(const float* a, const float* b, float t, float* out, size_t stride)
+{
+    const __m128 T = _mm_set1_ps(t);
+    const __m128 U = _mm_set1_ps(1.0f - t);
+    const __m128 SignMask = _mm_set1_ps(-0.0f);
+    const __m128 MinDot = _mm_set1_ps(NlerpMinDot);
+
+    for(size_t i=0; i<stride * 3; i+=4) {
+        const __m128 A = _mm_loadu_ps(a + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(A, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), A), T)));
+    }
+
+    const float* const aq = a + (PoseOrientationX * stride);
+    const float* const bq = b + (PoseOrientationX * stride);
+    float* const oq = out + (PoseOrientationX * stride);
+    for(size_t i=0; i<stride; i+=4) {
+        const __m128 AX = _mm_loadu_ps(aq + i), AY = _mm_loadu_ps(aq + stride + i),
+            AZ = _mm_loadu_ps(aq + (stride * 2) + i), AW = _mm_loadu_ps(aq + (stride * 3) + i);
+        __m128 BX = _mm_loadu_ps(bq + i), BY = _mm_loadu_ps(bq + stride + i),
+            BZ = _mm_loadu_ps(bq + (stride * 2) + i), BW = _mm_loadu_ps(bq + (stride * 3) + i);
+
+        __m128 D = _mm_add_ps(_mm_add_ps(_mm_mul_ps(AX, BX), _mm_mul_ps(AY, BY)), _mm_add_ps(_mm_mul_ps(AZ, BZ), _mm_mul_ps(AW, BW)));
+
+        // flip b where that's the shorter way around
+        const __m128 Sign = _mm_and_ps(D, SignMask);
+        BX = _mm_xor_ps(BX, Sign);
+        BY = _mm_xor_ps(BY, Sign);
+        BZ = _mm_xor_ps(BZ, Sign);
+        BW = _mm_xor_ps(BW, Sign);
+        D = _mm_xor_ps(D, Sign);
+
+        const __m128 X = _mm_add_ps(_mm_mul_ps(AX, U), _mm_mul_ps(BX, T));
+        const __m128 Y = _mm_add_ps(_mm_mul_ps(AY, U), _mm_mul_ps(BY, T));
+        const __m128 Z = _mm_add_ps(_mm_mul_ps(AZ, U), _mm_mul_ps(BZ, T));
+        const __m128 W = _mm_add_ps(_mm_mul_ps(AW, U), _mm_mul_ps(BW, T));
+
+        const __m128 L = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(X, X), _mm_mul_ps(Y, Y)), _mm_add_ps(_mm_mul_ps(Z, Z), _mm_mul_ps(W, W))));
+        _mm_storeu_ps(oq + i, _mm_div_ps(X, L));
+        _mm_storeu_ps(oq + stride + i, _mm_div_ps(Y, L));
+        _mm_storeu_ps(oq + (stride * 2) + i, _mm_div_ps(Z, L));
+        _mm_storeu_ps(oq + (stride * 3) + i, _mm_div_ps(W, L));
+
+        // redo the joints nlerp isn't good enough for
+        const int fallback = _mm_movemask_ps(_mm_cmplt_ps(D, MinDot));
+        if(fallback) {
+            for(int lane=0; lane<4; ++lane) {
+                if(fallback & (1 << lane)) {
+                    slerp_joint(a, b, t, out, stride, i + lane);
+                }
+            }
+        }
+    }
+}
+
+// stores the (r0, r1, r2, 0) columns of 4 joints
+static inline void store_palette_columns_sse3(__m128 r0, __m128 r1, __m128 r2, float* palette)
+{
+    const __m128 Z = _mm_setzero_ps();
+    const __m128 T0 = _mm_unpacklo_ps(r0, r1), T1 = _mm_unpackhi_ps(r0, r1);
+    const __m128 T2 = _mm_unpacklo_ps(r2, Z), T3 = _mm_unpackhi_ps(r2, Z);
+
+    _mm_storeu_ps(palette + (0 * PaletteMatrixSize), _mm_movelh_ps(T0, T2));
+    _mm_storeu_ps(palette + (1 * PaletteMatrixSize), _mm_movehl_ps(T2, T0));
+    _mm_storeu_ps(palette + (2 * PaletteMatrixSize), _mm_movelh_ps(T1, T3));
+    _mm_storeu_ps(palette + (3 * PaletteMatrixSize), _mm_movehl_ps(T3, T1));
+}
+
+static void pose_palette_sse3(const float* pose, size_t stride, size_t count, float* palette)
+{
+    const __m128 One = _mm_set1_ps(1.0f);
+    const __m128 Two = _mm_set1_ps(2.0f);
+
+    size_t i = 0;
+    for(; i+4<=count; i+=4, palette+=4*PaletteMatrixSize) {
+        const __m128 X = _mm_loadu_ps(pose + (PoseOrientationX * stride) + i), Y = _mm_loadu_ps(pose + (PoseOrientationY * stride) + i),
+            Z = _mm_loadu_ps(pose + (PoseOrientationZ * stride) + i), W = _mm_loadu_ps(pose + (PoseOrientationW * stride) + i);
+
+        const __m128 XX = _mm_mul_ps(X, X), YY = _mm_mul_ps(Y, Y), ZZ = _mm_mul_ps(Z, Z);
+        const __m128 XY = _mm_mul_ps(X, Y), XZ = _mm_mul_ps(X, Z), YZ = _mm_mul_ps(Y, Z);
+        const __m128 WX = _mm_mul_ps(W, X), WY = _mm_mul_ps(W, Y), WZ = _mm_mul_ps(W, Z);
+
+        store_palette_columns_sse3(
+            _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(YY, ZZ))),
+            _mm_mul_ps(Two, _mm_add_ps(XY, WZ)),
+            _mm_mul_ps(Two, _mm_sub_ps(XZ, WY)),
+            palette + 0);
+        store_palette_columns_sse3(
+            _mm_mul_ps(Two, _mm_sub_ps(XY, WZ)),
+            _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(XX, ZZ))),
+            _mm_mul_ps(Two, _mm_add_ps(YZ, WX)),
+            palette + 4);
+        store_palette_columns_sse3(
+            _mm_mul_ps(Two, _mm_add_ps(XZ, WY)),
+            _mm_mul_ps(Two, _mm_sub_ps(YZ, WX)),
+            _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(XX, YY))),
+            palette + 8);
+        store_palette_columns_sse3(
+            _mm_loadu_ps(pose + (PosePositionX * stride) + i),
+            _mm_loadu_ps(pose + (PosePositionY * stride) + i),
+            _mm_loadu_ps(pose + (PosePositionZ * stride) + i),
+            palette + 12);
+    }
+
+    // NOTE: the tail kernel indexes from the start of the streams
+    pose_palette_scalar(pose + i, stride, count - i, palette);
+}
+
+// (x, y, z, 0) / |(x, y, z)|
+static inline __m128 normalize3_sse3(__m128 V)
+{
+    const __m128 D = _mm_mul_ps(V, V);
+    return _mm_div_ps(V, _mm_sqrt_ps(_mm_hadd_ps(_mm_hadd_ps(D, D), _mm_hadd_ps(D, D))));
+}
+
+static void skin_vertices_sse3(const float* palette, const SkinWeight* weights, const uint32_t* weight_counts, size_t count, SkinnedVertex* out)
+{
+    for(size_t i=0; i<count; ++i, ++out) {
+        __m128 P = _mm_setzero_ps(), N = _mm_setzero_ps(), T = _mm_setzero_ps(), B = _mm_setzero_ps();
+
+        for(uint32_t j=0; j<weight_counts[i]; ++j, ++weights) {
+            const float* const m = palette + (weights->joint * PaletteMatrixSize);
+            const __m128 C0 = _mm_loadu_ps(m + 0), C1 = _mm_loadu_ps(m + 4), C2 = _mm_loadu_ps(m + 8), C3 = _mm_loadu_ps(m + 12);
+
+            const __m128 WP = _mm_loadu_ps(weights->position);
+            P = _mm_add_ps(P, _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(C0, _mm_shuffle_ps(WP, WP, 0x00)), _mm_mul_ps(C1, _mm_shuffle_ps(WP, WP, 0x55))),
+                _mm_add_ps(_mm_mul_ps(C2, _mm_shuffle_ps(WP, WP, 0xaa)), _mm_mul_ps(C3, _mm_shuffle_ps(WP, WP, 0xff)))));
+
+            const __m128 WN = _mm_loadu_ps(weights->normal);
+            N = _mm_add_ps(N, _mm_add_ps(_mm_add_ps(_mm_mul_ps(C0, _mm_shuffle_ps(WN, WN, 0x00)),
+                _mm_mul_ps(C1, _mm_shuffle_ps(WN, WN, 0x55))), _mm_mul_ps(C2, _mm_shuffle_ps(WN, WN, 0xaa))));
+
+            const __m128 WT = _mm_loadu_ps(weights->tangent);
+            T = _mm_add_ps(T, _mm_add_ps(_mm_add_ps(_mm_mul_ps(C0, _mm_shuffle_ps(WT, WT, 0x00)),
+                _mm_mul_ps(C1, _mm_shuffle_ps(WT, WT, 0x55))), _mm_mul_ps(C2, _mm_shuffle_ps(WT, WT, 0xaa))));
+
+            const __m128 WB = _mm_loadu_ps(weights->bitangent);
+            B = _mm_add_ps(B, _mm_add_ps(_mm_add_ps(_mm_mul_ps(C0, _mm_shuffle_ps(WB, WB, 0x00)),
+                _mm_mul_ps(C1, _mm_shuffle_ps(WB, WB, 0x55))), _mm_mul_ps(C2, _mm_shuffle_ps(WB, WB, 0xaa))));
+        }
+
+        _mm_storeu_ps(out->position, P);
+        _mm_storeu_ps(out->normal, normalize3_sse3(N));
+        _mm_storeu_ps(out->tangent, normalize3_sse3(T));
+        _mm_storeu_ps(out->bitangent, normalize3_sse3(B));
+    }
+}
+#endif
+
+/*
+AVX2 kernels
+*/
+
+TARGET_AVX2 static void matrix4_multiply_avx2(const float* lhs, const float* rhs, float* out)
+{
+    // two rows of the result at a time, one per 128-bit lane
+    const __m256 B0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs + 0));
+    const __m256 B1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs + 4));
+    const __m256 B2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs + 8));
+    const __m256 B3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs + 12));
+
+    for(int r=0; r<4; r+=2) {
+        const float* const row0 = lhs + (r * 4);
+        const float* const row1 = row0 + 4;
+
+        __m256 R = _mm256_mul_ps(_mm256_setr_m128(_mm_set1_ps(row0[0]), _mm_set1_ps(row1[0])), B0);
+        R = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(row0[1]), _mm_set1_ps(row1[1])), B1, R);
+        R = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(row0[2]), _mm_set1_ps(row1[2])), B2, R);
+        R = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(row0[3]), _mm_set1_ps(row1[3])), B3, R);
+        _mm256_storeu_ps(out + (r * 4), R);
+    }
+}
+
+TARGET_AVX2 static void transform_points_avx2(const float* m, const float* in, float* out, size_t n)
+{
+    // 8 points (24 floats, 3 registers) at a time
+    // the x, y and z of the points are spread through the registers in a repeating
+    // pattern, so each component is blended together and then permuted into point order
+    // (and the reverse on the way back out)
+    const __m256i XIndex = _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5);
+    const __m256i YIndex = _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6);
+    const __m256i ZIndex = _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7);
+    const __m256i AIndex = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+    const __m256i BIndex = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+    const __m256i CIndex = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+    const __m256 M0 = _mm256_set1_ps(m[0]), M1 = _mm256_set1_ps(m[1]), M2  = _mm256_set1_ps(m[2]),  M3  = _mm256_set1_ps(m[3]);
+    const __m256 M4 = _mm256_set1_ps(m[4]), M5 = _mm256_set1_ps(m[5]), M6  = _mm256_set1_ps(m[6]),  M7  = _mm256_set1_ps(m[7]);
+    const __m256 M8 = _mm256_set1_ps(m[8]), M9 = _mm256_set1_ps(m[9]), M10 = _mm256_set1_ps(m[10]), M11 = _mm256_set1_ps(m[11]);
+
+    size_t i = 0;
+    for(; i+8<=n; i+=8, in+=24, out+=24) {
+        const __m256 A = _mm256_loadu_ps(in + 0);
+        const __m256 B = _mm256_loadu_ps(in + 8);
+        const __m256 C = _mm256_loadu_ps(in + 16);
+
+        const __m256 X = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(A, B, 0x92), C, 0x24), XIndex);
+        const __m256 Y = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(A, B, 0x24), C, 0x49), YIndex);
+        const __m256 Z = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(A, B, 0x49), C, 0x92), ZIndex);
+
+        const __m256 OX = _mm256_fmadd_ps(M2,  Z, _mm256_fmadd_ps(M1, Y, _mm256_fmadd_ps(M0, X, M3)));
+        const __m256 OY = _mm256_fmadd_ps(M6,  Z, _mm256_fmadd_ps(M5, Y, _mm256_fmadd_ps(M4, X, M7)));
+        const __m256 OZ = _mm256_fmadd_ps(M10, Z, _mm256_fmadd_ps(M9, Y, _mm256_fmadd_ps(M8, X, M11)));
+
+        _mm256_storeu_ps(out + 0, _mm256_blend_ps(_mm256_blend_ps(
+            _mm256_permutevar8x32_ps(OX, AIndex), _mm256_permutevar8x32_ps(OY, AIndex), 0x92), _mm256_permutevar8x32_ps(OZ, AIndex), 0x24));
+        _mm256_storeu_ps(out + 8, _mm256_blend_ps(_mm256_blend_ps(
+            _mm256_permutevar8x32_ps(OX, BIndex), _mm256_permutevar8x32_ps(OY, BIndex), 0x24), _mm256_permutevar8x32_ps(OZ, BIndex), 0x49));
+        _mm256_storeu_ps(out + 16, _mm256_blend_ps(_mm256_blend_ps(
+            _mm256_permutevar8x32_ps(OX, CIndex), _mm256_permutevar8x32_ps(OY, CIndex), 0x49), _mm256_permutevar8x32_ps(OZ, CIndex), 0x92));
+    }
+
+    // NOTE: GCC doesn't clear the upper halves before the tail call,
+    // which leaves every SSE instruction after this paying for the AVX state transition
+    _mm256_zeroupper();
+    transform_points_scalar(m, in, out, n - i);
+}
+
+TARGET_AVX2 static void blend_poses_avx2(const float* a, const float* b, float t, float* out, size_t stride)
+{
+    const __m256 T = _mm256_set1_ps(t);
+    const __m256 U = _mm256_set1_ps(1.0f - t);
+    const __m256 SignMask = _mm256_set1_ps(-0.0f);
+    const __m256 MinDot = _mm256_set1_ps(NlerpMinDot);
+
+    for(size_t i=0; i<stride * 3; i+=8) {
+        const __m256 A = _mm256_loadu_ps(a + i);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_sub_ps(_mm256_loadu_ps(b + i), A), T, A));
+    }
+
+    const float* const aq = a + (PoseOrientationX * stride);
+    const float* const bq = b + (PoseOrientationX * stride);
+    float* const oq = out + (PoseOrientationX * stride);
+    for(size_t i=0; i<stride; i+=8) {
+        const __m256 AX = _mm256_loadu_ps(aq + i), AY = _mm256_loadu_ps(aq + stride + i),
+            AZ = _mm256_loadu_ps(aq + (stride * 2) + i), AW = _mm256_loadu_ps(aq + (stride * 3) + i);
+        const __m256 BX = _mm256_loadu_ps(bq + i), BY = _mm256_loadu_ps(bq + stride + i),
+            BZ = _mm256_loadu_ps(bq + (stride * 2) + i), BW = _mm256_loadu_ps(bq + (stride * 3) + i);
+
+        __m256 D = _mm256_fmadd_ps(AW, BW, _mm256_fmadd_ps(AZ, BZ, _mm256_fmadd_ps(AY, BY, _mm256_mul_ps(AX, BX))));
+
+        // flip b's weight where that's the shorter way around
+        const __m256 Sign = _mm256_and_ps(D, SignMask);
+        const __m256 TB = _mm256_xor_ps(T, Sign);
+        D = _mm256_xor_ps(D, Sign);
+
+        const __m256 X = _mm256_fmadd_ps(BX, TB, _mm256_mul_ps(AX, U));
+        const __m256 Y = _mm256_fmadd_ps(BY, TB, _mm256_mul_ps(AY, U));
+        const __m256 Z = _mm256_fmadd_ps(BZ, TB, _mm256_mul_ps(AZ, U));
+        const __m256 W = _mm256_fmadd_ps(BW, TB, _mm256_mul_ps(AW, U));
+
+        const __m256 L = _mm256_sqrt_ps(_mm256_fmadd_ps(W, W, _mm256_fmadd_ps(Z, Z, _mm256_fmadd_ps(Y, Y, _mm256_mul_ps(X, X)))));
+        _mm256_storeu_ps(oq + i, _mm256_div_ps(X, L));
+        _mm256_storeu_ps(oq + stride + i, _mm256_div_ps(Y, L));
+        _mm256_storeu_ps(oq + (stride * 2) + i, _mm256_div_ps(Z, L));
+        _mm256_storeu_ps(oq + (stride * 3) + i, _mm256_div_ps(W, L));
+
+        // redo the joints nlerp isn't good enough for
+        const int fallback = _mm256_movemask_ps(_mm256_cmp_ps(D, MinDot, _CMP_LT_OQ));
+        if(fallback) {
+            for(int lane=0; lane<8; ++lane) {
+                if(fallback & (1 << lane)) {
+                    slerp_joint(a, b, t, out, stride, i + lane);
+                }
+            }
+        }
+    }
+}
+
+// stores the (r0, r1, r2, 0) columns of 8 joints, a 4x4 transpose in each lane
+TARGET_AVX2 static inline void store_palette_columns_avx2(__m256 r0, __m256 r1, __m256 r2, float* palette)
+{
+    const __m256 Z = _mm256_setzero_ps();
+    const __m256 T0 = _mm256_unpacklo_ps(r0, r1), T1 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 T2 = _mm256_unpacklo_ps(r2, Z), T3 = _mm256_unpackhi_ps(r2, Z);
+
+    const __m256 J0 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 J1 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 J2 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 J3 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm_storeu_ps(palette + (0 * PaletteMatrixSize), _mm256_castps256_ps128(J0));
+    _mm_storeu_ps(palette + (1 * PaletteMatrixSize), _mm256_castps256_ps128(J1));
+    _mm_storeu_ps(palette + (2 * PaletteMatrixSize), _mm256_castps256_ps128(J2));
+    _mm_storeu_ps(palette + (3 * PaletteMatrixSize), _mm256_castps256_ps128(J3));
+    _mm_storeu_ps(palette + (4 * PaletteMatrixSize), _mm256_extractf128_ps(J0, 1));
+    _mm_storeu_ps(palette + (5 * PaletteMatrixSize), _mm256_extractf128_ps(J1, 1));
+    _mm_storeu_ps(palette + (6 * PaletteMatrixSize), _mm256_extractf128_ps(J2, 1));
+    _mm_storeu_ps(palette + (7 * PaletteMatrixSize), _mm256_extractf128_ps(J3, 1));
+}
+
+TARGET_AVX2 static void pose_palette_avx2(const float* pose, size_t stride, size_t count, float* palette)
+{
+    const __m256 One = _mm256_set1_ps(1.0f);
+    const __m256 Two = _mm256_set1_ps(2.0f);
+
+    size_t i = 0;
+    for(; i+8<=count; i+=8, palette+=8*PaletteMatrixSize) {
+        const __m256 X = _mm256_loadu_ps(pose + (PoseOrientationX * stride) + i), Y = _mm256_loadu_ps(pose + (PoseOrientationY * stride) + i),
+            Z = _mm256_loadu_ps(pose + (PoseOrientationZ * stride) + i), W = _mm256_loadu_ps(pose + (PoseOrientationW * stride) + i);
+
+        const __m256 XX = _mm256_mul_ps(X, X), YY = _mm256_mul_ps(Y, Y), ZZ = _mm256_mul_ps(Z, Z);
+        const __m256 XY = _mm256_mul_ps(X, Y), XZ = _mm256_mul_ps(X, Z), YZ = _mm256_mul_ps(Y, Z);
+        const __m256 WX = _mm256_mul_ps(W, X), WY = _mm256_mul_ps(W, Y), WZ = _mm256_mul_ps(W, Z);
+
+        store_palette_columns_avx2(
+            _mm256_fnmadd_ps(Two, _mm256_add_ps(YY, ZZ), One),
+            _mm256_mul_ps(Two, _mm256_add_ps(XY, WZ)),
+            _mm256_mul_ps(Two, _mm256_sub_ps(XZ, WY)),
+            palette + 0);
+        store_palette_columns_avx2(
+            _mm256_mul_ps(Two, _mm256_sub_ps(XY, WZ)),
+            _mm256_fnmadd_ps(Two, _mm256_add_ps(XX, ZZ), One),
+            _mm256_mul_ps(Two, _mm256_add_ps(YZ, WX)),
+            palette + 4);
+        store_palette_columns_avx2(
+            _mm256_mul_ps(Two, _mm256_add_ps(XZ, WY)),
+            _mm256_mul_ps(Two, _mm256_sub_ps(YZ, WX)),
+            _mm256_fnmadd_ps(Two, _mm256_add_ps(XX, YY), One),
+            palette + 8);
+        store_palette_columns_avx2(
+            _mm256_loadu_ps(pose + (PosePositionX * stride) + i),
+            _mm256_loadu_ps(pose + (PosePositionY * stride) + i),
+            _mm256_loadu_ps(pose + (PosePositionZ * stride) + i),
+            palette + 12);
+    }
+
+    _mm256_zeroupper();
+    pose_palette_scalar(pose + i, stride, count - i, palette);
+}
+
+// (x, y, z, 0) / |(x, y, z)| in each lane
+TARGET_AVX2 static inline __m256 normalize3_avx2(__m256 V)
+{
+    __m256 D = _mm256_mul_ps(V, V);
+    D = _mm256_hadd_ps(D, D);
+    return _mm256_div_ps(V, _mm256_sqrt_ps(_mm256_hadd_ps(D, D)));
+}
+
+TARGET_AVX2 static inline __m256 load_weight_pair(const float* a, const float* b)
+{
+    return _mm256_setr_m128(_mm_loadu_ps(a), _mm_loadu_ps(b));
+}
+
+TARGET_AVX2 static void skin_vertices_avx2(const float* palette, const SkinWeight* weights, const uint32_t* weight_counts, size_t count, SkinnedVertex* out)
+{
+    // the shorter vertex of a pair is padded out with a weight that contributes nothing
+    static const SkinWeight ZeroWeight = SkinWeight();
+
+    // two vertices at a time, one per 128-bit lane
+    size_t i = 0;
+    for(; i+2<=count; i+=2, out+=2) {
+        const uint32_t c0 = weight_counts[i], c1 = weight_counts[i + 1];
+        const SkinWeight* const w0 = weights;
+        const SkinWeight* const w1 = weights + c0;
+        weights += c0 + c1;
+
+        __m256 P = _mm256_setzero_ps(), N = _mm256_setzero_ps(), T = _mm256_setzero_ps(), B = _mm256_setzero_ps();
+
+        const uint32_t wcount = std::max(c0, c1);
+        for(uint32_t j=0; j<wcount; ++j) {
+            const SkinWeight& a(j < c0 ? w0[j] : ZeroWeight);
+            const SkinWeight& b(j < c1 ? w1[j] : ZeroWeight);
+
+            const float* const ma = palette + (a.joint * PaletteMatrixSize);
+            const float* const mb = palette + (b.joint * PaletteMatrixSize);
+            const __m256 C0 = _mm256_setr_m128(_mm_loadu_ps(ma + 0), _mm_loadu_ps(mb + 0));
+            const __m256 C1 = _mm256_setr_m128(_mm_loadu_ps(ma + 4), _mm_loadu_ps(mb + 4));
+            const __m256 C2 = _mm256_setr_m128(_mm_loadu_ps(ma + 8), _mm_loadu_ps(mb + 8));
+            const __m256 C3 = _mm256_setr_m128(_mm_loadu_ps(ma + 12), _mm_loadu_ps(mb + 12));
+
+            const __m256 WP = load_weight_pair(a.position, b.position);
+            P = _mm256_fmadd_ps(C0, _mm256_permute_ps(WP, 0x00), P);
+            P = _mm256_fmadd_ps(C1, _mm256_permute_ps(WP, 0x55), P);
+            P = _mm256_fmadd_ps(C2, _mm256_permute_ps(WP, 0xaa), P);
+            P = _mm256_fmadd_ps(C3, _mm256_permute_ps(WP, 0xff), P);
+
+            const __m256 WN = load_weight_pair(a.normal, b.normal);
+            N = _mm256_fmadd_ps(C0, _mm256_permute_ps(WN, 0x00), N);
+            N = _mm256_fmadd_ps(C1, _mm256_permute_ps(WN, 0x55), N);
+            N = _mm256_fmadd_ps(C2, _mm256_permute_ps(WN, 0xaa), N);
+
+            const __m256 WT = load_weight_pair(a.tangent, b.tangent);
+            T = _mm256_fmadd_ps(C0, _mm256_permute_ps(WT, 0x00), T);
+            T = _mm256_fmadd_ps(C1, _mm256_permute_ps(WT, 0x55), T);
+            T = _mm256_fmadd_ps(C2, _mm256_permute_ps(WT, 0xaa), T);
+
+            const __m256 WB = load_weight_pair(a.bitangent, b.bitangent);
+            B = _mm256_fmadd_ps(C0, _mm256_permute_ps(WB, 0x00), B);
+            B = _mm256_fmadd_ps(C1, _mm256_permute_ps(WB, 0x55), B);
+            B = _mm256_fmadd_ps(C2, _mm256_permute_ps(WB, 0xaa), B);
+        }
+
+        N = normalize3_avx2(N);
+        T = normalize3_avx2(T);
+        B = normalize3_avx2(B);
+
+        _mm_storeu_ps(out[0].position, _mm256_castps256_ps128(P));
+        _mm_storeu_ps(out[0].normal, _mm256_castps256_ps128(N));
+        _mm_storeu_ps(out[0].tangent, _mm256_castps256_ps128(T));
+        _mm_storeu_ps(out[0].bitangent, _mm256_castps256_ps128(B));
+        _mm_storeu_ps(out[1].position, _mm256_extractf128_ps(P, 1));
+        _mm_storeu_ps(out[1].normal, _mm256_extractf128_ps(N, 1));
+        _mm_storeu_ps(out[1].tangent, _mm256_extractf128_ps(T, 1));
+        _mm_storeu_ps(out[1].bitangent, _mm256_extractf128_ps(B, 1));
+    }
+
+    _mm256_zeroupper();
+    skin_vertices_scalar(palette, weights, weight_counts + i, count - i, out);
+}
+
+/*
+Dispatch
+*/
+
+typedef void (*Matrix4MultiplyKernel)(const float*, const float*, float*);
+typedef void (*TransformPointsKernel)(const float*, const float*, float*, size_t);
+typedef void (*BlendPosesKernel)(const float*, const float*, float, float*, size_t);
+typedef void (*PosePaletteKernel)(const float*, size_t, size_t, float*);
+typedef void (*SkinVerticesKernel)(const float*, const SkinWeight*, const uint32_t*, size_t, SkinnedVertex*);
+
+// NOTE: these start out scalar (constant initialized) so that they're safe
+// to call from other static initializers before detection has run
+static Matrix4MultiplyKernel g_matrix4_multiply = matrix4_multiply_scalar;
+static TransformPointsKernel g_transform_points = transform_points_scalar;
+static BlendPosesKernel g_blend_poses = blend_poses_scalar;
+static PosePaletteKernel g_pose_palette = pose_palette_scalar;
+static SkinVerticesKernel g_skin_vertices = skin_vertices_scalar;
+static SIMDLevel g_simd_level = SIMDScalar;
+
+static SIMDLevel detect_simd_level()
+{
+#if !defined USE_SSE
+    return SIMDScalar;
+#else
+    SIMDLevel level = SIMDScalar;
+#if defined _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    const bool sse3 = 0 != (info[2] & (1 << 0));
+    const bool fma = 0 != (info[2] & (1 << 12));
+    const bool osxsave = 0 != (info[2] & (1 << 27));
+    const bool avx = 0 != (info[2] & (1 << 28));
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = 0 != (info[1] & (1 << 5));
+
+    // the OS has to save the ymm registers too
+    const bool ymm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+    if(sse3) {
+        level = SIMDSSE3;
+    }
+    if(avx && avx2 && fma && ymm) {
+        level = SIMDAVX2;
+    }
+#else
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse3")) {
+        level = SIMDSSE3;
+    }
+
+    // NOTE: this also checks that the OS saves the ymm registers
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        level = SIMDAVX2;
+    }
+#endif
+    return level;
+#endif
+}
+
+static SIMDLevel select_simd_level(SIMDLevel level)
+{
+    level = std::min(level, supported_simd_level());
+    switch(level)
+    {
+    case SIMDAVX2:
+        g_matrix4_multiply = matrix4_multiply_avx2;
+        g_transform_points = transform_points_avx2;
+        g_blend_poses = blend_poses_avx2;
+        g_pose_palette = pose_palette_avx2;
+        g_skin_vertices = skin_vertices_avx2;
+        break;
+#if defined USE_SSE
+    case SIMDSSE3:
+        g_matrix4_multiply = matrix4_multiply_sse3;
+        g_transform_points = transform_points_sse3;
+        g_blend_poses = blend_poses_sse3;
+        g_pose_palette = pose_palette_sse3;
+        g_skin_vertices = skin_vertices_sse3;
+        break;
+#endif
+    default:
+        level = SIMDScalar;
+        g_matrix4_multiply = matrix4_multiply_scalar;
+        g_transform_points = transform_points_scalar;
+        g_blend_poses = blend_poses_scalar;
+        g_pose_palette = pose_palette_scalar;
+        g_skin_vertices = skin_vertices_scalar;
+        break;
+    }
+
+    g_simd_level = level;
+    return level;
+}
+
+// picks the best kernels at startup
+static const SIMDLevel g_initial_simd_level = select_simd_level(SIMDAVX2);
+
+const char* simd_level_name(SIMDLevel level)
+{
+    switch(level)
+    {
+    case SIMDScalar:
+        return "scalar";
+    case SIMDSSE3:
+        return "sse3";
+    case SIMDAVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+SIMDLevel supported_simd_level()
+{
+    static const SIMDLevel level = detect_simd_level();
+    return level;
+}
+
+SIMDLevel simd_level()
+{
+    return g_simd_level;
+}
+
+SIMDLevel simd_level(SIMDLevel level)
+{
+    return select_simd_level(level);
+}
+
+void matrix4_multiply(const float* lhs, const float* rhs, float* out)
+{
+    g_matrix4_multiply(lhs, rhs, out);
+}
+
+void transform_points(const Matrix4& matrix, const float* in, float* out, size_t n)
+{
+    g_transform_points(matrix.array(), in, out, n);
+}
+
+void blend_poses(const float* a, const float* b, float t, float* out, size_t stride)
+{
+    g_blend_poses(a, b, t, out, stride);
+}
+
+void pose_palette(const float* pose, size_t stride, size_t count, float* palette)
+{
+    g_pose_palette(pose, stride, count, palette);
+}
+
+void skin_vertices(const float* palette, const SkinWeight* weights, const uint32_t* weight_counts, size_t count, SkinnedVertex* out)
+{
+    g_skin_vertices(palette, weights, weight_counts, count, out);
+}
+
+}
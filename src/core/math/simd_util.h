@@ -0,0 +1,112 @@
+#if !defined __SIMDUTIL_H__
+#define __SIMDUTIL_H__
+
+namespace energonsoftware {
+
+class Matrix4;
+
+// the vector instruction sets the math kernels can use
+// NOTE: these are ordered, each level includes the ones below it
+enum SIMDLevel
+{
+    SIMDScalar,
+    SIMDSSE3,
+    SIMDAVX2
+};
+
+const char* simd_level_name(SIMDLevel level);
+
+// the best level the cpu (and the build) supports, detected once
+SIMDLevel supported_simd_level();
+
+// the level the kernels are currently dispatching to
+SIMDLevel simd_level();
+
+// switches the kernels to a level (clamped to what's supported)
+// and returns the level that was actually selected
+// NOTE: this is meant for benchmarks and isn't thread safe
+SIMDLevel simd_level(SIMDLevel level);
+
+// out = lhs * rhs for row-major 4x4 matrices
+// NOTE: out must not alias lhs or rhs
+void matrix4_multiply(const float* lhs, const float* rhs, float* out);
+
+// transforms n tightly packed (x, y, z) points by the matrix, treating w as 1,
+// and writes n (x, y, z) points to out (the bottom row of the matrix is ignored)
+// NOTE: in and out may be the same array
+void transform_points(const Matrix4& matrix, const float* in, float* out, size_t n);
+
+/*
+Flat joint poses
+
+A pose is a single float buffer holding one stream per joint component,
+each stream pose_stride() floats long:
+
+[px ... | py ... | pz ... | qx ... | qy ... | qz ... | qw ...]
+
+Padding joints at the end of each stream must hold a valid (identity) transform.
+*/
+enum PoseStream
+{
+    PosePositionX,
+    PosePositionY,
+    PosePositionZ,
+    PoseOrientationX,
+    PoseOrientationY,
+    PoseOrientationZ,
+    PoseOrientationW,
+    PoseStreamCount
+};
+
+// joints per stream, padded out to a full AVX register
+inline size_t pose_stride(size_t joint_count) { return (joint_count + 7) & ~static_cast<size_t>(7); }
+inline size_t pose_size(size_t joint_count) { return pose_stride(joint_count) * PoseStreamCount; }
+
+// blends every joint of two poses, positions are lerped and orientations are nlerped,
+// falling back to slerp for joints that are too far apart for nlerp to hold up
+// NOTE: out must not alias a or b
+void blend_poses(const float* a, const float* b, float t, float* out, size_t stride);
+
+/*
+Matrix palette skinning
+
+A palette holds a 3x4 matrix for every joint in a pose, stored as 4 columns
+of 4 floats (the rotation columns and then the translation, each with a 0 w)
+so that each column is a single SIMD load.
+*/
+enum
+{
+    PaletteMatrixSize = 16
+};
+
+// a vertex influence in joint space
+struct SkinWeight
+{
+    // the position is pre-multiplied by the weight, which is stored in w
+    ALIGN(16) float position[4];
+    float normal[4];
+    float tangent[4];
+    float bitangent[4];
+    uint32_t joint;
+    uint32_t pad[3];
+};
+
+struct SkinnedVertex
+{
+    ALIGN(16) float position[4];
+    float normal[4];
+    float tangent[4];
+    float bitangent[4];
+};
+
+// builds the palette (count * PaletteMatrixSize floats) for a pose
+void pose_palette(const float* pose, size_t stride, size_t count, float* palette);
+
+// skins count vertices, vertex i has weight_counts[i] weights
+// and the weights are stored in vertex order
+// NOTE: the skinned normal, tangent and bitangent are normalized
+void skin_vertices(const float* palette, const SkinWeight* weights, const uint32_t* weight_counts, size_t count, SkinnedVertex* out);
+
+}
+
+#endif
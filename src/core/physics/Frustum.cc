@@ -0,0 +1,159 @@
+#include "src/pch.h"
+#include <immintrin.h>
+#include "src/core/math/Matrix4.h"
+#include "src/core/math/simd_util.h"
+#include "AABB.h"
+#include "Frustum.h"
+
+// the AVX test is compiled for AVX regardless of the build flags
+// and only ever called if the cpu supports it
+#if defined _MSC_VER
+    #define TARGET_AVX
+#else
+    #define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace energonsoftware {
+
+TARGET_AVX static uint32_t visible8(const float (*planes)[4], const float (*abs_normals)[4],
+    const float* cx, const float* cy, const float* cz, const float* ex, const float* ey, const float* ez)
+{
+    const __m256 CX = _mm256_loadu_ps(cx), CY = _mm256_loadu_ps(cy), CZ = _mm256_loadu_ps(cz);
+    const __m256 EX = _mm256_loadu_ps(ex), EY = _mm256_loadu_ps(ey), EZ = _mm256_loadu_ps(ez);
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 outside = zero;
+    for(int i=0; i<Frustum::PlaneCount; ++i) {
+        // signed distance from the center to the plane
+        __m256 S = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[i][0]), CX), _mm256_mul_ps(_mm256_set1_ps(planes[i][1]), CY));
+        S = _mm256_add_ps(S, _mm256_mul_ps(_mm256_set1_ps(planes[i][2]), CZ));
+        S = _mm256_add_ps(S, _mm256_set1_ps(planes[i][3]));
+
+        // extent projected onto the plane normal
+        __m256 R = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(abs_normals[i][0]), EX), _mm256_mul_ps(_mm256_set1_ps(abs_normals[i][1]), EY));
+        R = _mm256_add_ps(R, _mm256_mul_ps(_mm256_set1_ps(abs_normals[i][2]), EZ));
+
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(S, R), zero, _CMP_LT_OQ));
+    }
+    return ~_mm256_movemask_ps(outside) & 0xff;
+}
+
+#if defined USE_SSE
+static inline uint32_t visible4(const float (*planes)[4], const float (*abs_normals)[4],
+    const float* cx, const float* cy, const float* cz, const float* ex, const float* ey, const float* ez)
+{
+    const __m128 CX = _mm_loadu_ps(cx), CY = _mm_loadu_ps(cy), CZ = _mm_loadu_ps(cz);
+    const __m128 EX = _mm_loadu_ps(ex), EY = _mm_loadu_ps(ey), EZ = _mm_loadu_ps(ez);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 outside = zero;
+    for(int i=0; i<Frustum::PlaneCount; ++i) {
+        // signed distance from the center to the plane
+        __m128 S = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[i][0]), CX), _mm_mul_ps(_mm_set1_ps(planes[i][1]), CY));
+        S = _mm_add_ps(S, _mm_mul_ps(_mm_set1_ps(planes[i][2]), CZ));
+        S = _mm_add_ps(S, _mm_set1_ps(planes[i][3]));
+
+        // extent projected onto the plane normal
+        __m128 R = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(abs_normals[i][0]), EX), _mm_mul_ps(_mm_set1_ps(abs_normals[i][1]), EY));
+        R = _mm_add_ps(R, _mm_mul_ps(_mm_set1_ps(abs_normals[i][2]), EZ));
+
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(S, R), zero));
+    }
+    return ~_mm_movemask_ps(outside) & 0xf;
+}
+#endif
+
+Frustum::Frustum()
+{
+    std::memset(_planes, 0, sizeof(_planes));
+    std::memset(_abs_normals, 0, sizeof(_abs_normals));
+}
+
+Frustum::Frustum(const Matrix4& clipping)
+{
+    extract(clipping);
+}
+
+Frustum::~Frustum() throw()
+{
+}
+
+void Frustum::extract(const Matrix4& clipping)
+{
+    const float* const m = clipping.array();
+    const float* const r0 = m + 0;
+    const float* const r1 = m + 4;
+    const float* const r2 = m + 8;
+    const float* const r3 = m + 12;
+
+    for(int i=0; i<4; ++i) {
+        _planes[LeftPlane][i] = r3[i] + r0[i];
+        _planes[RightPlane][i] = r3[i] - r0[i];
+        _planes[BottomPlane][i] = r3[i] + r1[i];
+        _planes[TopPlane][i] = r3[i] - r1[i];
+        _planes[NearPlane][i] = r3[i] + r2[i];
+        _planes[FarPlane][i] = r3[i] - r2[i];
+    }
+
+    for(int i=0; i<PlaneCount; ++i) {
+        float* const plane = _planes[i];
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if(length > 0.0f) {
+            for(int j=0; j<4; ++j) {
+                plane[j] /= length;
+            }
+        }
+
+        _abs_normals[i][0] = std::fabs(plane[0]);
+        _abs_normals[i][1] = std::fabs(plane[1]);
+        _abs_normals[i][2] = std::fabs(plane[2]);
+        _abs_normals[i][3] = 0.0f;
+    }
+}
+
+bool Frustum::visible(const AABB& bounds) const
+{
+    const Point3& minimum(bounds.minimum());
+    const Point3& maximum(bounds.maximum());
+    return visible((minimum.x() + maximum.x()) * 0.5f, (minimum.y() + maximum.y()) * 0.5f, (minimum.z() + maximum.z()) * 0.5f,
+        (maximum.x() - minimum.x()) * 0.5f, (maximum.y() - minimum.y()) * 0.5f, (maximum.z() - minimum.z()) * 0.5f);
+}
+
+bool Frustum::visible(float cx, float cy, float cz, float ex, float ey, float ez) const
+{
+    for(int i=0; i<PlaneCount; ++i) {
+        const float s = _planes[i][0] * cx + _planes[i][1] * cy + _planes[i][2] * cz + _planes[i][3];
+        const float r = _abs_normals[i][0] * ex + _abs_normals[i][1] * ey + _abs_normals[i][2] * ez;
+        if(s + r < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t Frustum::visible(const float* cx, const float* cy, const float* cz,
+    const float* ex, const float* ey, const float* ez, size_t count) const
+{
+    assert(count <= MaxBatch);
+
+    uint32_t mask = 0;
+    size_t i = 0;
+    if(simd_level() >= SIMDAVX2) {
+        for(; i+8<=count; i+=8) {
+            mask |= visible8(_planes, _abs_normals, cx + i, cy + i, cz + i, ex + i, ey + i, ez + i) << i;
+        }
+    }
+#if defined USE_SSE
+    for(; i+4<=count; i+=4) {
+        mask |= visible4(_planes, _abs_normals, cx + i, cy + i, cz + i, ex + i, ey + i, ez + i) << i;
+    }
+#endif
+    for(; i<count; ++i) {
+        if(visible(cx[i], cy[i], cz[i], ex[i], ey[i], ez[i])) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+}
@@ -0,0 +1,74 @@
+#if !defined __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+namespace energonsoftware {
+
+class AABB;
+class Matrix4;
+
+/*
+The six world-space view frustum planes
+
+Extract the planes once per frame from the clipping (projection * view) matrix
+(Gribb and Hartmann, Fast Extraction of Viewing Frustum Planes from the
+World-View-Projection Matrix) and then test bounds against them.
+
+Boxes are tested with the center/extent method: a box is outside a plane
+if its center is further behind the plane than the box's extent projected
+onto the plane normal. The batch test runs 4 (SSE) or 8 (AVX, picked at runtime
+along with the simd_util kernels) boxes at a time over boxes stored as separate
+center and extent arrays.
+
+NOTE: like the corner outcode test this is conservative, boxes that straddle
+two planes near a frustum corner may be reported visible
+*/
+class Frustum
+{
+public:
+    enum Planes
+    {
+        LeftPlane,
+        RightPlane,
+        BottomPlane,
+        TopPlane,
+        NearPlane,
+        FarPlane,
+        PlaneCount
+    };
+
+    enum
+    {
+        // the most boxes visible() tests per call
+        MaxBatch = 32
+    };
+
+public:
+    Frustum();
+    explicit Frustum(const Matrix4& clipping);
+    virtual ~Frustum() throw();
+
+public:
+    void extract(const Matrix4& clipping);
+
+    // the normalized plane (a, b, c, d) where ax + by + cz + d >= 0 is inside
+    const float* plane(Planes plane) const { return _planes[plane]; }
+
+    // returns true if some portion of the box is inside the frustum
+    bool visible(const AABB& bounds) const;
+    bool visible(float cx, float cy, float cz, float ex, float ey, float ez) const;
+
+    // tests count (at most MaxBatch) boxes given as center and extent arrays
+    // and returns a mask with bit i set if box i is at least partly inside
+    uint32_t visible(const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, size_t count) const;
+
+private:
+    float _planes[PlaneCount][4];
+
+    // the absolute values of the plane normals for the extent projection
+    float _abs_normals[PlaneCount][4];
+};
+
+}
+
+#endif
@@ -1,14 +1,27 @@
 #include "src/pch.h"
 #include "src/core/math/math_util.h"
 #include "src/core/math/Matrix4.h"
-#include "src/core/util/util.h"
+#include "src/core/thread/thread_util.h"
 #include "Physical.h"
 
 namespace energonsoftware {
 
+static void simulate_batch(const std::vector<boost::shared_ptr<Physical> >& physicals, double now, double dt, size_t begin, size_t end)
+{
+    for(size_t i=begin; i<end; ++i) {
+        physicals[i]->simulate(now, dt);
+    }
+}
+
+void Physical::simulate_all(ThreadPool& pool, const std::vector<boost::shared_ptr<Physical> >& physicals, double now, double dt)
+{
+    parallel_for(pool, 0, physicals.size(), SimulateBatchSize,
+        boost::bind(&simulate_batch, boost::cref(physicals), now, dt, _1, _2));
+}
+
 Physical::Physical()
     : _view(0.0f, 0.0f, 1.0f), _up(0.0f, 1.0f, 0.0f),
-        _mass(1.0f), _scale(1.0f), _last_simulate(get_time())
+        _mass(1.0f), _scale(1.0f), _last_simulate(0.0)
 {
 }
 
@@ -18,40 +31,32 @@ Physical::~Physical() throw()
 
 void Physical::position(const Position& position)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-    _position = position;
+    _previous_position = _position = position;
 }
 
 void Physical::view(const Direction& view)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
     _view = view;
 }
 
 void Physical::up(const Direction& up)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
     _up = up;
 }
 
 void Physical::orientation(const Quaternion& orientation)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-    _orientation = orientation;
+    _previous_orientation = _orientation = orientation;
 }
 
 void Physical::rotate(float angle, const Vector3& around)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-
     Quaternion q(Quaternion::new_axis(angle, around));
     _orientation = q * _orientation;
 }
 
 void Physical::pitch(float angle)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-
     // need to pitch against our local x-axis
     // TODO: need a better explanation for why this is a special case!
     Quaternion q(Quaternion::new_axis(angle, Vector3(1.0f, 0.0f, 0.0f)));
@@ -68,6 +73,14 @@ void Physical::roll(float angle)
     rotate(angle, Vector3(0.0f, 0.0f, 1.0f));
 }
 
+void Physical::follow(const Physical& physical)
+{
+    _previous_position = physical._previous_position;
+    _position = physical._position;
+    _previous_orientation = physical._previous_orientation;
+    _orientation = physical._orientation;
+}
+
 void Physical::transform(Matrix4& matrix) const
 {
     matrix.translate(_position);
@@ -75,12 +88,30 @@ void Physical::transform(Matrix4& matrix) const
     matrix.uniform_scale(_scale);
 }
 
-void Physical::simulate()
+void Physical::transform(Matrix4& matrix, float alpha) const
+{
+    matrix.translate(interpolated_position(alpha));
+    matrix *= interpolated_orientation(alpha).matrix();
+    matrix.uniform_scale(_scale);
+}
+
+void Physical::snapshot(Snapshot& snapshot) const
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+    snapshot.previous_position = _previous_position;
+    snapshot.position = _position;
+    snapshot.previous_orientation = _previous_orientation;
+    snapshot.orientation = _orientation;
+    snapshot.view = _view;
+    snapshot.up = _up;
+    snapshot.scale = _scale;
+    snapshot.relative_bounds = _bounds;
+}
 
-    const double now = get_time();
-    const double dt = now - _last_simulate;
+void Physical::simulate(double now, double dt)
+{
+    // the renderer interpolates from here
+    _previous_position = _position;
+    _previous_orientation = _orientation;
 
     if(!on_simulate(dt)) {
         return;
@@ -95,6 +126,13 @@ void Physical::simulate()
     _last_simulate = now;
 }
 
+void Physical::Snapshot::transform(Matrix4& matrix, float alpha) const
+{
+    matrix.translate(interpolated_position(alpha));
+    matrix *= interpolated_orientation(alpha).matrix();
+    matrix.uniform_scale(scale);
+}
+
 std::string Physical::str() const
 {
     // TODO: expand this
@@ -8,13 +8,49 @@
 namespace energonsoftware {
 
 class Matrix4;
+class ThreadPool;
 
 class Physical
 {
+public:
+    enum
+    {
+        // physicals per job when simulating in parallel
+        SimulateBatchSize = 32
+    };
+
+    // an immutable copy of the state the renderer needs
+    // taken by the update thread after each simulation step
+    struct Snapshot
+    {
+        Position previous_position, position;
+        Quaternion previous_orientation, orientation;
+        Direction view, up;
+        float scale;
+        AABB relative_bounds;
+
+        Snapshot() : scale(1.0f) {}
+
+        Position interpolated_position(float alpha) const { return previous_position.lerp(position, alpha); }
+        Quaternion interpolated_orientation(float alpha) const { return previous_orientation.lerp(orientation, alpha); }
+        AABB absolute_bounds() const { return position + relative_bounds; }
+
+        // see Physical::transform()
+        void transform(Matrix4& matrix, float alpha) const;
+    };
+
+public:
+    // simulates every physical, in batches spread across the pool
+    // NOTE: physicals must not touch each other while simulating
+    static void simulate_all(ThreadPool& pool, const std::vector<boost::shared_ptr<Physical> >& physicals, double now, double dt);
+
 public:
     virtual ~Physical() throw();
 
 public:
+    // NOTE: the position and orientation setters place the physical,
+    // so it doesn't interpolate in from wherever it was before
+    // (rotate() and friends move it like a simulation step would)
     const Position& position() const { return _position; }
     void position(const Position& position);
 
@@ -43,6 +79,14 @@ public:
     // useful for generating the model matrix for this physical
     void transform(Matrix4& matrix) const;
 
+    // same as transform(), but blends between the previous and current
+    // simulation states (alpha is in [0, 1], 1 being the current state)
+    // NOTE: the renderer uses this to smooth out the fixed simulation rate
+    void transform(Matrix4& matrix, float alpha) const;
+
+    Position interpolated_position(float alpha) const { return _previous_position.lerp(_position, alpha); }
+    Quaternion interpolated_orientation(float alpha) const { return _previous_orientation.lerp(_orientation, alpha); }
+
     const Vector3& velocity() const { return _velocity; }
     void velocity(const Vector3& velocity) { _velocity = velocity; }
 
@@ -57,7 +101,14 @@ public:
     AABB absolute_bounds() const { return _position + _bounds; }
     const AABB& relative_bounds() const { return _bounds; }
 
-    void simulate();
+    // advances the physical by one fixed step of dt seconds
+    // NOTE: now is the simulation time of the step, sampled once and shared by every physical
+    void simulate(double now, double dt);
+
+    double last_simulate() const { return _last_simulate; }
+
+    // NOTE: update thread only
+    void snapshot(Snapshot& snapshot) const;
 
     virtual std::string str() const;
 
@@ -67,16 +118,25 @@ protected:
     // NOTE: relative to the physical's position
     void bounds(const AABB& bounds) { _bounds = bounds; }
 
+    // takes on the other physical's position and orientation,
+    // including the states it's interpolating between
+    void follow(const Physical& physical);
+
     virtual bool on_simulate(double dt) { return true; }
 
 private:
-    boost::recursive_mutex _mutex;
+    // NOTE: physicals are only touched by the update thread (and its jobs),
+    // the render thread reads Snapshots instead so there's no locking here
 
     // "camera" properties
     Position _position;
     Direction _view, _up;
     Quaternion _orientation;
 
+    // state as of the previous simulation step
+    Position _previous_position;
+    Quaternion _previous_orientation;
+
     // physical properties
     Vector3 _velocity, _acceleration;
     float _mass;
@@ -3,11 +3,16 @@
 
 namespace energonsoftware {
 
+class JobCounter;
+class ThreadPool;
+
+// NOTE: the ThreadPool buckets priorities into lanes,
+// see ThreadPool for details
 class BaseJob
 {
 public:
     explicit BaseJob(int priority=0)
-        : _priority(priority)
+        : _priority(priority), _next(NULL), _counter(NULL), _owned(false)
     {
     }
 
@@ -23,7 +28,18 @@ protected:
     virtual void on_process_work() = 0;
 
 private:
+    friend class ThreadPool;
+
     int _priority;
+
+    // intrusive link for the pool's queues
+    BaseJob* _next;
+
+    // decremented by the pool once the job has run
+    JobCounter* _counter;
+
+    // the pool deletes jobs that it owns once they've run
+    bool _owned;
 };
 
 }
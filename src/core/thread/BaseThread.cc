@@ -42,6 +42,9 @@ void BaseThread::start()
     stop();
     _quit = false;
     _own_thread = true;
+
+    // NOTE: run() waits on this so that _thread is valid before it starts
+    boost::lock_guard<boost::mutex> guard(_start_mutex);
     _thread = new boost::thread(boost::bind(&BaseThread::run, this));
 }
 
@@ -88,7 +91,9 @@ void BaseThread::run()
 {
     // NOTE: must use _name here because _thread isn't valid yet
     LOG_DEBUG("Waiting for thread '" << _name << "' to start...\n");
-    while(!_thread) {}
+    {
+        boost::lock_guard<boost::mutex> guard(_start_mutex);
+    }
 
     LOG_DEBUG("Running thread '" << name() << "'\n");
     //LOG_DEBUG(str() << "\n");
@@ -97,19 +102,16 @@ void BaseThread::run()
     while(!should_quit() && !boost::this_thread::interruption_requested()) {
         try {
             if(pool()) {
-                boost::unique_lock<boost::recursive_mutex> guard(*(pool()), boost::try_to_lock);
-                if(guard.owns_lock()) {
-                    if(pool()->has_work()) {
-                        boost::shared_ptr<BaseJob> job(pool()->pop_work());
-                        job->process_work();
-                    }
+                // NOTE: this parks the thread when there's no work
+                if(!pool()->process_work()) {
+                    quit();
                 }
             } else {
-               on_run();
-            }
+                on_run();
 
-            boost::this_thread::sleep(boost::posix_time::microseconds(thread_sleep_time()));
-            //boost::this_thread::yield();
+                boost::this_thread::sleep(boost::posix_time::microseconds(thread_sleep_time()));
+                //boost::this_thread::yield();
+            }
         } catch(const boost::thread_interrupted&) {
             quit();
         } catch(const std::exception& e) {
@@ -137,4 +139,18 @@ ThreadFactory::~ThreadFactory() throw()
 {
 }
 
+BaseThreadFactory::BaseThreadFactory()
+    : ThreadFactory()
+{
+}
+
+BaseThreadFactory::~BaseThreadFactory() throw()
+{
+}
+
+BaseThread* BaseThreadFactory::new_thread(ThreadPool* pool) const throw()
+{
+    return new BaseThread(pool);
+}
+
 }
@@ -20,6 +20,9 @@ public:
 public:
     std::string name() const;
 
+    // NOTE: this is not-a-thread until start() has been called
+    boost::thread::id id() const { return NULL != _thread ? _thread->get_id() : boost::thread::id(); }
+
     void start();
 
     void quit() { _quit = true; }
@@ -35,9 +38,6 @@ public:
     std::string str() const;
 
 protected:
-    // NOTE: be *extremely* careful when locking this
-    // as a deadlock situation exists when the pool is stopped.
-    // Use a unique_lock with try_lock() rather than a lock_guard to be safe
     ThreadPool* pool() { return _pool; }
     const ThreadPool* pool() const { return _pool; }
 
@@ -55,6 +55,9 @@ private:
     boost::thread* _thread;
     bool _own_thread;
 
+    // held while the thread is being started
+    boost::mutex _start_mutex;
+
 private:
     DISALLOW_COPY_AND_ASSIGN(BaseThread);
 };
@@ -71,6 +74,17 @@ public:
     virtual BaseThread* new_thread(ThreadPool* pool=NULL) const throw() = 0;
 };
 
+// creates plain pool threads that just run jobs
+class BaseThreadFactory : public ThreadFactory
+{
+public:
+    BaseThreadFactory();
+    virtual ~BaseThreadFactory() throw();
+
+public:
+    virtual BaseThread* new_thread(ThreadPool* pool=NULL) const throw();
+};
+
 }
 
 #endif
@@ -0,0 +1,43 @@
+#if !defined __JOBCOUNTER_H__
+#define __JOBCOUNTER_H__
+
+namespace energonsoftware {
+
+/*
+Counts outstanding jobs so that a thread can wait on a batch of them.
+
+Pass one to ThreadPool::push_work() and it's incremented when the job is
+pushed and decremented once the job has run. ThreadPool::wait() runs
+other work while the counter is non-zero rather than blocking.
+*/
+class JobCounter
+{
+public:
+    JobCounter()
+        : _count(0)
+    {
+    }
+
+    virtual ~JobCounter() throw()
+    {
+    }
+
+public:
+    size_t count() const { return _count.load(boost::memory_order_acquire); }
+    bool done() const { return 0 == count(); }
+
+    void increment(size_t count=1) { _count.fetch_add(count, boost::memory_order_relaxed); }
+
+    // NOTE: release so the waiting thread sees everything the job wrote
+    void decrement() { _count.fetch_sub(1, boost::memory_order_release); }
+
+private:
+    boost::atomic<size_t> _count;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(JobCounter);
+};
+
+}
+
+#endif
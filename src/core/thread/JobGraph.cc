@@ -0,0 +1,85 @@
+#include "src/pch.h"
+#include "ThreadPool.h"
+#include "JobGraph.h"
+
+namespace energonsoftware {
+
+JobGraph::Node::Node(JobGraph& graph, const std::string& name, const Function& function, int priority)
+    : BaseJob(priority), _graph(graph), _name(name), _function(function), _dependency_count(0), _waiting(0)
+{
+}
+
+JobGraph::Node::~Node() throw()
+{
+}
+
+void JobGraph::Node::on_process_work()
+{
+    _function();
+
+    // NOTE: the dependents are pushed before our counter is decremented
+    // so the graph counter can't hit zero until everything has run
+    BOOST_FOREACH(Node* dependent, _dependents) {
+        if(1 == dependent->_waiting.fetch_sub(1, boost::memory_order_acq_rel)) {
+            _graph._pool->push_work(*dependent, &_graph._counter);
+        }
+    }
+}
+
+JobGraph::JobGraph()
+    : _pool(NULL)
+{
+}
+
+JobGraph::~JobGraph() throw()
+{
+}
+
+JobGraph::Node* JobGraph::add(const std::string& name, const Function& function, int priority)
+{
+    assert(NULL == _pool);
+
+    boost::shared_ptr<Node> node(new Node(*this, name, function, priority));
+    _nodes.push_back(node);
+    return node.get();
+}
+
+void JobGraph::depend(Node* job, Node* dependency)
+{
+    assert(NULL == _pool);
+    assert(job != dependency);
+
+    dependency->_dependents.push_back(job);
+    job->_dependency_count++;
+}
+
+void JobGraph::run(ThreadPool& pool)
+{
+    assert(NULL == _pool);
+    _pool = &pool;
+
+    BOOST_FOREACH(boost::shared_ptr<Node> node, _nodes) {
+        node->_waiting.store(node->_dependency_count, boost::memory_order_relaxed);
+    }
+
+    bool has_roots = false;
+    BOOST_FOREACH(boost::shared_ptr<Node> node, _nodes) {
+        if(0 == node->_dependency_count) {
+            pool.push_work(*node, &_counter);
+            has_roots = true;
+        }
+    }
+    assert(has_roots || _nodes.empty());
+    (void)has_roots;    // only used by the assert
+
+    pool.wait(_counter);
+    _pool = NULL;
+}
+
+void JobGraph::clear()
+{
+    assert(NULL == _pool);
+    _nodes.clear();
+}
+
+}
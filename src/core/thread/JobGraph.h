@@ -0,0 +1,98 @@
+#if !defined __JOBGRAPH_H__
+#define __JOBGRAPH_H__
+
+#include "BaseJob.h"
+#include "JobCounter.h"
+
+namespace energonsoftware {
+
+class ThreadPool;
+
+/*
+A set of jobs with dependencies between them that runs across a ThreadPool.
+
+The same ordering Scene::update() uses, with the camera following
+whatever it's attached to once the physicals have moved:
+
+JobGraph graph;
+JobGraph::Node* physicals = graph.add("physicals", boost::bind(&Physical::simulate_all, boost::ref(pool), boost::cref(_physicals), now, dt));
+JobGraph::Node* camera = graph.add("camera", boost::bind(&Physical::simulate, &_camera, now, dt));
+graph.depend(camera, physicals);
+graph.run(pool);
+
+A job is pushed to the pool as soon as everything it depends on has finished.
+A graph can be run again once run() returns, but the functions are
+bound when they're added, so a graph whose arguments change
+(like the one above) needs to be rebuilt with clear() first.
+
+NOTE: the graph must not have cycles
+*/
+class JobGraph
+{
+public:
+    typedef boost::function<void ()> Function;
+
+    class Node : public BaseJob
+    {
+    public:
+        virtual ~Node() throw();
+
+    public:
+        const std::string& name() const { return _name; }
+
+    protected:
+        virtual void on_process_work();
+
+    private:
+        friend class JobGraph;
+        Node(JobGraph& graph, const std::string& name, const Function& function, int priority);
+
+    private:
+        JobGraph& _graph;
+        std::string _name;
+        Function _function;
+
+        std::vector<Node*> _dependents;
+        size_t _dependency_count;
+
+        // dependencies that haven't finished yet this run
+        boost::atomic<size_t> _waiting;
+
+    private:
+        Node();
+        DISALLOW_COPY_AND_ASSIGN(Node);
+    };
+
+public:
+    JobGraph();
+    virtual ~JobGraph() throw();
+
+public:
+    // NOTE: the graph owns the node
+    Node* add(const std::string& name, const Function& function, int priority=0);
+
+    // job won't run until dependency has finished
+    void depend(Node* job, Node* dependency);
+
+    // runs every job and waits for them all to finish,
+    // running work on the calling thread while it waits
+    void run(ThreadPool& pool);
+
+    void clear();
+
+    size_t size() const { return _nodes.size(); }
+
+private:
+    std::vector<boost::shared_ptr<Node> > _nodes;
+
+    // set while running
+    ThreadPool* _pool;
+    JobCounter _counter;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(JobGraph);
+};
+
+}
+
+#endif
@@ -6,69 +6,344 @@ namespace energonsoftware {
 
 Logger& ThreadPool::logger(Logger::instance("energonsoftware.core.thread.ThreadPool"));
 
+void ThreadPool::destroy(ThreadPool* const pool, MemoryAllocator* const allocator)
+{
+    pool->~ThreadPool();
+    operator delete(pool, *allocator);
+}
+
 ThreadPool::ThreadPool(size_t size)
-    : boost::recursive_mutex(), _size(size), _running(false)
+    : _size(size), _running(false), _next_worker(0), _current_worker(&ThreadPool::no_cleanup), _pending(0), _parked(0)
 {
 }
 
 ThreadPool::~ThreadPool() throw()
 {
     stop();
+
+    // discard anything that didn't get run
+    // NOTE: jobs we don't own belong to whoever submitted them
+    for(size_t i=0; i<LaneCount; ++i) {
+        BaseJob* job = NULL;
+        while(NULL != (job = pop_injected(static_cast<Lane>(i)))) {
+            if(job->_owned) {
+                delete job;
+            }
+        }
+    }
 }
 
 void ThreadPool::start(const ThreadFactory& factory)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(*this);
+    boost::lock_guard<boost::mutex> guard(_mutex);
 
-    stop();
+    stop_threads();
 
     if(_size == 0) {
         return;
     }
 
+    _workers.reset(new Worker[_size]);
+    for(size_t i=0; i<_size; ++i) {
+        // NOTE: xorshift can't be seeded with 0
+        _workers[i].seed = i + 1;
+    }
+    _next_worker = 0;
+
+    // NOTE: the threads check this, so it must be set before they start
+    _running = true;
+
     LOG_INFO("Initializing " << _size << " threads...\n");
     for(size_t i=0; i<_size; ++i) {
         BaseThread* thread = factory.new_thread(this);
         thread->start();
         _threads.add_thread(thread->release());
     }
-    _running = true;
 }
 
-void ThreadPool::push_work(BaseJob* job)
+void ThreadPool::push_work(BaseJob* job, JobCounter* counter)
+{
+    job->_owned = true;
+    push(job, counter);
+}
+
+void ThreadPool::push_work(BaseJob& job, JobCounter* counter)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(*this);
+    job._owned = false;
+    push(&job, counter);
+}
 
-    _work.push(boost::shared_ptr<BaseJob>(job));
+bool ThreadPool::try_process_work()
+{
+    BaseJob* job = find_work(current_worker());
+    if(NULL == job) {
+        return false;
+    }
+
+    run_job(job);
+    return true;
 }
 
-bool ThreadPool::has_work()
+void ThreadPool::wait(const JobCounter& counter)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(*this);
+    while(!counter.done()) {
+        if(!try_process_work()) {
+            // whatever we're waiting on is running on another thread
+            boost::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::push(BaseJob* job, JobCounter* counter)
+{
+    job->_counter = counter;
+    if(NULL != counter) {
+        counter->increment();
+    }
+
+    // NOTE: counted before it's visible so a worker can't see it and underflow the count
+    _pending.fetch_add(1, boost::memory_order_seq_cst);
+
+    const Lane l = lane(job->priority());
 
-    return !_work.empty();
+    Worker* worker = current_worker();
+    if(NULL != worker) {
+        worker->work[l].push(job);
+    } else {
+        inject(job, l);
+    }
+
+    wake_one();
 }
 
-boost::shared_ptr<BaseJob> ThreadPool::pop_work()
+bool ThreadPool::process_work()
 {
-    boost::lock_guard<boost::recursive_mutex> guard(*this);
+    if(!running()) {
+        return false;
+    }
+
+    Worker* worker = current_worker();
+    if(NULL == worker) {
+        // first time through on this thread, claim a worker
+        const size_t index = _next_worker.fetch_add(1);
+        assert(index < _size);
 
-    boost::shared_ptr<BaseJob> ret(_work.top());
-    _work.pop();
-    return ret;
+        worker = &_workers[index];
+        _current_worker.reset(worker);
+    }
+
+    BaseJob* job = find_work(worker);
+    if(NULL != job) {
+        worker->idle = 0;
+        run_job(job);
+        return true;
+    }
+
+    // spin a little before giving up the core in case more work is on the way
+    if(++worker->idle < IdleSpinCount) {
+        boost::this_thread::yield();
+        return true;
+    }
+
+    worker->idle = 0;
+    park();
+    return running();
 }
 
 void ThreadPool::stop()
 {
-    boost::lock_guard<boost::recursive_mutex> guard(*this);
+    boost::lock_guard<boost::mutex> guard(_mutex);
 
+    stop_threads();
+}
+
+void ThreadPool::stop_threads()
+{
     if(running()) {
         LOG_INFO("Waiting for " << _size << " threads to finish...\n");
+        _running = false;
+        wake_all();
+
         _threads.interrupt_all();
         _threads.join_all();
         LOG_DEBUG("Finished!\n");
     }
-    _running = false;
+
+    if(NULL == _workers.get()) {
+        return;
+    }
+
+    // hang on to anything that didn't get run in case the pool is restarted
+    // NOTE: the threads are gone, so it's safe to pop from their deques here
+    for(size_t i=0; i<_size; ++i) {
+        for(size_t j=0; j<LaneCount; ++j) {
+            BaseJob* job = NULL;
+            while(NULL != (job = _workers[i].work[j].pop())) {
+                inject(job, static_cast<Lane>(j));
+            }
+        }
+    }
+    _workers.reset();
+}
+
+ThreadPool::Worker* ThreadPool::current_worker()
+{
+    return _current_worker.get();
+}
+
+BaseJob* ThreadPool::find_work(Worker* worker)
+{
+    if(0 == _pending.load(boost::memory_order_acquire)) {
+        return NULL;
+    }
+
+    for(int i=LaneCount-1; i>=0; --i) {
+        const Lane l = static_cast<Lane>(i);
+
+        BaseJob* job = NULL;
+        if(NULL != worker) {
+            job = worker->work[l].pop();
+        }
+
+        if(NULL == job) {
+            job = pop_injected(l);
+        }
+
+        if(NULL == job) {
+            job = steal(worker, l);
+        }
+
+        if(NULL != job) {
+            _pending.fetch_sub(1, boost::memory_order_relaxed);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+void ThreadPool::inject(BaseJob* job, Lane lane)
+{
+    InjectionQueue& queue(_injected[lane]);
+    boost::lock_guard<boost::mutex> guard(queue.mutex);
+
+    job->_next = NULL;
+    if(NULL != queue.tail) {
+        queue.tail->_next = job;
+    } else {
+        queue.head = job;
+    }
+    queue.tail = job;
+    queue.size.fetch_add(1, boost::memory_order_release);
+}
+
+BaseJob* ThreadPool::pop_injected(Lane lane)
+{
+    InjectionQueue& queue(_injected[lane]);
+    if(0 == queue.size.load(boost::memory_order_acquire)) {
+        return NULL;
+    }
+
+    boost::lock_guard<boost::mutex> guard(queue.mutex);
+
+    BaseJob* job = queue.head;
+    if(NULL != job) {
+        queue.head = job->_next;
+        if(NULL == queue.head) {
+            queue.tail = NULL;
+        }
+        job->_next = NULL;
+        queue.size.fetch_sub(1, boost::memory_order_relaxed);
+    }
+    return job;
+}
+
+BaseJob* ThreadPool::steal(Worker* worker, Lane lane)
+{
+    if(NULL == _workers.get()) {
+        return NULL;
+    }
+
+    // start at a random victim so the thieves spread out
+    size_t start = 0;
+    if(NULL != worker) {
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 17;
+        worker->seed ^= worker->seed << 5;
+        start = worker->seed % _size;
+    }
+
+    for(size_t i=0; i<_size; ++i) {
+        Worker& victim(_workers[(start + i) % _size]);
+        if(&victim == worker) {
+            continue;
+        }
+
+        BaseJob* job = NULL;
+        WorkStealingDeque<BaseJob>::StealResult result;
+        while(WorkStealingDeque<BaseJob>::StealAbort == (result = victim.work[lane].steal(job))) {
+        }
+
+        if(WorkStealingDeque<BaseJob>::StealSuccess == result) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+void ThreadPool::run_job(BaseJob* job)
+{
+    // NOTE: the job may be destroyed by its owner as soon as
+    // the counter is decremented, so don't touch it after that
+    JobCounter* counter = job->_counter;
+
+    // owned jobs go away even if they throw
+    boost::scoped_ptr<BaseJob> owned(job->_owned ? job : NULL);
+
+    try {
+        job->process_work();
+    } catch(...) {
+        if(NULL != counter) {
+            counter->decrement();
+        }
+        throw;
+    }
+
+    if(NULL != counter) {
+        counter->decrement();
+    }
+}
+
+void ThreadPool::park()
+{
+    // NOTE: parking and pushing both touch _pending and _parked with
+    // sequential consistency, so either the parking thread sees the new work
+    // or the pushing thread sees the parked thread and takes the lock to wake it
+    boost::unique_lock<boost::mutex> guard(_park_mutex);
+
+    _parked.fetch_add(1, boost::memory_order_seq_cst);
+    while(running() && 0 == _pending.load(boost::memory_order_seq_cst)) {
+        // stop() wakes everyone before it interrupts,
+        // so don't let the interruption leave _parked off
+        boost::this_thread::disable_interruption di;
+        _park_condition.wait(guard);
+    }
+    _parked.fetch_sub(1, boost::memory_order_seq_cst);
+}
+
+void ThreadPool::wake_one()
+{
+    if(0 == _parked.load(boost::memory_order_seq_cst)) {
+        return;
+    }
+
+    boost::lock_guard<boost::mutex> guard(_park_mutex);
+    _park_condition.notify_one();
+}
+
+void ThreadPool::wake_all()
+{
+    boost::lock_guard<boost::mutex> guard(_park_mutex);
+    _park_condition.notify_all();
 }
 
 }
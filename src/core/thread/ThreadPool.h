@@ -2,49 +2,158 @@
 #define __THREADPOOL_H__
 
 #include "BaseJob.h"
+#include "JobCounter.h"
+#include "WorkStealingDeque.h"
 
 namespace energonsoftware {
 
 class ThreadFactory;
 
-struct base_job_less : public std::binary_function<boost::shared_ptr<BaseJob>, boost::shared_ptr<BaseJob>, bool>
-{
-    bool operator()(const boost::shared_ptr<BaseJob>& lhs, const boost::shared_ptr<BaseJob>& rhs) const
-    { return lhs->priority() < rhs->priority(); }
-};
+/*
+Work-stealing thread pool
+
+Each worker owns a Chase-Lev deque per priority lane. Work pushed from
+inside a job goes on the pushing worker's own deque, work pushed from
+any other thread goes on a locked injection queue, and idle workers
+steal from each other before they park.
 
-class ThreadPool : public boost::recursive_mutex
+Jobs are linked intrusively and handed around as raw pointers, so pushing
+and popping work doesn't allocate (aside from the occasional deque growth).
+
+Job priorities are bucketed into lanes (negative, zero and positive),
+higher lanes are always drained first.
+*/
+class ThreadPool
 {
+public:
+    enum Lane
+    {
+        LaneLow,
+        LaneNormal,
+        LaneHigh,
+        LaneCount
+    };
+
+    enum
+    {
+        // how many times an idle worker yields before it parks
+        IdleSpinCount = 64
+    };
+
 private:
     static Logger& logger;
 
+    static Lane lane(int priority) { return priority > 0 ? LaneHigh : (priority < 0 ? LaneLow : LaneNormal); }
+
+public:
+    static void destroy(ThreadPool* const pool, MemoryAllocator* const allocator);
+
 public:
     explicit ThreadPool(size_t size);
     virtual ~ThreadPool() throw();
 
 public:
+    size_t size() const { return _size; }
+
     // starts the threads in the pool
     void start(const ThreadFactory& factory);
 
     // adds work to the pool
     // NOTE: job must have been declared with new and the pool takes ownership of it
-    void push_work(BaseJob* job);
+    void push_work(BaseJob* job, JobCounter* counter=NULL);
+
+    // adds work to the pool without giving it ownership
+    // NOTE: job must stay alive until it has run (wait on the counter)
+    void push_work(BaseJob& job, JobCounter* counter=NULL);
+
+    // runs a single job if there is one, from any thread
+    // returns false if there was nothing to run
+    bool try_process_work();
+
+    // runs other work until the counter reaches zero (fork-join)
+    // NOTE: safe to call from inside a job
+    void wait(const JobCounter& counter);
 
-    bool has_work();
+    // NOTE: this is only a hint, the work may be gone by the time the caller acts on it
+    bool has_work() const { return _pending.load(boost::memory_order_relaxed) > 0; }
 
-    // gets work from the pool
-    boost::shared_ptr<BaseJob> pop_work();
+    // runs a single job, or parks the calling thread until there is work
+    // returns false if the pool is stopping and the calling thread should quit
+    // NOTE: this is called by the pool threads
+    bool process_work();
 
     // stops all threads
+    // NOTE: work that hasn't been run yet is kept until the pool is restarted or destroyed
     void stop();
 
-    bool running() const { return _running; }
+    bool running() const { return _running.load(boost::memory_order_acquire); }
+
+private:
+    struct Worker
+    {
+        WorkStealingDeque<BaseJob> work[LaneCount];
+        unsigned int seed, idle;
+
+        Worker() : seed(0), idle(0) {}
+    };
+
+    struct InjectionQueue
+    {
+        boost::mutex mutex;
+        BaseJob* head;
+        BaseJob* tail;
+
+        // lets workers skip the lock when the queue is empty
+        boost::atomic<size_t> size;
+
+        InjectionQueue() : head(NULL), tail(NULL), size(0) {}
+    };
+
+    static void no_cleanup(Worker* worker) {}
+
+private:
+    void push(BaseJob* job, JobCounter* counter);
+
+    // NOTE: requires _mutex to be held
+    void stop_threads();
+
+    // returns the calling thread's worker, or NULL if it isn't one of ours
+    Worker* current_worker();
+
+    // takes a job (highest lane first) from the worker's own deques,
+    // then the injection queues, then by stealing from the other workers
+    BaseJob* find_work(Worker* worker);
+
+    void inject(BaseJob* job, Lane lane);
+    BaseJob* pop_injected(Lane lane);
+    BaseJob* steal(Worker* worker, Lane lane);
+
+    void run_job(BaseJob* job);
+
+    void park();
+    void wake_one();
+    void wake_all();
 
 private:
     size_t _size;
     boost::thread_group _threads;
-    bool _running;
-    std::priority_queue<boost::shared_ptr<BaseJob>, std::deque<boost::shared_ptr<BaseJob> >, base_job_less > _work;
+    boost::atomic<bool> _running;
+
+    // guards start() and stop()
+    boost::mutex _mutex;
+
+    boost::scoped_array<Worker> _workers;
+    boost::atomic<size_t> _next_worker;
+    boost::thread_specific_ptr<Worker> _current_worker;
+
+    InjectionQueue _injected[LaneCount];
+
+    // jobs that have been pushed but not yet taken
+    boost::atomic<size_t> _pending;
+
+    boost::mutex _park_mutex;
+    boost::condition_variable _park_condition;
+    boost::atomic<size_t> _parked;
 
 private:
     ThreadPool();
@@ -0,0 +1,81 @@
+#if !defined __TRIPLEBUFFER_H__
+#define __TRIPLEBUFFER_H__
+
+namespace energonsoftware {
+
+/*
+Lock-free triple buffer for handing complete values from one writer thread to one reader thread
+
+The writer fills back() and publish()es it, the reader acquire()s the
+most recently published value and reads it from front(). Neither side
+ever waits on the other: the writer always has a buffer to write into,
+and the reader keeps the last value it acquired until a newer one is
+published. Values the reader never got to are simply overwritten.
+
+NOTE: back() and publish() are writer only, acquire() and front() are reader only
+*/
+template<typename T>
+class TripleBuffer
+{
+private:
+    enum
+    {
+        IndexMask = 0x3,
+
+        // set when the middle buffer holds a value the reader hasn't acquired
+        DirtyBit = 0x4
+    };
+
+public:
+    TripleBuffer()
+        : _back(0), _middle(1), _front(2)
+    {
+    }
+
+    virtual ~TripleBuffer() throw()
+    {
+    }
+
+public:
+    T& back() { return _buffers[_back]; }
+
+    // swaps the back buffer with the middle buffer
+    // NOTE: release so the reader sees everything written to the buffer
+    void publish()
+    {
+        const unsigned int middle = _middle.exchange(_back | DirtyBit, boost::memory_order_acq_rel);
+        _back = middle & IndexMask;
+    }
+
+    // returns true if a newer value was acquired
+    bool acquire()
+    {
+        if(!(_middle.load(boost::memory_order_relaxed) & DirtyBit)) {
+            return false;
+        }
+
+        const unsigned int middle = _middle.exchange(_front, boost::memory_order_acq_rel);
+        _front = middle & IndexMask;
+        return true;
+    }
+
+    const T& front() const { return _buffers[_front]; }
+
+private:
+    T _buffers[3];
+
+    // only touched by the writer
+    unsigned int _back;
+
+    boost::atomic<unsigned int> _middle;
+
+    // only touched by the reader
+    unsigned int _front;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(TripleBuffer);
+};
+
+}
+
+#endif
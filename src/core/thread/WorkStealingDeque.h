@@ -0,0 +1,175 @@
+#if !defined __WORKSTEALINGDEQUE_H__
+#define __WORKSTEALINGDEQUE_H__
+
+namespace energonsoftware {
+
+/*
+Chase-Lev work-stealing deque
+"Dynamic Circular Work-Stealing Deque" (Chase and Lev, SPAA 2005)
+with the memory orderings from "Correct and Efficient Work-Stealing
+for Weak Memory Models" (Le, Pop, Cohen and Zappa Nardelli, PPoPP 2013)
+
+The owning thread pushes and pops at the bottom without locking,
+other threads steal from the top with a single compare-and-swap.
+
+The deque stores pointers and never owns what they point at.
+
+NOTE: push() and pop() may only be called by the owning thread
+*/
+template<typename T>
+class WorkStealingDeque
+{
+public:
+    enum StealResult
+    {
+        StealSuccess,
+        StealEmpty,
+
+        // lost a race with another thief (or the owner), try again
+        StealAbort
+    };
+
+    enum
+    {
+        InitialCapacity = 256
+    };
+
+private:
+    class Array
+    {
+    public:
+        explicit Array(int64_t capacity)
+            : _capacity(capacity), _mask(capacity - 1), _items(new boost::atomic<T*>[capacity])
+        {
+            assert(0 == (capacity & _mask));
+        }
+
+        virtual ~Array() throw()
+        {
+        }
+
+    public:
+        int64_t capacity() const { return _capacity; }
+
+        T* get(int64_t i) const { return _items[i & _mask].load(boost::memory_order_relaxed); }
+        void put(int64_t i, T* item) { _items[i & _mask].store(item, boost::memory_order_relaxed); }
+
+        Array* grow(int64_t bottom, int64_t top) const
+        {
+            Array* array = new Array(_capacity << 1);
+            for(int64_t i=top; i<bottom; ++i) {
+                array->put(i, get(i));
+            }
+            return array;
+        }
+
+    private:
+        int64_t _capacity, _mask;
+        boost::scoped_array<boost::atomic<T*> > _items;
+
+    private:
+        Array();
+        DISALLOW_COPY_AND_ASSIGN(Array);
+    };
+
+public:
+    explicit WorkStealingDeque(int64_t capacity=InitialCapacity)
+        : _top(0), _bottom(0), _array(new Array(capacity))
+    {
+    }
+
+    virtual ~WorkStealingDeque() throw()
+    {
+        delete _array.load(boost::memory_order_relaxed);
+        BOOST_FOREACH(Array* array, _retired) {
+            delete array;
+        }
+    }
+
+public:
+    // NOTE: this is only a hint when called from a thief
+    bool empty() const
+    {
+        return _bottom.load(boost::memory_order_relaxed) <= _top.load(boost::memory_order_relaxed);
+    }
+
+    void push(T* item)
+    {
+        const int64_t bottom = _bottom.load(boost::memory_order_relaxed);
+        const int64_t top = _top.load(boost::memory_order_acquire);
+
+        Array* array = _array.load(boost::memory_order_relaxed);
+        if(bottom - top > array->capacity() - 1) {
+            // thieves may still be reading the old array, so it's kept around until we're destroyed
+            _retired.push_back(array);
+            array = array->grow(bottom, top);
+            _array.store(array, boost::memory_order_release);
+        }
+
+        array->put(bottom, item);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        _bottom.store(bottom + 1, boost::memory_order_relaxed);
+    }
+
+    // returns NULL if the deque is empty
+    T* pop()
+    {
+        const int64_t bottom = _bottom.load(boost::memory_order_relaxed) - 1;
+        Array* array = _array.load(boost::memory_order_relaxed);
+        _bottom.store(bottom, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        int64_t top = _top.load(boost::memory_order_relaxed);
+
+        if(top > bottom) {
+            // empty
+            _bottom.store(bottom + 1, boost::memory_order_relaxed);
+            return NULL;
+        }
+
+        T* item = array->get(bottom);
+        if(top == bottom) {
+            // last item, race the thieves for it
+            if(!_top.compare_exchange_strong(top, top + 1, boost::memory_order_seq_cst, boost::memory_order_relaxed)) {
+                item = NULL;
+            }
+            _bottom.store(bottom + 1, boost::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    StealResult steal(T*& item)
+    {
+        int64_t top = _top.load(boost::memory_order_acquire);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        const int64_t bottom = _bottom.load(boost::memory_order_acquire);
+
+        if(top >= bottom) {
+            return StealEmpty;
+        }
+
+        Array* array = _array.load(boost::memory_order_acquire);
+        item = array->get(top);
+        if(!_top.compare_exchange_strong(top, top + 1, boost::memory_order_seq_cst, boost::memory_order_relaxed)) {
+            return StealAbort;
+        }
+        return StealSuccess;
+    }
+
+private:
+    boost::atomic<int64_t> _top;
+
+    // keep the thieves' end and the owner's end on separate cache lines
+    char _pad[64];
+    boost::atomic<int64_t> _bottom;
+    boost::atomic<Array*> _array;
+
+    // owner only
+    std::vector<Array*> _retired;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}
+
+#endif
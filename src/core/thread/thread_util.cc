@@ -0,0 +1,58 @@
+#include "src/pch.h"
+#include "BaseJob.h"
+#include "JobCounter.h"
+#include "ThreadPool.h"
+#include "thread_util.h"
+
+namespace energonsoftware {
+
+class RangeJob : public BaseJob
+{
+public:
+    RangeJob(const boost::function<void (size_t, size_t)>& fn, size_t begin, size_t end, int priority)
+        : BaseJob(priority), _fn(fn), _begin(begin), _end(end)
+    {
+    }
+
+    virtual ~RangeJob() throw()
+    {
+    }
+
+protected:
+    virtual void on_process_work() { _fn(_begin, _end); }
+
+private:
+    // NOTE: parallel_for() outlives its jobs, so this can be a reference
+    const boost::function<void (size_t, size_t)>& _fn;
+    size_t _begin, _end;
+};
+
+void parallel_for(ThreadPool& pool, size_t begin, size_t end, size_t grain,
+    const boost::function<void (size_t, size_t)>& fn, int priority)
+{
+    if(begin >= end) {
+        return;
+    }
+
+    grain = std::max(grain, static_cast<size_t>(1));
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    if(1 == chunks) {
+        fn(begin, end);
+        return;
+    }
+
+    // the jobs live here rather than on the heap since we wait on them
+    std::vector<RangeJob> jobs;
+    jobs.reserve(chunks - 1);
+
+    JobCounter counter;
+    for(size_t start=begin + grain; start<end; start+=grain) {
+        jobs.push_back(RangeJob(fn, start, std::min(start + grain, end), priority));
+        pool.push_work(jobs.back(), &counter);
+    }
+
+    fn(begin, std::min(begin + grain, end));
+    pool.wait(counter);
+}
+
+}
@@ -0,0 +1,16 @@
+#if !defined __THREADUTIL_H__
+#define __THREADUTIL_H__
+
+namespace energonsoftware {
+
+class ThreadPool;
+
+// calls fn(chunk begin, chunk end) over [begin, end) split into chunks of grain
+// elements, spread across the pool, and waits for all of them to finish
+// NOTE: the calling thread runs the first chunk and helps with the rest
+void parallel_for(ThreadPool& pool, size_t begin, size_t end, size_t grain,
+    const boost::function<void (size_t, size_t)>& fn, int priority=0);
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+#include "src/pch.h"
+#include "AtomicStackAllocator.h"
+
+namespace energonsoftware {
+
+Logger& AtomicStackAllocator::logger(Logger::instance("gled.core.util.AtomicStackAllocator"));
+
+AtomicStackAllocator::AtomicStackAllocator(size_t size, bool huge_pages)
+    : MemoryAllocator(), _arena(size, huge_pages), _size(size), _poison(default_poison()),
+        _committed(0), _marker(0), _atomic_allocation_count(0), _atomic_allocation_bytes(0)
+{
+    _committed.store(_arena.committed(), boost::memory_order_release);
+}
+
+AtomicStackAllocator::~AtomicStackAllocator() throw()
+{
+}
+
+void* AtomicStackAllocator::allocate(size_t bytes)
+{
+    // NOTE: the marker is only ever moved past space that fits,
+    // so a failed allocation never has anything to undo
+    size_t start = _marker.load(boost::memory_order_relaxed);
+    size_t end;
+    do {
+        end = start + bytes;
+        if(end > _size || end < start) {
+            LOG_ERROR("Out of memory allocating " << bytes << " bytes\n");
+            return NULL;
+        }
+    } while(!_marker.compare_exchange_weak(start, end, boost::memory_order_relaxed));
+
+    if(end > _committed.load(boost::memory_order_acquire) && !commit(end)) {
+        return NULL;
+    }
+
+    _atomic_allocation_count.fetch_add(1, boost::memory_order_relaxed);
+    _atomic_allocation_bytes.fetch_add(bytes, boost::memory_order_relaxed);
+
+    return _arena.base() + start;
+}
+
+void AtomicStackAllocator::release(void* ptr)
+{
+    // explicitly do nothing here
+}
+
+void AtomicStackAllocator::reset()
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    free_to_marker(0);
+    _arena.decommit(0);
+    _committed.store(_arena.committed(), boost::memory_order_release);
+}
+
+void AtomicStackAllocator::free_to_marker(Marker marker)
+{
+    const size_t current = used();
+    assert(marker <= current);
+
+    if(_poison) {
+        std::memset(_arena.base() + marker, PoisonByte, current - marker);
+    }
+    _marker.store(marker, boost::memory_order_release);
+}
+
+bool AtomicStackAllocator::commit(size_t end)
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    // someone else may have committed it while we waited on the lock
+    if(!_arena.commit(end)) {
+        return false;
+    }
+
+    _committed.store(_arena.committed(), boost::memory_order_release);
+    return true;
+}
+
+}
@@ -0,0 +1,93 @@
+#if !defined __ATOMICSTACKALLOCATOR_H__
+#define __ATOMICSTACKALLOCATOR_H__
+
+#include "MemoryAllocator.h"
+#include "MemoryArena.h"
+
+namespace energonsoftware {
+
+/*
+Lock-free version of the StackAllocator.
+
+Allocating is an atomic compare-and-swap on the top of the stack
+(retried only when another thread got there first), which only
+ever moves it when the allocation fits, so any number of threads
+can allocate at once without serializing
+on the allocator lock. The lock is only taken when the arena needs
+to commit more memory, which happens once every MemoryArena::CommitChunk bytes.
+
+NOTE: rolling back to a marker and resetting must not race with allocations
+*/
+class AtomicStackAllocator : public MemoryAllocator
+{
+public:
+    typedef size_t Marker;
+
+    enum
+    {
+        // the marker and the statistics are kept on separate cache lines
+        CacheLineSize = 64
+    };
+
+private:
+    static Logger& logger;
+
+public:
+    virtual ~AtomicStackAllocator() throw();
+
+public:
+    virtual size_t total() const { return _size; }
+    virtual size_t used() const { return _marker.load(boost::memory_order_relaxed); }
+    virtual size_t unused() const { return _size - used(); }
+
+    virtual unsigned int allocation_count() const { return _atomic_allocation_count.load(boost::memory_order_relaxed); }
+    virtual size_t allocation_bytes() const { return _atomic_allocation_bytes.load(boost::memory_order_relaxed); }
+
+    virtual void* allocate(size_t bytes);
+    virtual void release(void* ptr);
+
+    // NOTE: this also gives the committed memory back to the system
+    virtual void reset();
+
+    // returns the current top of the stack
+    Marker get_marker() const { return _marker.load(boost::memory_order_acquire); }
+
+    // rolls the stack back to a marker returned by get_marker()
+    // NOTE: everything allocated after the marker is invalidated
+    void free_to_marker(Marker marker);
+
+    // if enabled, memory that is rolled back is filled with PoisonByte
+    void poison(bool enable) { _poison = enable; }
+    bool poison() const { return _poison; }
+
+private:
+    // commits the arena up to (at least) end
+    bool commit(size_t end);
+
+private:
+    friend class MemoryAllocator;
+    AtomicStackAllocator(size_t size, bool huge_pages);
+
+private:
+    MemoryArena _arena;
+    size_t _size;
+    bool _poison;
+
+    // NOTE: this is only written with the lock held
+    boost::atomic<size_t> _committed;
+
+    char _pad0[CacheLineSize];
+    boost::atomic<size_t> _marker;
+
+    char _pad1[CacheLineSize - sizeof(boost::atomic<size_t>)];
+    boost::atomic<unsigned int> _atomic_allocation_count;
+    boost::atomic<size_t> _atomic_allocation_bytes;
+
+private:
+    AtomicStackAllocator();
+    DISALLOW_COPY_AND_ASSIGN(AtomicStackAllocator);
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "src/pch.h"
+#include "DoubleBufferedAllocator.h"
+
+namespace energonsoftware {
+
+Logger& DoubleBufferedAllocator::logger(Logger::instance("gled.core.util.DoubleBufferedAllocator"));
+
+DoubleBufferedAllocator::DoubleBufferedAllocator(size_t size, bool huge_pages)
+    : MemoryAllocator(), _arena0(size, huge_pages), _arena1(size, huge_pages), _size(size), _current(0), _poison(default_poison()),
+        _frame_allocation_count(0), _last_frame_allocation_count(0),
+        _frame_allocation_bytes(0), _last_frame_allocation_bytes(0),
+        _peak_used(0), _frame_count(0)
+{
+    _arena[0] = &_arena0;
+    _arena[1] = &_arena1;
+    _marker[0] = _marker[1] = 0;
+}
+
+DoubleBufferedAllocator::~DoubleBufferedAllocator() throw()
+{
+}
+
+void* DoubleBufferedAllocator::allocate(size_t bytes)
+{
+    // NOTE: no locking here, we're owned by a single thread
+    size_t& marker(_marker[_current]);
+    assert(marker + bytes < _size);
+    if(!_arena[_current]->commit(marker + bytes)) {
+        return NULL;
+    }
+
+    size_t r = marker;
+    marker += bytes;
+
+    _allocation_count++;
+    _allocation_bytes += bytes;
+
+    _frame_allocation_count++;
+    _frame_allocation_bytes += bytes;
+
+    return _arena[_current]->base() + r;
+}
+
+void DoubleBufferedAllocator::release(void* ptr)
+{
+    // explicitly do nothing here
+}
+
+void DoubleBufferedAllocator::swap_buffers()
+{
+    _peak_used = std::max(_peak_used, _marker[_current]);
+
+    _last_frame_allocation_count = _frame_allocation_count;
+    _last_frame_allocation_bytes = _frame_allocation_bytes;
+    _frame_allocation_count = 0;
+    _frame_allocation_bytes = 0;
+
+    // the buffer we're leaving stays valid until the next swap
+    _current = 1 - _current;
+    free_to_marker(0);
+
+    _frame_count++;
+}
+
+void DoubleBufferedAllocator::free_to_marker(Marker marker)
+{
+    size_t& current(_marker[_current]);
+    assert(marker <= current);
+
+    if(_poison) {
+        std::memset(_arena[_current]->base() + marker, PoisonByte, current - marker);
+    }
+    current = marker;
+}
+
+}
@@ -0,0 +1,93 @@
+#if !defined __DOUBLEBUFFEREDALLOCATOR_H__
+#define __DOUBLEBUFFEREDALLOCATOR_H__
+
+#include "MemoryAllocator.h"
+#include "MemoryArena.h"
+
+namespace energonsoftware {
+
+/*
+Game Engine Architecture 5.2.1.4
+
+This allocator reserves two stack arenas and bumps a marker in the current one.
+Calling swap_buffers() at the end of a frame makes the other arena current
+and resets it, so anything allocated during frame N stays valid until the
+end of frame N+1.
+
+NOTE: this allocator does *not* lock, it must only ever be used by the thread that owns it
+*/
+class DoubleBufferedAllocator : public MemoryAllocator
+{
+public:
+    typedef size_t Marker;
+
+private:
+    static Logger& logger;
+
+public:
+    virtual ~DoubleBufferedAllocator() throw();
+
+public:
+    // these only refer to the current buffer
+    virtual size_t total() const { return _size; }
+    virtual size_t used() const { return _marker[_current]; }
+    virtual size_t unused() const { return _size - _marker[_current]; }
+
+    virtual void* allocate(size_t bytes);
+    virtual void release(void* ptr);
+
+    // resets the current buffer
+    virtual void reset() { free_to_marker(0); }
+
+    // returns the current top of the current buffer
+    Marker get_marker() const { return _marker[_current]; }
+
+    // rolls the current buffer back to a marker returned by get_marker()
+    // NOTE: markers are only valid until the next call to swap_buffers()
+    void free_to_marker(Marker marker);
+
+    // if enabled, memory that is rolled back or reset is filled with PoisonByte
+    void poison(bool enable) { _poison = enable; }
+    bool poison() const { return _poison; }
+
+    // makes the previous buffer current and resets it
+    // NOTE: this also rolls the per-frame statistics
+    void swap_buffers();
+
+public:
+    // per-frame statistics
+    unsigned int frame_allocation_count() const { return _frame_allocation_count; }
+    size_t frame_allocation_bytes() const { return _frame_allocation_bytes; }
+
+    unsigned int last_frame_allocation_count() const { return _last_frame_allocation_count; }
+    size_t last_frame_allocation_bytes() const { return _last_frame_allocation_bytes; }
+
+    // high water mark of a single buffer
+    size_t peak_used() const { return _peak_used; }
+
+    uint64_t frame_count() const { return _frame_count; }
+
+private:
+    friend class MemoryAllocator;
+    DoubleBufferedAllocator(size_t size, bool huge_pages);
+
+private:
+    MemoryArena _arena0, _arena1;
+    MemoryArena* _arena[2];
+    size_t _size, _marker[2];
+    unsigned int _current;
+    bool _poison;
+
+    unsigned int _frame_allocation_count, _last_frame_allocation_count;
+    size_t _frame_allocation_bytes, _last_frame_allocation_bytes;
+    size_t _peak_used;
+    uint64_t _frame_count;
+
+private:
+    DoubleBufferedAllocator();
+    DISALLOW_COPY_AND_ASSIGN(DoubleBufferedAllocator);
+};
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #include "src/pch.h"
+#include "AtomicStackAllocator.h"
+#include "DoubleBufferedAllocator.h"
+#include "PoolAllocator.h"
 #include "StackAllocator.h"
 #include "SystemAllocator.h"
+#include "TLSFAllocator.h"
 #include "MemoryAllocator.h"
 
 namespace energonsoftware {
@@ -8,14 +12,22 @@ namespace energonsoftware {
 #define ARRAY_OFFSET 0x10
 //#define ARRAY_OFFSET 0x00
 
-boost::shared_ptr<MemoryAllocator> MemoryAllocator::new_allocator(AllocatorType type, size_t size)
+boost::shared_ptr<MemoryAllocator> MemoryAllocator::new_allocator(AllocatorType type, size_t size, bool huge_pages)
 {
     switch(type)
     {
     case AllocatorTypeStack:
-        return boost::shared_ptr<MemoryAllocator>(new StackAllocator(size));
+        return boost::shared_ptr<MemoryAllocator>(new StackAllocator(size, huge_pages));
     case AllocatorTypeSystem:
         return boost::shared_ptr<MemoryAllocator>(new SystemAllocator(size));
+    case AllocatorTypeDoubleBuffered:
+        return boost::shared_ptr<MemoryAllocator>(new DoubleBufferedAllocator(size, huge_pages));
+    case AllocatorTypePool:
+        return boost::shared_ptr<MemoryAllocator>(new PoolAllocator(size, huge_pages));
+    case AllocatorTypeTLSF:
+        return boost::shared_ptr<MemoryAllocator>(new TLSFAllocator(size, huge_pages));
+    case AllocatorTypeAtomicStack:
+        return boost::shared_ptr<MemoryAllocator>(new AtomicStackAllocator(size, huge_pages));
     }
     return boost::shared_ptr<MemoryAllocator>();
 }
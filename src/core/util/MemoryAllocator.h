@@ -44,11 +44,16 @@ public:
     enum AllocatorType
     {
         AllocatorTypeStack,
-        AllocatorTypeSystem
+        AllocatorTypeSystem,
+        AllocatorTypeDoubleBuffered,
+        AllocatorTypePool,
+        AllocatorTypeTLSF,
+        AllocatorTypeAtomicStack
     };
 
 public:
-    static boost::shared_ptr<MemoryAllocator> new_allocator(AllocatorType type, size_t size);
+    // NOTE: huge_pages is only a hint and is ignored by allocators that don't reserve an arena
+    static boost::shared_ptr<MemoryAllocator> new_allocator(AllocatorType type, size_t size, bool huge_pages=false);
 
 public:
     virtual ~MemoryAllocator() throw();
@@ -59,11 +64,13 @@ public:
     virtual size_t used() const = 0;
     virtual size_t unused() const = 0;
 
-    unsigned int allocation_count() const { return _allocation_count; }
-    size_t allocation_bytes() const { return _allocation_bytes; }
+    // NOTE: lock-free allocators keep their own statistics
+    virtual unsigned int allocation_count() const { return _allocation_count; }
+    virtual size_t allocation_bytes() const { return _allocation_bytes; }
 
     // NOTE: all of the allocation() and release() overrides
     // must lock the allocator with a boost::lock_guard
+    // (except for allocators that are owned by a single thread)
 
     // allocate unaligned memory
     // NOTE: overriding classes *must* maintain
@@ -87,6 +94,20 @@ public:
     // resets (but does not free memory) any internal state
     virtual void reset() = 0;
 
+protected:
+    // rolled back / reset memory is filled with this when poisoning is enabled
+    static const unsigned char PoisonByte = 0xdd;
+
+    // poisoning defaults to on in debug builds
+    static bool default_poison()
+    {
+#if defined DEBUG
+        return true;
+#else
+        return false;
+#endif
+    }
+
 protected:
     MemoryAllocator();
 
@@ -0,0 +1,131 @@
+#include "src/pch.h"
+#if !defined WIN32
+    #include <sys/mman.h>
+#endif
+#include "util.h"
+#include "MemoryArena.h"
+
+#if !defined WIN32 && !defined MAP_ANONYMOUS
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#if !defined WIN32 && !defined MAP_NORESERVE
+    #define MAP_NORESERVE 0
+#endif
+
+namespace energonsoftware {
+
+Logger& MemoryArena::logger(Logger::instance("gled.core.util.MemoryArena"));
+
+static size_t round_up(size_t value, size_t multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+MemoryArena::MemoryArena(size_t size, bool huge_pages)
+    : _base(NULL), _size(0), _committed(0), _page_size(CommitChunk),
+        _huge_pages(huge_pages && size >= HugePageSize), _explicit_huge_pages(false)
+{
+    if(_huge_pages) {
+        _page_size = HugePageSize;
+    }
+    _size = round_up(size, _page_size);
+
+#if defined WIN32
+    // TODO: large pages require SeLockMemoryPrivilege, so they're ignored for now
+    _huge_pages = false;
+    _base = reinterpret_cast<unsigned char*>(VirtualAlloc(NULL, _size, MEM_RESERVE, PAGE_NOACCESS));
+    if(NULL == _base) {
+        LOG_ERROR("Unable to reserve " << _size << " bytes: " << last_error() << "\n");
+        throw std::bad_alloc();
+    }
+#else
+    void* base = MAP_FAILED;
+#if defined MAP_HUGETLB
+    if(_huge_pages) {
+        // explicit huge pages come out of the preallocated hugetlb pool, so they're
+        // reserved (not faulted in) up front. NORESERVE isn't used here because
+        // touching an unbacked huge page raises SIGBUS rather than failing the map
+        base = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(MAP_FAILED != base) {
+            _explicit_huge_pages = true;
+            _committed = _size;
+        } else {
+            LOG_DEBUG("Explicit huge pages unavailable (" << last_std_error() << "), falling back...\n");
+        }
+    }
+#endif
+
+    if(MAP_FAILED == base) {
+        base = mmap(NULL, _size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(MAP_FAILED == base) {
+            LOG_ERROR("Unable to reserve " << _size << " bytes: " << last_std_error() << "\n");
+            throw std::bad_alloc();
+        }
+
+#if defined MADV_HUGEPAGE
+        if(_huge_pages) {
+            madvise(base, _size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    _base = reinterpret_cast<unsigned char*>(base);
+#endif
+}
+
+MemoryArena::~MemoryArena() throw()
+{
+#if defined WIN32
+    VirtualFree(_base, 0, MEM_RELEASE);
+#else
+    munmap(_base, _size);
+#endif
+}
+
+void MemoryArena::decommit(size_t bytes)
+{
+    if(_explicit_huge_pages) {
+        return;
+    }
+
+    bytes = round_up(bytes, _page_size);
+    if(bytes >= _committed) {
+        return;
+    }
+
+#if defined WIN32
+    VirtualFree(_base + bytes, _committed - bytes, MEM_DECOMMIT);
+#else
+    // DONTNEED drops the pages from the RSS, PROT_NONE catches stray accesses
+    madvise(_base + bytes, _committed - bytes, MADV_DONTNEED);
+    mprotect(_base + bytes, _committed - bytes, PROT_NONE);
+#endif
+    _committed = bytes;
+}
+
+bool MemoryArena::grow(size_t bytes)
+{
+    if(bytes > _size) {
+        LOG_ERROR("Arena of " << _size << " bytes can't commit " << bytes << " bytes\n");
+        return false;
+    }
+
+    const size_t committed = std::min(round_up(bytes, _page_size), _size);
+
+#if defined WIN32
+    if(NULL == VirtualAlloc(_base + _committed, committed - _committed, MEM_COMMIT, PAGE_READWRITE)) {
+        LOG_ERROR("Unable to commit " << committed << " bytes: " << last_error() << "\n");
+        return false;
+    }
+#else
+    if(0 != mprotect(_base + _committed, committed - _committed, PROT_READ | PROT_WRITE)) {
+        LOG_ERROR("Unable to commit " << committed << " bytes: " << last_std_error() << "\n");
+        return false;
+    }
+#endif
+
+    _committed = committed;
+    return true;
+}
+
+}
@@ -0,0 +1,70 @@
+#if !defined __MEMORYARENA_H__
+#define __MEMORYARENA_H__
+
+namespace energonsoftware {
+
+/*
+Reserves a contiguous range of address space up front and only commits
+(backs with memory) as much of it as has been asked for. This lets the
+allocators reserve large pools without paying for them until they're used.
+
+If huge pages are requested, the arena first tries to map explicit huge pages
+(which must be preallocated, see vm.nr_hugepages) and falls back to asking for
+transparent huge pages if there aren't enough of them.
+
+Throws std::bad_alloc if the address space can't be reserved.
+*/
+class MemoryArena
+{
+public:
+    enum
+    {
+        // commits are rounded up to at least this much
+        CommitChunk = 64 * 1024,
+
+        // arenas smaller than this never use huge pages
+        HugePageSize = 2 * 1024 * 1024
+    };
+
+private:
+    static Logger& logger;
+
+public:
+    explicit MemoryArena(size_t size, bool huge_pages=false);
+    virtual ~MemoryArena() throw();
+
+public:
+    unsigned char* base() const { return _base; }
+
+    // reserved bytes
+    size_t size() const { return _size; }
+
+    // committed bytes (starting at base)
+    size_t committed() const { return _committed; }
+
+    bool huge_pages() const { return _huge_pages; }
+
+    // ensures that the first bytes of the arena are committed
+    // returns false if the memory couldn't be committed
+    bool commit(size_t bytes) { return bytes <= _committed || grow(bytes); }
+
+    // gives everything after the first bytes back to the system
+    // NOTE: decommitted memory is zeroed when it's committed again
+    void decommit(size_t bytes);
+
+private:
+    bool grow(size_t bytes);
+
+private:
+    unsigned char* _base;
+    size_t _size, _committed, _page_size;
+    bool _huge_pages, _explicit_huge_pages;
+
+private:
+    MemoryArena();
+    DISALLOW_COPY_AND_ASSIGN(MemoryArena);
+};
+
+}
+
+#endif
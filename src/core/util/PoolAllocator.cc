@@ -0,0 +1,243 @@
+#include "src/pch.h"
+#include "src/core/math/math_util.h"
+#include "PoolAllocator.h"
+
+namespace energonsoftware {
+
+// oversized allocations store their size in front of the returned memory
+// NOTE: this keeps the returned memory 16 byte aligned
+#define OVERSIZE_HEADER 0x10
+
+Logger& PoolAllocator::logger(Logger::instance("gled.core.util.PoolAllocator"));
+
+void PoolAllocator::destroy_thread_cache(ThreadCache* cache)
+{
+    // give everything back when the thread exits
+    PoolAllocator* allocator = cache->allocator;
+    {
+        boost::lock_guard<boost::recursive_mutex> guard(allocator->_mutex);
+        if(cache->generation == allocator->_generation) {
+            for(size_t i=0; i<SizeClassCount; ++i) {
+                allocator->flush_thread_cache(*cache, i, 0);
+            }
+        }
+
+        allocator->_allocation_count += cache->allocation_count;
+        allocator->_allocation_bytes += cache->allocation_bytes;
+    }
+    delete cache;
+}
+
+size_t PoolAllocator::size_class(size_t bytes)
+{
+    if(bytes <= (1 << MinBlockShift)) {
+        return 0;
+    }
+    return ilog2(power_of_2(bytes)) - MinBlockShift;
+}
+
+PoolAllocator::PoolAllocator(size_t size, bool huge_pages)
+    : MemoryAllocator(), _arena((size & ~(PageSize - 1)) + PageSize, huge_pages),
+        _base(NULL), _base_offset(0), _size(size & ~(PageSize - 1)), _page_count(0),
+        _oversize_bytes(0), _thread_cache_enabled(false), _generation(0),
+        _thread_caches(&PoolAllocator::destroy_thread_cache)
+{
+    // pages are aligned to their size so blocks never straddle them
+    _base = reinterpret_cast<unsigned char*>((reinterpret_cast<size_t>(_arena.base()) + (PageSize - 1)) & ~static_cast<size_t>(PageSize - 1));
+    _base_offset = _base - _arena.base();
+
+    _page_class.reset(new uint8_t[_size >> PageShift]);
+
+    reset();
+}
+
+PoolAllocator::~PoolAllocator() throw()
+{
+}
+
+void* PoolAllocator::allocate(size_t bytes)
+{
+    if(bytes > (1 << MaxBlockShift)) {
+        boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+        _allocation_count++;
+        _allocation_bytes += bytes;
+        _oversize_bytes += bytes;
+
+        unsigned char* r = new unsigned char[bytes + OVERSIZE_HEADER];
+        *reinterpret_cast<size_t*>(r) = bytes;
+        return r + OVERSIZE_HEADER;
+    }
+
+    const size_t sc = size_class(bytes);
+    if(_thread_cache_enabled) {
+        ThreadCache& cache(local_thread_cache());
+        if(NULL == cache.free[sc]) {
+            boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+            // grab a batch of blocks for this thread
+            for(size_t i=0; i<ThreadCacheBatch; ++i) {
+                FreeBlock* block = pop_free(sc);
+                if(NULL == block) {
+                    break;
+                }
+
+                block->next = cache.free[sc];
+                cache.free[sc] = block;
+                cache.count[sc]++;
+            }
+
+            _allocation_count += cache.allocation_count;
+            _allocation_bytes += cache.allocation_bytes;
+            cache.allocation_count = 0;
+            cache.allocation_bytes = 0;
+        }
+
+        FreeBlock* block = cache.free[sc];
+        assert(NULL != block);
+
+        cache.free[sc] = block->next;
+        cache.count[sc]--;
+
+        cache.allocation_count++;
+        cache.allocation_bytes += bytes;
+        return block;
+    }
+
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    FreeBlock* block = pop_free(sc);
+    assert(NULL != block);
+
+    _allocation_count++;
+    _allocation_bytes += bytes;
+    return block;
+}
+
+void PoolAllocator::release(void* ptr)
+{
+    if(NULL == ptr) {
+        return;
+    }
+
+    if(!owns(ptr)) {
+        boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+        unsigned char* r = reinterpret_cast<unsigned char*>(ptr) - OVERSIZE_HEADER;
+        _oversize_bytes -= *reinterpret_cast<size_t*>(r);
+        delete[] r;
+        return;
+    }
+
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(ptr);
+    const size_t sc = _page_class[(reinterpret_cast<unsigned char*>(ptr) - _base) >> PageShift];
+    if(_thread_cache_enabled) {
+        ThreadCache& cache(local_thread_cache());
+        block->next = cache.free[sc];
+        cache.free[sc] = block;
+        cache.count[sc]++;
+
+        // don't let one thread hoard everything
+        if(cache.count[sc] > (ThreadCacheBatch << 1)) {
+            boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+            flush_thread_cache(cache, sc, ThreadCacheBatch);
+        }
+        return;
+    }
+
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+    push_free(sc, block);
+}
+
+void PoolAllocator::reset()
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    _page_count = 0;
+    for(size_t i=0; i<SizeClassCount; ++i) {
+        _class_page_count[i] = 0;
+        _free[i] = NULL;
+        _free_count[i] = 0;
+    }
+
+    // invalidates every thread cache
+    _generation++;
+
+    _arena.decommit(0);
+}
+
+bool PoolAllocator::refill(size_t size_class)
+{
+    if((_page_count + 1) << PageShift > _size) {
+        LOG_ERROR("Pool exhausted refilling size class " << block_size(size_class) << "\n");
+        return false;
+    }
+
+    if(!_arena.commit(_base_offset + ((_page_count + 1) << PageShift))) {
+        return false;
+    }
+
+    const size_t page = _page_count++;
+    _page_class[page] = static_cast<uint8_t>(size_class);
+    _class_page_count[size_class]++;
+
+    // carve the page into blocks, back to front so they come out in address order
+    const size_t bsize = block_size(size_class);
+    unsigned char* start = _base + (page << PageShift);
+    for(size_t i=PageSize / bsize; i>0; --i) {
+        push_free(size_class, reinterpret_cast<FreeBlock*>(start + ((i - 1) * bsize)));
+    }
+    return true;
+}
+
+PoolAllocator::FreeBlock* PoolAllocator::pop_free(size_t size_class)
+{
+    if(NULL == _free[size_class] && !refill(size_class)) {
+        return NULL;
+    }
+
+    FreeBlock* block = _free[size_class];
+    _free[size_class] = block->next;
+    _free_count[size_class]--;
+    return block;
+}
+
+void PoolAllocator::push_free(size_t size_class, FreeBlock* block)
+{
+    block->next = _free[size_class];
+    _free[size_class] = block;
+    _free_count[size_class]++;
+}
+
+void PoolAllocator::flush_thread_cache(ThreadCache& cache, size_t size_class, size_t keep)
+{
+    while(cache.count[size_class] > keep) {
+        FreeBlock* block = cache.free[size_class];
+        cache.free[size_class] = block->next;
+        cache.count[size_class]--;
+
+        push_free(size_class, block);
+    }
+}
+
+PoolAllocator::ThreadCache& PoolAllocator::local_thread_cache()
+{
+    ThreadCache* cache = _thread_caches.get();
+    if(NULL == cache) {
+        cache = new ThreadCache();
+        ZeroMemory(cache, sizeof(ThreadCache));
+        cache->allocator = this;
+        cache->generation = _generation;
+        _thread_caches.reset(cache);
+    } else if(cache->generation != _generation) {
+        // the allocator was reset out from under us
+        for(size_t i=0; i<SizeClassCount; ++i) {
+            cache->free[i] = NULL;
+            cache->count[i] = 0;
+        }
+        cache->generation = _generation;
+    }
+    return *cache;
+}
+
+}
@@ -0,0 +1,129 @@
+#if !defined __POOLALLOCATOR_H__
+#define __POOLALLOCATOR_H__
+
+#include "MemoryAllocator.h"
+#include "MemoryArena.h"
+
+namespace energonsoftware {
+
+/*
+Game Engine Architecture 5.2.1.2
+
+This allocator reserves a chunk of address space and carves it into pages as they're needed.
+Each page is dedicated to a single power of 2 size class and split into fixed-size
+blocks that are kept on a per-class free list, so allocate() and release() are O(1)
+and released blocks are reused.
+
+Requests larger than the largest size class fall through to the global new.
+
+If thread caching is enabled, each thread keeps a small free list per size class
+that it can allocate from and release to without locking the allocator.
+*/
+class PoolAllocator : public MemoryAllocator
+{
+public:
+    enum
+    {
+        MinBlockShift = 4,                  // 16 bytes
+        MaxBlockShift = 11,                 // 2048 bytes
+        SizeClassCount = MaxBlockShift - MinBlockShift + 1,
+        PageShift = 16,                     // 64KB
+        PageSize = 1 << PageShift,
+        ThreadCacheBatch = 32
+    };
+
+    static size_t block_size(size_t size_class) { return 1 << (size_class + MinBlockShift); }
+
+private:
+    static Logger& logger;
+
+public:
+    virtual ~PoolAllocator() throw();
+
+public:
+    virtual size_t total() const { return _size; }
+
+    // bytes carved into pages (plus oversized allocations)
+    virtual size_t used() const { return (_page_count << PageShift) + _oversize_bytes; }
+    virtual size_t unused() const { return _size - (_page_count << PageShift); }
+
+    virtual void* allocate(size_t bytes);
+    virtual void release(void* ptr);
+
+    // NOTE: this invalidates every outstanding block
+    // and gives the committed memory back to the system
+    virtual void reset();
+
+    // NOTE: this should be set before the allocator is shared between threads
+    void thread_cache(bool enable) { _thread_cache_enabled = enable; }
+    bool thread_cache() const { return _thread_cache_enabled; }
+
+public:
+    // per size class statistics (these don't include blocks in thread caches)
+    size_t page_count(size_t size_class) const { return _class_page_count[size_class]; }
+    size_t free_count(size_t size_class) const { return _free_count[size_class]; }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct ThreadCache
+    {
+        PoolAllocator* allocator;
+        unsigned int generation;
+        FreeBlock* free[SizeClassCount];
+        size_t count[SizeClassCount];
+
+        // statistics that haven't been folded into the allocator yet
+        unsigned int allocation_count;
+        size_t allocation_bytes;
+    };
+
+    static void destroy_thread_cache(ThreadCache* cache);
+
+private:
+    static size_t size_class(size_t bytes);
+
+    bool owns(const void* ptr) const { return ptr >= _base && ptr < _base + _size; }
+
+    // NOTE: these all require the lock to be held
+    bool refill(size_t size_class);
+    FreeBlock* pop_free(size_t size_class);
+    void push_free(size_t size_class, FreeBlock* block);
+    void flush_thread_cache(ThreadCache& cache, size_t size_class, size_t keep);
+
+    ThreadCache& local_thread_cache();
+
+private:
+    friend class MemoryAllocator;
+    PoolAllocator(size_t size, bool huge_pages);
+
+private:
+    MemoryArena _arena;
+    unsigned char* _base;
+    size_t _base_offset;
+    size_t _size;
+
+    size_t _page_count;
+    boost::scoped_array<uint8_t> _page_class;
+    size_t _class_page_count[SizeClassCount];
+
+    FreeBlock* _free[SizeClassCount];
+    size_t _free_count[SizeClassCount];
+
+    size_t _oversize_bytes;
+
+    bool _thread_cache_enabled;
+    unsigned int _generation;
+    boost::thread_specific_ptr<ThreadCache> _thread_caches;
+
+private:
+    PoolAllocator();
+    DISALLOW_COPY_AND_ASSIGN(PoolAllocator);
+};
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#if !defined __SCOPEDSTACKMARKER_H__
+#define __SCOPEDSTACKMARKER_H__
+
+namespace energonsoftware {
+
+/*
+Rolls a stack-style allocator (StackAllocator, DoubleBufferedAllocator)
+back to where it was when this was created, when this goes out of scope.
+
+{
+    ScopedStackMarker<StackAllocator> marker(allocator);
+    ... allocate scratch data ...
+}
+
+NOTE: any objects allocated inside the scope must be destroyed before this is
+*/
+template<typename T>
+class ScopedStackMarker
+{
+public:
+    explicit ScopedStackMarker(T& allocator)
+        : _allocator(allocator), _marker(allocator.get_marker())
+    {
+    }
+
+    ~ScopedStackMarker() throw()
+    {
+        _allocator.free_to_marker(_marker);
+    }
+
+public:
+    typename T::Marker marker() const { return _marker; }
+
+private:
+    T& _allocator;
+    typename T::Marker _marker;
+
+private:
+    ScopedStackMarker();
+    DISALLOW_COPY_AND_ASSIGN(ScopedStackMarker);
+};
+
+}
+
+#endif
@@ -5,11 +5,10 @@ namespace energonsoftware {
 
 Logger& StackAllocator::logger(Logger::instance("gled.core.util.StackAllocator"));
 
-StackAllocator::StackAllocator(size_t size)
-    : MemoryAllocator(), _size(size), _marker(0)
+StackAllocator::StackAllocator(size_t size, bool huge_pages)
+    : MemoryAllocator(), _arena(size, huge_pages), _size(size), _marker(0), _poison(default_poison())
 {
-    _pool.reset(new unsigned char[_size]);
-    //LOG_DEBUG("Pool at " << reinterpret_cast<void*>(_pool.get()) << "\n");
+    //LOG_DEBUG("Pool at " << reinterpret_cast<void*>(_arena.base()) << "\n");
 }
 
 StackAllocator::~StackAllocator() throw()
@@ -21,6 +20,9 @@ void* StackAllocator::allocate(size_t bytes)
     boost::lock_guard<boost::recursive_mutex> guard(_mutex);
 
     assert(_marker + bytes < _size);
+    if(!_arena.commit(_marker + bytes)) {
+        return NULL;
+    }
 
     size_t r = _marker;
     _marker += bytes;
@@ -28,8 +30,8 @@ void* StackAllocator::allocate(size_t bytes)
     _allocation_count++;
     _allocation_bytes += bytes;
 
-    //LOG_DEBUG("Allocating memory at " << reinterpret_cast<void*>(_pool.get() + r) << "\n");
-    return _pool.get() + r;
+    //LOG_DEBUG("Allocating memory at " << reinterpret_cast<void*>(_arena.base() + r) << "\n");
+    return _arena.base() + r;
 }
 
 void StackAllocator::release(void* ptr)
@@ -37,4 +39,24 @@ void StackAllocator::release(void* ptr)
     // explicitly do nothing here
 }
 
+void StackAllocator::reset()
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    free_to_marker(0);
+    _arena.decommit(0);
+}
+
+void StackAllocator::free_to_marker(Marker marker)
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    assert(marker <= _marker);
+
+    if(_poison) {
+        std::memset(_arena.base() + marker, PoisonByte, _marker - marker);
+    }
+    _marker = marker;
+}
+
 }
@@ -2,14 +2,26 @@
 #define __STACKALLOCATOR_H__
 
 #include "MemoryAllocator.h"
+#include "MemoryArena.h"
 
 namespace energonsoftware {
 
 /*
-This allocator uses the global new to allocate (reserve) a chunk of memory on the heap.
+This allocator reserves a chunk of address space and commits it as the stack grows.
+
+Temporary allocations can be given back by rolling the stack back to a marker:
+
+StackAllocator::Marker marker = allocator.get_marker();
+... allocate scratch data ...
+allocator.free_to_marker(marker);
+
+or with a ScopedStackMarker, which does the same when it goes out of scope.
 */
 class StackAllocator : public MemoryAllocator
 {
+public:
+    typedef size_t Marker;
+
 private:
     static Logger& logger;
 
@@ -24,15 +36,28 @@ public:
     virtual void* allocate(size_t bytes);
     virtual void release(void* ptr);
 
-    virtual void reset() { _marker = 0; }
+    // NOTE: this also gives the committed memory back to the system
+    virtual void reset();
+
+    // returns the current top of the stack
+    Marker get_marker() const { return _marker; }
+
+    // rolls the stack back to a marker returned by get_marker()
+    // NOTE: everything allocated after the marker is invalidated
+    void free_to_marker(Marker marker);
+
+    // if enabled, memory that is rolled back is filled with PoisonByte
+    void poison(bool enable) { _poison = enable; }
+    bool poison() const { return _poison; }
 
 private:
     friend class MemoryAllocator;
-    explicit StackAllocator(size_t size);
+    StackAllocator(size_t size, bool huge_pages);
 
 private:
-    boost::shared_array<unsigned char> _pool;
+    MemoryArena _arena;
     uint32_t _size, _marker;
+    bool _poison;
 
 private:
     StackAllocator();
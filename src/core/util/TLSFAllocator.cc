@@ -0,0 +1,302 @@
+#include "src/pch.h"
+#include "src/core/math/math_util.h"
+#include "util.h"
+#include "TLSFAllocator.h"
+
+namespace energonsoftware {
+
+Logger& TLSFAllocator::logger(Logger::instance("gled.core.util.TLSFAllocator"));
+
+void TLSFAllocator::mapping_insert(size_t size, unsigned int& fl, unsigned int& sl)
+{
+    if(size < SmallBlockSize) {
+        // small blocks are linearly subdivided
+        fl = 0;
+        sl = size / (SmallBlockSize / SecondLevelCount);
+    } else {
+        const unsigned int f = ilog2(size);
+        sl = (size >> (f - SecondLevelShift)) ^ SecondLevelCount;
+        fl = f - (FirstLevelShift - 1);
+    }
+}
+
+void TLSFAllocator::mapping_search(size_t size, unsigned int& fl, unsigned int& sl)
+{
+    // round up to the next list so that any block we find is big enough
+    if(size >= SmallBlockSize) {
+        size += (1 << (ilog2(size) - SecondLevelShift)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+TLSFAllocator::TLSFAllocator(size_t size, bool huge_pages)
+    : MemoryAllocator(), _arena(size, huge_pages), _sentinel(NULL),
+        _fl_bitmap(0), _end(0), _used(0), _free_bytes(0), _free_block_count(0)
+{
+    reset();
+}
+
+TLSFAllocator::~TLSFAllocator() throw()
+{
+}
+
+void* TLSFAllocator::allocate(size_t bytes)
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    const size_t size = (std::max(bytes, static_cast<size_t>(MinBlockSize)) + (Alignment - 1)) & ~static_cast<size_t>(Alignment - 1);
+
+    BlockHeader* block = find_free(size);
+    if(NULL == block) {
+        if(!grow(size)) {
+            return NULL;
+        }
+
+        block = find_free(size);
+        assert(NULL != block);
+    }
+    remove_free(block);
+
+    // split off whatever we don't need
+    const size_t bsize = block_size(block);
+    if(bsize >= size + HeaderSize + MinBlockSize) {
+        BlockHeader* remainder = reinterpret_cast<BlockHeader*>(reinterpret_cast<unsigned char*>(payload(block)) + size);
+        remainder->size = bsize - size - HeaderSize;
+        remainder->prev_phys = block;
+        block->size = size | (block->size & BlockPrevFree);
+
+        mark_free(remainder, true);
+        insert_free(remainder);
+    }
+    mark_free(block, false);
+
+    _allocation_count++;
+    _allocation_bytes += bytes;
+    _used += block_size(block) + HeaderSize;
+
+    return payload(block);
+}
+
+void TLSFAllocator::release(void* ptr)
+{
+    if(NULL == ptr) {
+        return;
+    }
+
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    BlockHeader* block = header(ptr);
+    assert(!is_free(block));
+
+    _used -= block_size(block) + HeaderSize;
+
+    mark_free(block, true);
+    insert_free(merge(block));
+}
+
+void TLSFAllocator::reset()
+{
+    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
+
+    _fl_bitmap = 0;
+    for(size_t i=0; i<FirstLevelCount; ++i) {
+        _sl_bitmap[i] = 0;
+        for(size_t j=0; j<SecondLevelCount; ++j) {
+            _blocks[i][j] = NULL;
+        }
+    }
+
+    _used = _free_bytes = _free_block_count = 0;
+
+    // start over with just the sentinel
+    // NOTE: the committed pages are kept rather than given back,
+    // which saves faulting them all back in when the pool is refilled
+    _arena.commit(HeaderSize);
+
+    _sentinel = reinterpret_cast<BlockHeader*>(_arena.base());
+    _sentinel->prev_phys = NULL;
+    _sentinel->size = 0;
+    _end = HeaderSize;
+
+    // whatever is already committed becomes a single free block
+    const size_t end = _arena.committed();
+    if(end >= _end + HeaderSize + MinBlockSize) {
+        BlockHeader* block = _sentinel;
+        block->size = end - _end - HeaderSize;
+
+        _sentinel = reinterpret_cast<BlockHeader*>(_arena.base() + end - HeaderSize);
+        _sentinel->size = 0;
+        _end = end;
+
+        mark_free(block, true);
+        insert_free(block);
+    }
+}
+
+size_t TLSFAllocator::largest_free_block() const
+{
+    boost::lock_guard<boost::recursive_mutex> guard(const_cast<boost::recursive_mutex&>(_mutex));
+
+    if(0 == _fl_bitmap) {
+        return 0;
+    }
+
+    // the largest block is in the highest non-empty list
+    const unsigned int fl = ilog2(_fl_bitmap);
+    const unsigned int sl = ilog2(_sl_bitmap[fl]);
+
+    size_t largest = 0;
+    for(const BlockHeader* block = _blocks[fl][sl]; NULL != block; block = block->next_free) {
+        largest = std::max(largest, block_size(block));
+    }
+    return largest;
+}
+
+float TLSFAllocator::fragmentation() const
+{
+    const size_t free_bytes = _free_bytes;
+    if(0 == free_bytes) {
+        return 0.0f;
+    }
+    return 1.0f - (static_cast<float>(largest_free_block()) / static_cast<float>(free_bytes));
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::find_free(size_t size)
+{
+    unsigned int fl, sl;
+    mapping_search(size, fl, sl);
+    if(fl >= FirstLevelCount) {
+        return NULL;
+    }
+
+    unsigned int sl_map = _sl_bitmap[fl] & (~0u << sl);
+    if(0 == sl_map) {
+        // nothing in this first level, so move up to the next one that has something
+        const unsigned int fl_map = fl + 1 < FirstLevelCount ? _fl_bitmap & (~0u << (fl + 1)) : 0;
+        if(0 == fl_map) {
+            return NULL;
+        }
+
+        fl = find_first_set(fl_map);
+        sl_map = _sl_bitmap[fl];
+    }
+    sl = find_first_set(sl_map);
+
+    return _blocks[fl][sl];
+}
+
+void TLSFAllocator::insert_free(BlockHeader* block)
+{
+    unsigned int fl, sl;
+    mapping_insert(block_size(block), fl, sl);
+
+    BlockHeader* head = _blocks[fl][sl];
+    block->prev_free = NULL;
+    block->next_free = head;
+    if(NULL != head) {
+        head->prev_free = block;
+    }
+    _blocks[fl][sl] = block;
+
+    _fl_bitmap |= 1 << fl;
+    _sl_bitmap[fl] |= 1 << sl;
+
+    _free_bytes += block_size(block);
+    _free_block_count++;
+}
+
+void TLSFAllocator::remove_free(BlockHeader* block)
+{
+    unsigned int fl, sl;
+    mapping_insert(block_size(block), fl, sl);
+
+    if(NULL != block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    }
+
+    if(NULL != block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+
+    if(_blocks[fl][sl] == block) {
+        _blocks[fl][sl] = block->next_free;
+        if(NULL == _blocks[fl][sl]) {
+            _sl_bitmap[fl] &= ~(1 << sl);
+            if(0 == _sl_bitmap[fl]) {
+                _fl_bitmap &= ~(1 << fl);
+            }
+        }
+    }
+
+    _free_bytes -= block_size(block);
+    _free_block_count--;
+}
+
+void TLSFAllocator::mark_free(BlockHeader* block, bool free)
+{
+    BlockHeader* next = next_phys(block);
+    next->prev_phys = block;
+    if(free) {
+        block->size |= BlockFree;
+        next->size |= BlockPrevFree;
+    } else {
+        block->size &= ~static_cast<size_t>(BlockFree);
+        next->size &= ~static_cast<size_t>(BlockPrevFree);
+    }
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::merge(BlockHeader* block)
+{
+    // NOTE: the block being merged is free but not in a list yet
+    if(0 != (block->size & BlockPrevFree)) {
+        BlockHeader* prev = block->prev_phys;
+        remove_free(prev);
+        prev->size += HeaderSize + block_size(block);
+        block = prev;
+    }
+
+    BlockHeader* next = next_phys(block);
+    if(is_free(next)) {
+        remove_free(next);
+        block->size += HeaderSize + block_size(next);
+    }
+
+    mark_free(block, true);
+    return block;
+}
+
+bool TLSFAllocator::grow(size_t size)
+{
+    // make sure the new block lands in a list that find_free() will search
+    if(size >= SmallBlockSize) {
+        size += (1 << (ilog2(size) - SecondLevelShift)) - 1;
+    }
+
+    const size_t needed = size + HeaderSize;
+    size_t end = _end + std::max(needed, static_cast<size_t>(GrowSize));
+    if(end > _arena.size()) {
+        end = _end + needed;
+    }
+
+    if(end > _arena.size() || !_arena.commit(end)) {
+        LOG_ERROR("Pool exhausted allocating " << size << " bytes (" << _used << " used, " << _free_bytes << " free)\n");
+        return false;
+    }
+
+    // use everything that was committed
+    end = _arena.committed();
+
+    // the old sentinel becomes a free block covering the new space
+    BlockHeader* block = _sentinel;
+    block->size = (end - _end - HeaderSize) | (block->size & BlockPrevFree);
+
+    _sentinel = reinterpret_cast<BlockHeader*>(_arena.base() + end - HeaderSize);
+    _sentinel->size = 0;
+    _end = end;
+
+    mark_free(block, true);
+    insert_free(merge(block));
+    return true;
+}
+
+}
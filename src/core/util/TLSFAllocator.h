@@ -0,0 +1,143 @@
+#if !defined __TLSFALLOCATOR_H__
+#define __TLSFALLOCATOR_H__
+
+#include "MemoryAllocator.h"
+#include "MemoryArena.h"
+
+namespace energonsoftware {
+
+/*
+Two-Level Segregated Fit allocator
+http://www.gii.upv.es/tlsf/ (Masmano, Ripoll, Crespo and Real)
+
+Free blocks are kept on segregated lists indexed by a first level (power of 2)
+and a second level (linear subdivision of that power of 2), with a bitmap for
+each level, so finding a suitable block, allocating and releasing are all O(1).
+Neighboring free blocks are merged on release, which keeps fragmentation bounded.
+
+The pool grows into a reserved MemoryArena as needed rather than being committed up front.
+*/
+class TLSFAllocator : public MemoryAllocator
+{
+public:
+    enum
+    {
+        AlignmentShift = 4,
+        Alignment = 1 << AlignmentShift,
+
+        // second level subdivisions (log2)
+        SecondLevelShift = 5,
+        SecondLevelCount = 1 << SecondLevelShift,
+
+        // blocks smaller than this are all kept in the first first-level list
+        FirstLevelShift = SecondLevelShift + AlignmentShift,
+        SmallBlockSize = 1 << FirstLevelShift,
+
+        // supports pools up to 4GB
+        FirstLevelMax = 32,
+        FirstLevelCount = FirstLevelMax - FirstLevelShift + 1,
+
+        // the pool grows by at least this much
+        GrowSize = 1024 * 1024
+    };
+
+private:
+    static Logger& logger;
+
+public:
+    virtual ~TLSFAllocator() throw();
+
+public:
+    virtual size_t total() const { return _arena.size(); }
+    virtual size_t used() const { return _used; }
+    virtual size_t unused() const { return _arena.size() - _used; }
+
+    virtual void* allocate(size_t bytes);
+    virtual void release(void* ptr);
+
+    // NOTE: this invalidates every outstanding allocation,
+    // the committed memory is kept for the pool to reuse
+    virtual void reset();
+
+public:
+    // bytes the pool has grown to
+    size_t committed() const { return _arena.committed(); }
+
+    size_t free_bytes() const { return _free_bytes; }
+    size_t free_block_count() const { return _free_block_count; }
+    size_t largest_free_block() const;
+
+    // 0.0 means all of the free memory is in a single block
+    float fragmentation() const;
+
+private:
+    struct BlockHeader
+    {
+        // physically previous block (NULL for the first block)
+        BlockHeader* prev_phys;
+
+        // payload size, the low bits are the block flags
+        size_t size;
+
+        // these are only valid while the block is free
+        // NOTE: they overlap the payload
+        BlockHeader* next_free;
+        BlockHeader* prev_free;
+    };
+
+    enum
+    {
+        BlockFree = 0x01,
+        BlockPrevFree = 0x02,
+        BlockFlags = BlockFree | BlockPrevFree,
+
+        // prev_phys + size and next_free + prev_free each fit in this
+        HeaderSize = Alignment,
+        MinBlockSize = Alignment
+    };
+
+    static size_t block_size(const BlockHeader* block) { return block->size & ~static_cast<size_t>(BlockFlags); }
+    static bool is_free(const BlockHeader* block) { return 0 != (block->size & BlockFree); }
+    static void* payload(BlockHeader* block) { return reinterpret_cast<unsigned char*>(block) + HeaderSize; }
+    static BlockHeader* header(void* ptr) { return reinterpret_cast<BlockHeader*>(reinterpret_cast<unsigned char*>(ptr) - HeaderSize); }
+    static BlockHeader* next_phys(BlockHeader* block) { return reinterpret_cast<BlockHeader*>(reinterpret_cast<unsigned char*>(payload(block)) + block_size(block)); }
+
+    static void mapping_insert(size_t size, unsigned int& fl, unsigned int& sl);
+    static void mapping_search(size_t size, unsigned int& fl, unsigned int& sl);
+
+private:
+    // NOTE: these all require the lock to be held
+    BlockHeader* find_free(size_t size);
+    void insert_free(BlockHeader* block);
+    void remove_free(BlockHeader* block);
+    void mark_free(BlockHeader* block, bool free);
+    BlockHeader* merge(BlockHeader* block);
+    bool grow(size_t size);
+
+private:
+    friend class MemoryAllocator;
+    TLSFAllocator(size_t size, bool huge_pages);
+
+private:
+    MemoryArena _arena;
+
+    // zero-sized used block at the end of the pool
+    BlockHeader* _sentinel;
+
+    unsigned int _fl_bitmap;
+    unsigned int _sl_bitmap[FirstLevelCount];
+    BlockHeader* _blocks[FirstLevelCount][SecondLevelCount];
+
+    // end of the pool (one past the sentinel)
+    size_t _end;
+
+    size_t _used, _free_bytes, _free_block_count;
+
+private:
+    TLSFAllocator();
+    DISALLOW_COPY_AND_ASSIGN(TLSFAllocator);
+};
+
+}
+
+#endif
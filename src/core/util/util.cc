@@ -2,6 +2,9 @@
 #include <iostream>
 #include <iomanip>
 #include <fcntl.h>
+#if defined __APPLE__
+    #include <mach/mach_time.h>
+#endif
 #if defined USE_OPENSSL
     #include <openssl/bio.h>
     #include <openssl/buffer.h>
@@ -89,6 +92,32 @@ double get_time()
     return tv.tv_sec + (tv.tv_usec * 1e-6);
 }
 
+double get_monotonic_time()
+{
+#if defined WIN32
+    static double frequency = 0.0;
+    if(frequency <= 0.0) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        frequency = static_cast<double>(f.QuadPart);
+    }
+
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return count.QuadPart / frequency;
+#elif defined __APPLE__
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if(0 == timebase.denom) {
+        mach_timebase_info(&timebase);
+    }
+    return (mach_absolute_time() * timebase.numer / timebase.denom) * 1e-9;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec * 1e-9);
+#endif
+}
+
 #if defined WITH_USE_CRYPTO
 // TODO: this is a bit arbitrary and unnecessary
 #define BASE64_MAX_BUFFER 10240
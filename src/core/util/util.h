@@ -22,6 +22,11 @@ std::string last_error(int error) throw();
 // returns the time in seconds
 double get_time();
 
+// returns the time in seconds from a clock that never jumps
+// (unlike get_time(), which follows the wall clock)
+// NOTE: this is only useful for measuring intervals
+double get_monotonic_time();
+
 #if defined WITH_CRYPTO
 // base64 encoding (caller is responsible for freeing the return value)
 char* base64_encode(const unsigned char* input, size_t len);
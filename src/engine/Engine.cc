@@ -1,4 +1,7 @@
 #include "src/pch.h"
+#include "src/core/thread/BaseThread.h"
+#include "src/core/thread/ThreadPool.h"
+#include "src/core/util/PoolAllocator.h"
 #include "src/core/util/util.h"
 #include "ResourceManager.h"
 #include "State.h"
@@ -30,7 +33,7 @@ Engine& Engine::instance()
 
 Engine::Engine()
     : _ready(false), _quit(false),
-        _start_time(0.0), _frame_count(0), _last_frame(0.0)
+        _start_time(0.0), _frame_count(0), _last_frame(0.0), _interpolation(1.0f)
 {
 }
 
@@ -46,13 +49,33 @@ bool Engine::init(int video_width, int video_height, int video_depth)
         shutdown();
     }
 
+    _render_thread = boost::this_thread::get_id();
+
     const EngineConfiguration& config(EngineConfiguration::instance());
 
     // TODO: the allocators shouldn't be dynamically allocated like this!
-    // TODO: split the sizes of the pools into two config options
-    LOG_INFO("Allocating memory pool (system=" << config.memory_pool() << "MB, frame=" << config.memory_pool() << "MB)...\n");
-    _system_allocator = MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeStack, config.memory_pool() * 1024 * 1024);
-    _frame_allocator = MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeStack, config.memory_pool() * 1024 * 1024);
+    LOG_INFO("Reserving memory pools (system=" << config.memory_system_pool() << "MB, object=" << config.memory_object_pool()
+        << "MB, frame=2x" << config.memory_frame_pool() << "MB per thread, huge pages=" << config.memory_huge_pages() << ")...\n");
+    _system_allocator = MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeStack,
+        config.memory_system_pool() * 1024 * 1024, config.memory_huge_pages());
+
+    // the pool is shared between threads, so give each one a cache
+    _pool_allocator = boost::static_pointer_cast<PoolAllocator>(MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypePool,
+        config.memory_object_pool() * 1024 * 1024, config.memory_huge_pages()));
+    _pool_allocator->thread_cache(true);
+
+    // each engine thread gets its own (unlocked) double-buffered frame allocator
+    _render_frame_allocator = boost::static_pointer_cast<DoubleBufferedAllocator>(MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeDoubleBuffered,
+        config.memory_frame_pool() * 1024 * 1024, config.memory_huge_pages()));
+    _update_frame_allocator = boost::static_pointer_cast<DoubleBufferedAllocator>(MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeDoubleBuffered,
+        config.memory_frame_pool() * 1024 * 1024, config.memory_huge_pages()));
+
+    // NOTE: threads that wait on jobs help run them, so the pool doesn't need a thread per core
+    int worker_threads = config.jobs_worker_threads();
+    if(worker_threads < 0) {
+        worker_threads = std::max(static_cast<int>(boost::thread::hardware_concurrency()) - 1, 1);
+    }
+    _job_pool.reset(new(*_system_allocator) ThreadPool(worker_threads), boost::bind(&ThreadPool::destroy, _1, _system_allocator.get()));
 
     _update_thread.reset(new(*_system_allocator) UpdateThread(), boost::bind(&UpdateThread::destroy, _1, _system_allocator.get()));
 
@@ -89,6 +112,8 @@ if(!_state->load_font("courier", 24, Color(1.0f, 1.0f, 1.0f, 1.0f))) {
 
     print_memory_details();
 
+    _job_pool->start(BaseThreadFactory());
+
     _update_thread->start();
     LOG_INFO(_update_thread->str() << "\n");
 
@@ -102,6 +127,7 @@ void Engine::shutdown()
 {
     _ready = false;
     _update_thread.reset();
+    _job_pool.reset();
 
     LOG_INFO("Runtime statistics:\n"
         << "Frames Rendered: " << _frame_count << "\n"
@@ -115,40 +141,85 @@ void Engine::shutdown()
     UIController::release_controllers();
 }
 
+static void print_allocator_details(Logger& logger, const std::string& name, const MemoryAllocator& allocator)
+{
+    LOG_INFO(name << " Allocator Details:\n");
+    LOG_INFO("    Total Allocated: " << (allocator.total() / 1024.0f / 1024.0f) << "MB\n");
+    LOG_INFO("    Used: " << (allocator.used() / 1024.0f / 1024.0f) << "MB"
+        << " (" << (100.0f * (static_cast<float>(allocator.used()) / static_cast<float>(allocator.total()))) << "%)\n");
+    LOG_INFO("    Available: " << (allocator.unused() / 1024.0f / 1024.0f) << "MB"
+        << " (" << (100.0f * (static_cast<float>(allocator.unused()) / static_cast<float>(allocator.total()))) << "%)\n");
+    LOG_INFO("    Allocation Count: " << allocator.allocation_count() << "\n");
+    LOG_INFO("    Bytes Allocated: " << allocator.allocation_bytes() << "\n");
+}
+
+static void print_pool_allocator_details(Logger& logger, const std::string& name, const PoolAllocator& allocator)
+{
+    print_allocator_details(logger, name, allocator);
+    for(size_t i=0; i<PoolAllocator::SizeClassCount; ++i) {
+        if(allocator.page_count(i) > 0) {
+            LOG_INFO("    " << PoolAllocator::block_size(i) << " byte blocks: " << allocator.page_count(i) << " pages, "
+                << allocator.free_count(i) << " free\n");
+        }
+    }
+}
+
+static void print_frame_allocator_details(Logger& logger, const std::string& name, const DoubleBufferedAllocator& allocator)
+{
+    print_allocator_details(logger, name, allocator);
+    LOG_INFO("    Frames: " << allocator.frame_count() << "\n");
+    LOG_INFO("    Last Frame Allocation Count: " << allocator.last_frame_allocation_count() << "\n");
+    LOG_INFO("    Last Frame Bytes Allocated: " << allocator.last_frame_allocation_bytes() << "\n");
+    LOG_INFO("    Peak Used: " << (allocator.peak_used() / 1024.0f / 1024.0f) << "MB\n");
+}
+
+static void print_tlsf_allocator_details(Logger& logger, const std::string& name, const TLSFAllocator& allocator)
+{
+    print_allocator_details(logger, name, allocator);
+    LOG_INFO("    Committed: " << (allocator.committed() / 1024.0f / 1024.0f) << "MB\n");
+    LOG_INFO("    Free: " << (allocator.free_bytes() / 1024.0f / 1024.0f) << "MB in " << allocator.free_block_count() << " blocks\n");
+    LOG_INFO("    Largest Free Block: " << (allocator.largest_free_block() / 1024.0f / 1024.0f) << "MB\n");
+    LOG_INFO("    Fragmentation: " << (100.0f * allocator.fragmentation()) << "%\n");
+}
+
 void Engine::print_memory_details()
 {
-    LOG_INFO("System Allocator Details:\n");
-    LOG_INFO("    Total Allocated: " << (_system_allocator->total() / 1024.0f / 1024.0f) << "MB\n");
-    LOG_INFO("    Used: " << (_system_allocator->used() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_system_allocator->used()) / static_cast<float>(_system_allocator->total()))) << "%)\n");
-    LOG_INFO("    Available: " << (_system_allocator->unused() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_system_allocator->unused()) / static_cast<float>(_system_allocator->total()))) << "%)\n");
-    LOG_INFO("    Allocation Count: " << _system_allocator->allocation_count() << "\n");
-    LOG_INFO("    Bytes Allocated: " << _system_allocator->allocation_bytes() << "\n");
-
-    LOG_INFO("Scene Allocator Details:\n");
-    LOG_INFO("    Total Allocated: " << (_state->scene().allocator().total() / 1024.0f / 1024.0f) << "MB\n");
-    LOG_INFO("    Used: " << (_state->scene().allocator().used() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_state->scene().allocator().used()) / static_cast<float>(_state->scene().allocator().total()))) << "%)\n");
-    LOG_INFO("    Available: " << (_state->scene().allocator().unused() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_state->scene().allocator().unused()) / static_cast<float>(_state->scene().allocator().total()))) << "%)\n");
-    LOG_INFO("    Allocation Count: " << _state->scene().allocator().allocation_count() << "\n");
-    LOG_INFO("    Bytes Allocated: " << _state->scene().allocator().allocation_bytes() << "\n");
-
-    LOG_INFO("Frame Allocator Details:\n");
-    LOG_INFO("    Total Allocated: " << (_frame_allocator->total() / 1024.0f / 1024.0f) << "MB\n");
-    LOG_INFO("    Used: " << (_frame_allocator->used() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_frame_allocator->used()) / static_cast<float>(_frame_allocator->total()))) << "%)\n");
-    LOG_INFO("    Available: " << (_frame_allocator->unused() / 1024.0f / 1024.0f) << "MB"
-        << " (" << (100.0f * (static_cast<float>(_frame_allocator->unused()) / static_cast<float>(_frame_allocator->total()))) << "%)\n");
-    LOG_INFO("    Allocation Count: " << _frame_allocator->allocation_count() << "\n");
-    LOG_INFO("    Bytes Allocated: " << _frame_allocator->allocation_bytes() << "\n");
+    print_allocator_details(logger, "System", *_system_allocator);
+    print_tlsf_allocator_details(logger, "Scene", _state->scene().allocator());
+    print_pool_allocator_details(logger, "Pool", *_pool_allocator);
+    print_frame_allocator_details(logger, "Render Frame", *_render_frame_allocator);
+    print_frame_allocator_details(logger, "Update Frame", *_update_frame_allocator);
 
+    _renderer->print_command_queue_details();
     _renderer->print_video_memory_details();
 }
 
+MemoryAllocator& Engine::pool_allocator()
+{
+    return *_pool_allocator;
+}
+
+DoubleBufferedAllocator& Engine::frame_allocator()
+{
+    const boost::thread::id id(boost::this_thread::get_id());
+    if(_update_thread && id == _update_thread->id()) {
+        return *_update_frame_allocator;
+    }
+
+    assert(id == _render_thread);
+    return *_render_frame_allocator;
+}
+
 void Engine::start_frame()
 {
+    // pick up the newest simulated state for the frame
+    Scene& scene(_state->scene());
+    scene.acquire_snapshot();
+    _interpolation = _update_thread->interpolation(scene.snapshot().time);
+
+    // run whatever render commands the other threads have queued up
+    _renderer->start_frame();
+
 //    _state->scene().render();
 
     std::stringstream txt;
@@ -174,7 +245,7 @@ void Engine::finish_frame(bool rate_limit)
         this->rate_limit();
     }
 
-    _frame_allocator->reset();
+    _render_frame_allocator->swap_buffers();
     _frame_count++;
 }
 
@@ -1,14 +1,18 @@
 #if !defined __ENGINE_H__
 #define __ENGINE_H__
 
+#include "src/core/util/DoubleBufferedAllocator.h"
+
 namespace energonsoftware {
 
 class Configuration;
+class PoolAllocator;
 class InputState;
 class ModelManager;
 class Renderer;
 class ResourceManager;
 class State;
+class ThreadPool;
 class UpdateThread;
 
 class Engine
@@ -39,7 +43,23 @@ public:
 
 public:
     MemoryAllocator& system_allocator() { return *_system_allocator; }
-    MemoryAllocator& frame_allocator() { return *_frame_allocator; }
+
+    // small, short-lived objects that are released individually
+    // (render commands, interpolated joints, etc) go here
+    // NOTE: this is safe to use from any thread
+    MemoryAllocator& pool_allocator();
+
+    // returns the frame allocator owned by the calling thread
+    // NOTE: only the render (main) thread and the update thread
+    // own frame allocators (they aren't locked, so job pool workers
+    // can't use them), anything allocated from one is valid
+    // until the end of the owning thread's *next* frame
+    DoubleBufferedAllocator& frame_allocator();
+    DoubleBufferedAllocator& render_frame_allocator() { return *_render_frame_allocator; }
+    DoubleBufferedAllocator& update_frame_allocator() { return *_update_frame_allocator; }
+
+    // engine-wide work-stealing job pool
+    ThreadPool& job_pool() { return *_job_pool; }
 
 const State& state() const { return *_state; }
 State& state() { return *_state; }
@@ -60,6 +80,10 @@ public:
     double runtime() const;
     double frame_time() const;
 
+    // blend factor between the previous and current simulation states
+    // NOTE: this is sampled once at the start of each frame
+    float interpolation() const { return _interpolation; }
+
     double average_fps() const;
     double current_fps() const;
 
@@ -67,7 +91,10 @@ private:
     void rate_limit();
 
 private:
-    boost::shared_ptr<MemoryAllocator> _system_allocator, _frame_allocator;
+    boost::shared_ptr<MemoryAllocator> _system_allocator;
+    boost::shared_ptr<PoolAllocator> _pool_allocator;
+    boost::shared_ptr<DoubleBufferedAllocator> _render_frame_allocator, _update_frame_allocator;
+    boost::shared_ptr<ThreadPool> _job_pool;
     boost::shared_ptr<UpdateThread> _update_thread;
 boost::shared_ptr<State> _state;
     boost::shared_ptr<InputState> _input_state;
@@ -84,6 +111,11 @@ boost::shared_ptr<ModelManager> _model_manager;
     uint64_t _frame_count;
     double _last_frame;     // set after each call to render() for fps timing
 
+    float _interpolation;
+
+    // the thread init() was called from
+    boost::thread::id _render_thread;
+
 private:
     Engine();
     DISALLOW_COPY_AND_ASSIGN(Engine);
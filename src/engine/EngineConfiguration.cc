@@ -18,7 +18,18 @@ EngineConfiguration::EngineConfiguration()
     set_default("renderer", "mode", "bump");
     set_default("renderer", "shadows", "true");
 
-    set_default("memory", "pool", "50");
+    // NOTE: the pools only reserve address space up front,
+    // memory isn't committed until it's actually used
+    set_default("memory", "system_pool", "50");
+    set_default("memory", "object_pool", "16");
+    set_default("memory", "frame_pool", "32");
+    set_default("memory", "scene_pool", "256");
+    set_default("memory", "huge_pages", "false");
+
+    set_default("simulation", "tick_rate", "60");
+    set_default("simulation", "max_ticks", "5");
+
+    set_default("jobs", "worker_threads", "-1");
 
     set_default("video", "sync", "false");
     set_default("video", "maxfps", "-1");
@@ -51,8 +62,32 @@ void EngineConfiguration::validate() const throw(ConfigurationError)
 {
     Configuration::validate();
 
-    if(!is_int(get("memory", "pool"))) {
-        throw ConfigurationError("Memory pool must be an integer");
+    if(!is_int(get("memory", "system_pool")) || memory_system_pool() <= 0) {
+        throw ConfigurationError("Memory system pool must be a positive integer");
+    }
+
+    if(!is_int(get("memory", "object_pool")) || memory_object_pool() <= 0) {
+        throw ConfigurationError("Memory object pool must be a positive integer");
+    }
+
+    if(!is_int(get("memory", "frame_pool")) || memory_frame_pool() <= 0) {
+        throw ConfigurationError("Memory frame pool must be a positive integer");
+    }
+
+    if(!is_int(get("memory", "scene_pool")) || memory_scene_pool() <= 0) {
+        throw ConfigurationError("Memory scene pool must be a positive integer");
+    }
+
+    if(!is_int(get("simulation", "tick_rate")) || simulation_tick_rate() <= 0) {
+        throw ConfigurationError("Simulation tick rate must be a positive integer");
+    }
+
+    if(!is_int(get("simulation", "max_ticks")) || simulation_max_ticks() <= 0) {
+        throw ConfigurationError("Simulation max ticks must be a positive integer");
+    }
+
+    if(!is_int(get("jobs", "worker_threads"))) {
+        throw ConfigurationError("Jobs worker threads must be an integer");
     }
 
     if(video_maxfps() > 0 && video_maxfps() < 30) {
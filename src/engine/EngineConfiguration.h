@@ -32,7 +32,21 @@ public:
     void render_shadows(bool enable) { set("renderer", "shadows", to_string(enable)); }
     bool render_shadows() const { return to_boolean(get("renderer", "shadows").c_str()); }
 
-    int memory_pool() const { return std::atoi(get("memory", "pool").c_str()); }
+    // pool sizes are in MB
+    int memory_system_pool() const { return std::atoi(get("memory", "system_pool").c_str()); }
+    int memory_object_pool() const { return std::atoi(get("memory", "object_pool").c_str()); }
+    int memory_frame_pool() const { return std::atoi(get("memory", "frame_pool").c_str()); }
+    int memory_scene_pool() const { return std::atoi(get("memory", "scene_pool").c_str()); }
+    bool memory_huge_pages() const { return to_boolean(get("memory", "huge_pages")); }
+
+    // simulation ticks per second
+    int simulation_tick_rate() const { return std::atoi(get("simulation", "tick_rate").c_str()); }
+
+    // the most ticks the simulation will run to catch up after a stall
+    int simulation_max_ticks() const { return std::atoi(get("simulation", "max_ticks").c_str()); }
+
+    // threads in the job pool, a negative value means one less than the number of cores
+    int jobs_worker_threads() const { return std::atoi(get("jobs", "worker_threads").c_str()); }
 
     bool video_sync() const { return to_boolean(get("video", "sync").c_str()); }
     int video_maxfps() const { return std::atoi(get("video", "maxfps").c_str()); }
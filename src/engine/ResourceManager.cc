@@ -180,11 +180,7 @@ void ResourceManager::TextureImageResource::unload()
         return;
     }
 
-    boost::shared_ptr<DeleteTextureRenderCommand> command(
-        boost::dynamic_pointer_cast<DeleteTextureRenderCommand, RenderCommand>(
-            RenderCommand::new_render_command(RenderCommand::RC_DELETE_TEXTURE)));
-    command->texture = _texid;
-    Engine::instance().renderer().command_queue().push(command);
+    Engine::instance().renderer().command_queue().push(RenderCommand::delete_texture(_texid));
 
     _texid = 0;
     _loaded = false;
@@ -768,11 +764,8 @@ void ResourceManager::preload_material_textures(boost::shared_ptr<Material> mate
 
         // load the texture and allocate some space on the GPU
         if(resource && resource->load(&allocator)) {
-            boost::shared_ptr<GenTextureRenderCommand> command(
-                boost::dynamic_pointer_cast<GenTextureRenderCommand, RenderCommand>(
-                    RenderCommand::new_render_command(RenderCommand::RC_GEN_TEXTURE)));
-            command->callback = boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::DetailTexture, _1);
-            Engine::instance().renderer().command_queue().push(command);
+            Engine::instance().renderer().command_queue().push(RenderCommand::gen_texture(
+                boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::DetailTexture, _1)));
         }
     }
 
@@ -797,11 +790,8 @@ void ResourceManager::preload_material_textures(boost::shared_ptr<Material> mate
 
         // load the texture and allocate some space on the GPU
         if(resource && resource->load(&allocator)) {
-            boost::shared_ptr<GenTextureRenderCommand> command(
-                boost::dynamic_pointer_cast<GenTextureRenderCommand, RenderCommand>(
-                    RenderCommand::new_render_command(RenderCommand::RC_GEN_TEXTURE)));
-            command->callback = boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::NormalMap, _1);
-            Engine::instance().renderer().command_queue().push(command);
+            Engine::instance().renderer().command_queue().push(RenderCommand::gen_texture(
+                boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::NormalMap, _1)));
         }
     }
 
@@ -826,11 +816,8 @@ void ResourceManager::preload_material_textures(boost::shared_ptr<Material> mate
 
         // load the texture and allocate some space on the GPU
         if(resource && resource->load(&allocator)) {
-            boost::shared_ptr<GenTextureRenderCommand> command(
-                boost::dynamic_pointer_cast<GenTextureRenderCommand, RenderCommand>(
-                    RenderCommand::new_render_command(RenderCommand::RC_GEN_TEXTURE)));
-            command->callback = boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::SpecularMap, _1);
-            Engine::instance().renderer().command_queue().push(command);
+            Engine::instance().renderer().command_queue().push(RenderCommand::gen_texture(
+                boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::SpecularMap, _1)));
         }
     }
 
@@ -855,11 +842,8 @@ void ResourceManager::preload_material_textures(boost::shared_ptr<Material> mate
 
         // load the texture and allocate some space on the GPU
         if(resource && resource->load(&allocator)) {
-            boost::shared_ptr<GenTextureRenderCommand> command(
-                boost::dynamic_pointer_cast<GenTextureRenderCommand, RenderCommand>(
-                    RenderCommand::new_render_command(RenderCommand::RC_GEN_TEXTURE)));
-            command->callback = boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::EmissionMap, _1);
-            Engine::instance().renderer().command_queue().push(command);
+            Engine::instance().renderer().command_queue().push(RenderCommand::gen_texture(
+                boost::bind(&ResourceManager::texture_buffer_callback, this, resource, material, Renderable::TextureBuffers::EmissionMap, _1)));
         }
     }
 }
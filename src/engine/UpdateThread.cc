@@ -1,12 +1,16 @@
 #include "src/pch.h"
 #include "src/core/util/util.h"
+#include "scene/Scene.h"
 #include "ui/UIController.h"
 #include "Engine.h"
+#include "EngineConfiguration.h"
 #include "State.h"
 #include "UpdateThread.h"
 
 namespace energonsoftware {
 
+Logger& UpdateThread::logger(Logger::instance("gled.engine.UpdateThread"));
+
 void UpdateThread::destroy(UpdateThread* const thread, MemoryAllocator* const allocator)
 {
     thread->~UpdateThread();
@@ -14,22 +18,70 @@ void UpdateThread::destroy(UpdateThread* const thread, MemoryAllocator* const al
 }
 
 UpdateThread::UpdateThread()
-    : BaseThread("engine-update"), _last_update(0.0)
+    : BaseThread("engine-update"), _tick_length(0.0), _max_ticks(0),
+        _simulation_time(0.0), _tick_count(0), _dropped_ticks(0)
 {
+    const EngineConfiguration& config(EngineConfiguration::instance());
+    _tick_length = 1.0 / config.simulation_tick_rate();
+    _max_ticks = config.simulation_max_ticks();
 }
 
 UpdateThread::~UpdateThread() throw()
 {
 }
 
+float UpdateThread::interpolation(double state_time) const
+{
+    const double alpha = (get_monotonic_time() - state_time) / _tick_length;
+    return static_cast<float>(std::min(std::max(alpha, 0.0), 1.0));
+}
+
+void UpdateThread::tick()
+{
+    UIController::controller()->update(_tick_length);
+    Engine::instance().state().scene().update(_simulation_time + _tick_length, _tick_length);
+
+    _simulation_time += _tick_length;
+    _tick_count++;
+
+    Engine::instance().update_frame_allocator().swap_buffers();
+}
+
 void UpdateThread::on_run()
 {
-    _last_update = get_time();
+    LOG_INFO("Simulating at " << (1.0 / _tick_length) << " ticks per second\n");
+
+    double previous = get_monotonic_time();
+    double accumulator = 0.0;
 
     while(!should_quit()) {
-        UIController::controller()->update(get_time() - _last_update);
-        Engine::instance().state().scene().update();
-        _last_update = get_time();
+        const double now = get_monotonic_time();
+        accumulator += now - previous;
+        previous = now;
+
+        // if we fell too far behind, drop the time
+        // rather than spiral trying to catch up
+        const double max_accumulator = _max_ticks * _tick_length;
+        if(accumulator > max_accumulator) {
+            _dropped_ticks += static_cast<uint64_t>((accumulator - max_accumulator) / _tick_length);
+            accumulator = max_accumulator;
+        }
+
+        bool ticked = false;
+        while(accumulator >= _tick_length) {
+            tick();
+            accumulator -= _tick_length;
+            ticked = true;
+        }
+
+        // hand the new state to the renderer,
+        // whatever is left in the accumulator hasn't been simulated yet
+        if(ticked) {
+            Engine::instance().state().scene().publish_snapshot(_tick_count, now - accumulator);
+        }
+
+        // sleep until the next tick is due
+        boost::this_thread::sleep(boost::posix_time::microseconds(static_cast<int64_t>((_tick_length - accumulator) * 1000000.0)));
     }
 }
 
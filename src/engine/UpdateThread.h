@@ -5,19 +5,53 @@
 
 namespace energonsoftware {
 
+/*
+Runs the simulation at a fixed rate (Fix Your Timestep!, Glenn Fiedler)
+
+Real time is accumulated and consumed in fixed ticks, with a cap on how
+many ticks are run to catch up after a stall, and the thread sleeps
+until the next tick is due. After each batch of ticks the scene state
+is published as a SceneSnapshot for the render thread, which uses
+interpolation() to blend between the last two simulated states.
+*/
 class UpdateThread : public BaseThread
 {
+private:
+    static Logger& logger;
+
 public:
     static void destroy(UpdateThread* const state, MemoryAllocator* const allocator);
 
 public:
     virtual ~UpdateThread() throw();
 
+public:
+    // seconds per tick
+    double tick_length() const { return _tick_length; }
+
+    // how far (in [0, 1]) real time is past a simulated state,
+    // state_time being the SceneSnapshot::time of the state
+    // NOTE: this is safe to call from any thread
+    float interpolation(double state_time) const;
+
+    uint64_t tick_count() const { return _tick_count; }
+
+    // ticks that were skipped to avoid spiraling after a stall
+    uint64_t dropped_ticks() const { return _dropped_ticks; }
+
 private:
+    void tick();
+
     virtual void on_run();
 
 private:
-    double _last_update;
+    double _tick_length;
+    int _max_ticks;
+
+    // simulation time of the current state
+    double _simulation_time;
+
+    uint64_t _tick_count, _dropped_ticks;
 
 private:
     friend class Engine;
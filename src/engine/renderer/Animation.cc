@@ -1,8 +1,6 @@
 #include "src/pch.h"
 #include "src/core/common.h"
 #include "src/engine/DoomLexer.h"
-#include "src/engine/Engine.h"
-#include "src/engine/State.h"
 #include "Animation.h"
 
 namespace energonsoftware {
@@ -44,23 +42,12 @@ void Animation::unload() throw()
     on_unload();
 }
 
-void Animation::interpolate_skeleton(size_t current_frame, size_t next_frame, Skeleton& sk, double frame_percent) const
+void Animation::interpolate_skeleton(size_t current_frame, size_t next_frame, Skeleton& sk, float frame_percent) const
 {
-    // this is frame-local animation date, so put it on that allocator
-    MemoryAllocator& allocator(Engine::instance().frame_allocator());
-
     const Skeleton &cframe(skeleton(current_frame)), &nframe(skeleton(next_frame));
-    for(size_t i=0; i<this->joint_count(); ++i) {
-        const Skeleton::Joint& cfjoint(cframe.joint(i)), nfjoint(nframe.joint(i));
-
-        boost::shared_ptr<Skeleton::Joint> joint(new(16, allocator) Skeleton::Joint(),
-            boost::bind(&Skeleton::Joint::destroy, _1, &allocator));
-        joint->parent = cfjoint.parent >= 0 ? cfjoint.parent : -1;
-        joint->position = cfjoint.position.lerp(nfjoint.position, frame_percent);
-        joint->orientation = cfjoint.orientation.slerp(nfjoint.orientation, frame_percent);
+    assert(sk.stride() == cframe.stride() && sk.stride() == nframe.stride());
 
-        sk.add_joint(joint);
-    }
+    blend_poses(cframe.pose(), nframe.pose(), frame_percent, sk.pose(), sk.stride());
 }
 
 void Animation::frame_rate(int rate)
@@ -42,7 +42,8 @@ public:
     size_t joint_count() const { return _skeleton.joint_count(); }
     const Skeleton& skeleton(size_t idx) const { return *(_skeletons[idx]); }
 
-    const Skeleton::Joint& base_joint(size_t idx) const { return _skeleton.joint(idx); }
+    // the base frame, the frame skeletons are built from this
+    const Skeleton& base_skeleton() const { return _skeleton; }
 
     double frame_rate() const { return _frate; }
     double frame_duration() const { return _fduration; }
@@ -53,12 +54,13 @@ public:
 
     virtual void build_skeletons() {}
 
-    void interpolate_skeleton(size_t current_frame, size_t next_frame, Skeleton& skeleton, double frame_percent) const;
+    // blends two frames into a skeleton with the same hierarchy
+    void interpolate_skeleton(size_t current_frame, size_t next_frame, Skeleton& skeleton, float frame_percent) const;
 
 protected:
     void add_frame(boost::shared_ptr<Frame> frame) { _frames.push_back(frame); }
     void add_skeleton(boost::shared_ptr<Skeleton> skeleton) { _skeletons.push_back(skeleton); }
-    void add_base_joint(boost::shared_ptr<Skeleton::Joint> joint) { _skeleton.add_joint(joint); }
+    void add_base_joint(int parent, const Position& position, const Quaternion& orientation) { _skeleton.add_joint(parent, position, orientation); }
 
     void frame_rate(int rate);
 
@@ -1,6 +1,7 @@
 #if !defined __CAMERA_H__
 #define __CAMERA_H__
 
+#include "src/core/physics/Frustum.h"
 #include "src/core/physics/Physical.h"
 
 namespace energonsoftware {
@@ -10,9 +11,6 @@ class Camera : public Physical
 public:
     static void destroy(Camera* const camera, MemoryAllocator* const allocator);
 
-private:
-    static int check_clipping(const Vector4& clipped);
-
 public:
     Camera();
     virtual ~Camera() throw();
@@ -24,20 +22,38 @@ public:
     void attach(boost::shared_ptr<Physical> physical) { _attached = physical; }
     void detach() { _attached.reset(); }
 
-    // call every frame to adjust the view
-    // matrix based on the camera values
-    // also adjusts the camera position and orientation to
-    // match what it's attached to (if it's attached),
-    // so this needs to be called before referencing the camera position, etc
-    void look();
+    // call every frame to adjust the view matrix
+    // from the camera state published by the update thread
+    // this needs to be called before referencing eye() or frustum()
+    // NOTE: render thread only
+    void look(const Physical::Snapshot& state);
+
+    // where the renderer is looking from this frame
+    // NOTE: render thread only, use this rather than position() when rendering
+    const Position& eye() const { return _eye; }
+    const Direction& eye_up() const { return _eye_up; }
+
+    // the view frustum for this frame
+    // NOTE: render thread only
+    const Frustum& frustum() const { return _frustum; }
 
     // returns true if some portion of the world-space
     // bounding box is within the viewing frustum
-    bool visible(const AABB& bounds) const;
+    bool visible(const AABB& bounds) const { return _frustum.visible(bounds); }
+
+private:
+    // adjusts the camera position and orientation
+    // to match what it's attached to (if it's attached)
+    virtual bool on_simulate(double dt);
 
 private:
     boost::shared_ptr<Physical> _attached;
 
+    // only touched by the render thread
+    Position _eye;
+    Direction _eye_up;
+    Frustum _frustum;
+
 private:
     DISALLOW_COPY_AND_ASSIGN(Camera);
 };
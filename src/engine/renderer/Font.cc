@@ -197,10 +197,10 @@ void Font::render(const std::string& text, const Position& position, const Vecto
         const Position P(x2, y2, position.z());
 
         // vector from the quad to the camera
-        const Vector3 Z((camera.position() - P).normalized());
+        const Vector3 Z((camera.eye() - P).normalized());
 
         // vector in the billboard plane
-        const Vector3 A((camera.up() ^ Z).normalized());
+        const Vector3 A((camera.eye_up() ^ Z).normalized());
 
         // vector orthogonal to A
         const Vector3 B(Z ^ A);
@@ -60,17 +60,18 @@ void MD5Animation::build_skeletons()
     MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
 
     LOG_INFO("Building animation skeletons...\n");
+    const Skeleton& base(base_skeleton());
     for(size_t i=0; i<frame_count(); ++i) {
         const MD5Frame& md5frame(dynamic_cast<const MD5Frame&>(frame(i)));
 
         boost::shared_ptr<Skeleton> skeleton(new(16, allocator) Skeleton(), boost::bind(&Skeleton::destroy, _1, &allocator));
+        skeleton->reserve(joint_count());
         for(size_t j=0; j<joint_count(); ++j) {
             const AnimationJoint& ajoint(_askeleton[j]);
-            const Skeleton::Joint& bjoint(base_joint(j));
 
             // start with the base frame
-            Position position(bjoint.position);
-            Quaternion orientation(bjoint.orientation);
+            Position position(base.position(j));
+            Quaternion orientation(base.orientation(j));
 
             // update the joint based on the frame data
             // TODO: find a better way to swizzle this
@@ -102,21 +103,14 @@ void MD5Animation::build_skeletons()
             orientation.compute_scalar();
 
             // joint depends on the parent unless it's a root
-            boost::shared_ptr<Skeleton::Joint> joint(new(16, allocator) Skeleton::Joint(),
-                boost::bind(&Skeleton::Joint::destroy, _1, &allocator));
             if(ajoint.parent >= 0) {
-                joint->parent = ajoint.parent;
-
-                const Skeleton::Joint& parent(skeleton->joint(ajoint.parent));
-                joint->position = parent.position + (parent.orientation * position);
-                joint->orientation = parent.orientation * orientation;
-                joint->orientation.normalize();
+                const Position parent_position(skeleton->position(ajoint.parent));
+                const Quaternion parent_orientation(skeleton->orientation(ajoint.parent));
+                skeleton->add_joint(ajoint.parent, parent_position + (parent_orientation * position),
+                    (parent_orientation * orientation).normalize());
             } else {
-                joint->parent = -1;
-                joint->position = position;
-                joint->orientation = orientation;
+                skeleton->add_joint(-1, position, orientation);
             }
-            skeleton->add_joint(joint);
         }
         add_skeleton(skeleton);
     }
@@ -296,7 +290,6 @@ bool MD5Animation::scan_hierarchy(Lexer& lexer, int count)
         }
 
         AnimationJoint& joint(_askeleton[i]);
-        joint.name = name;
         joint.parent = parent;
         joint.acflag = flag;
         joint.acstart = start;
@@ -391,9 +384,6 @@ bool MD5Animation::scan_baseframe(Lexer& lexer, int count)
         return false;
     }
 
-    // animations go on the scene allocator
-    MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
-
     for(int i=0; i<count; ++i) {
         if(!lexer.match(DoomLexer::OPEN_PAREN)) {
             return false;
@@ -448,11 +438,7 @@ bool MD5Animation::scan_baseframe(Lexer& lexer, int count)
             return false;
         }
 
-        boost::shared_ptr<Skeleton::Joint> joint(new(16, allocator) Skeleton::Joint(),
-            boost::bind(&Skeleton::Joint::destroy, _1, &allocator));
-        joint->position = swizzle(position);
-        joint->orientation = Quaternion(swizzle(orientation));
-        add_base_joint(joint);
+        add_base_joint(_askeleton[i].parent, swizzle(position), Quaternion(swizzle(orientation)));
     }
 
     return lexer.match(DoomLexer::CLOSE_BRACE);
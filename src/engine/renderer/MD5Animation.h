@@ -11,11 +11,13 @@ class Lexer;
 class MD5Animation : public Animation
 {
 private:
-    struct AnimationJoint : public Skeleton::Joint
+    // NOTE: joint names are only kept by the model
+    struct AnimationJoint
     {
         static AnimationJoint* create_array(size_t count, MemoryAllocator& allocator);
         static void destroy_array(AnimationJoint* const joint, size_t count, MemoryAllocator* const allocator);
 
+        int parent;
         int acflag, acstart;
     };
     typedef boost::shared_array<AnimationJoint> AnimationSkeleton;
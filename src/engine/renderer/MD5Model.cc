@@ -141,6 +141,7 @@ bool MD5Model::scan_joints(Lexer& lexer, int count)
         return false;
     }
 
+    skeleton().reserve(count);
     for(int i=0; i<count; ++i) {
         if(!scan_joint(lexer)) {
             return false;
@@ -215,16 +216,7 @@ bool MD5Model::scan_joint(Lexer& lexer)
         return false;
     }
 
-    // animations go on the scene allocator
-    MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
-
-    boost::shared_ptr<Skeleton::Joint> joint(new(16, allocator) Skeleton::Joint(),
-        boost::bind(&Skeleton::Joint::destroy, _1, &allocator));
-    joint->name = name;
-    joint->parent = parent;
-    joint->position = swizzle(position);
-    joint->orientation = Quaternion(swizzle(orientation));
-    skeleton().add_joint(joint);
+    skeleton().add_joint(name, parent, swizzle(position), Quaternion(swizzle(orientation)));
 
     return true;
 }
@@ -1,5 +1,6 @@
 #include "src/pch.h"
 #include "src/core/common.h"
+#include "src/core/util/ScopedStackMarker.h"
 #include "src/engine/Engine.h"
 #include "src/engine/ResourceManager.h"
 #include "src/engine/State.h"
@@ -44,11 +45,10 @@ void Mesh::pose(const Skeleton& skeleton)
         if(has_weights()) {
             for(int j=0; j<vertex.weight_count; ++j) {
                 const Weight& weight(_weights[vertex.weight_start + j]);
-                const Skeleton::Joint& joint(skeleton.joint(weight.joint));
 
                 // convert the joint to object space and weight the vertex
-                const Position wpos(joint.orientation * weight.position);
-                position += ((wpos + joint.position) * weight.weight);
+                const Position wpos(skeleton.orientation(weight.joint) * weight.position);
+                position += ((wpos + skeleton.position(weight.joint)) * weight.weight);
             }
             vertex.position = position;
         } else {
@@ -63,7 +63,11 @@ void Mesh::pose(const Skeleton& skeleton)
 void Mesh::compute_normals(const Skeleton& skeleton, bool smooth)
 {
     // store the temporary vectors on the frame allocator
-    compute_tangents(_triangles, _tcount, _vertices, _vcount, Engine::instance().frame_allocator());
+    {
+        DoubleBufferedAllocator& allocator(Engine::instance().frame_allocator());
+        ScopedStackMarker<DoubleBufferedAllocator> marker(allocator);
+        compute_tangents(_triangles, _tcount, _vertices, _vcount, allocator);
+    }
 
     if(has_weights()) {
         // store the weighted vertex data in joint-space
@@ -73,10 +77,9 @@ void Mesh::compute_normals(const Skeleton& skeleton, bool smooth)
             // put the normals and tangents into joint space
             for(int j=0; j<vertex.weight_count; ++j) {
                 Weight& weight(_weights[vertex.weight_start + j]);
-                const Skeleton::Joint& joint(skeleton.joint(weight.joint));
 
                 // convert to joint-space and store
-                Quaternion inv(joint.orientation.inverse());
+                Quaternion inv(skeleton.orientation(weight.joint).inverse());
                 weight.normal += inv * vertex.normal;
                 weight.tangent += inv * vertex.tangent;
                 weight.bitangent += inv * vertex.bitangent;
@@ -95,36 +98,71 @@ void Mesh::compute_normals(const Skeleton& skeleton, bool smooth)
 
 void Mesh::weld_vertices()
 {
-    // find the vertices that need to be welded
-    boost::unordered_map<int, int> vertices;
-    for(int i=0; i<_vcount; ++i) {
-        for(int j=i+1; j<_vcount; ++j) {
-            const Vertex &v1(_vertices[i]), &v2(_vertices[j]);
-            if(v1.position.distance_squared(v2.position) < 0.001f
-                && v1.texture_coords.distance_squared(v2.texture_coords) < 0.001f)
-            {
-                vertices[v1.index] = v2.index;
-            }
-        }
+    const size_t vcount = energonsoftware::weld_vertices(_vertices.get(), _vcount, _triangles.get(), _tcount);
+    if(vcount < static_cast<size_t>(_vcount)) {
+        LOG_INFO("Welded " << (_vcount - vcount) << " vertices\n");
     }
+    _vcount = static_cast<int>(vcount);
+}
 
-    // weld them
-    weld_vertices(vertices);
+void Mesh::optimize_triangles()
+{
+    const size_t misses = vertex_cache_misses(_triangles.get(), _tcount, _vcount);
+    optimize_vertex_cache(_triangles.get(), _tcount, _vcount);
+    optimize_vertex_fetch(_vertices.get(), _vcount, _triangles.get(), _tcount);
+
+    if(_tcount > 0) {
+        LOG_INFO("Vertex cache ACMR " << (misses / static_cast<float>(_tcount))
+            << " -> " << (vertex_cache_misses(_triangles.get(), _tcount, _vcount) / static_cast<float>(_tcount)) << "\n");
+    }
 }
 
 void Mesh::compute_edges()
 {
-    // Mathematics for 3D Game Programming and Computer Graphics, section 10.3.3
-    for(int i=0; i<_tcount; ++i) {
-        calculate_edge(_triangles[i], i);
+    energonsoftware::compute_edges(_triangles.get(), _tcount, _edges);
+}
+
+void Mesh::build_skin_weights()
+{
+    _skin_weights.clear();
+    _skin_counts.clear();
+    if(!has_weights()) {
+        return;
+    }
+
+    _skin_counts.reserve(_vcount);
+    for(int i=0; i<_vcount; ++i) {
+        const Vertex& vertex(_vertices[i]);
+        _skin_counts.push_back(vertex.weight_count);
+
+        for(int j=0; j<vertex.weight_count; ++j) {
+            const Weight& weight(_weights[vertex.weight_start + j]);
+
+            SkinWeight skin_weight = SkinWeight();
+            skin_weight.position[0] = weight.position.x() * weight.weight;
+            skin_weight.position[1] = weight.position.y() * weight.weight;
+            skin_weight.position[2] = weight.position.z() * weight.weight;
+            skin_weight.position[3] = weight.weight;
+            for(int k=0; k<3; ++k) {
+                skin_weight.normal[k] = weight.normal[k];
+                skin_weight.tangent[k] = weight.tangent[k];
+                skin_weight.bitangent[k] = weight.bitangent[k];
+            }
+            skin_weight.joint = weight.joint;
+            _skin_weights.push_back(skin_weight);
+        }
     }
-    find_matching_edges();
 }
 
-void Mesh::calculate_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, size_t vstart, Geometry& geometry, size_t tstart) const
+void Mesh::calculate_vertices(const float* palette, boost::shared_array<Vertex> vertices, size_t vstart, Geometry& geometry) const
 {
-    position_vertices(skeleton, vertices, vstart);
-    geometry.copy_triangles(_triangles.get(), _tcount, vertices.get() + vstart, _vcount, tstart * 3);
+    position_vertices(palette, vertices, vstart);
+    geometry.copy_vertices(vertices.get() + vstart, _vcount, vstart);
+}
+
+void Mesh::calculate_indices(Geometry& geometry, size_t vstart, size_t tstart) const
+{
+    geometry.copy_indices(_triangles.get(), _tcount, vstart, tstart * 3);
 }
 
 void Mesh::init_textures()
@@ -146,156 +184,42 @@ void Mesh::init_textures()
     }
 }
 
-void Mesh::position_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, size_t vstart) const
+void Mesh::position_vertices(const float* palette, boost::shared_array<Vertex> vertices, size_t vstart) const
 {
-    for(int i=0; i<_vcount; ++i) {
-        const Vertex& meshvertex(_vertices[i]);
-
-        Position position;
-        Vector3 normal, tangent, bitangent;
-        if(has_weights()) {
-            for(int j=0; j<meshvertex.weight_count; ++j) {
-                const Weight& weight(_weights[meshvertex.weight_start + j]);
-                const Skeleton::Joint& joint(skeleton.joint(weight.joint));
-
-                // convert the joint to object space and weight the vertex attributes
-                const Position wpos(joint.orientation * weight.position);
-                position += ((wpos + joint.position) * weight.weight);
-                normal += (joint.orientation * weight.normal);
-                tangent += (joint.orientation * weight.tangent);
-                bitangent += (joint.orientation * weight.bitangent);
-            }
-        } else {
-            position = meshvertex.position;
-            normal = meshvertex.normal;
-            tangent = meshvertex.tangent;
-            bitangent = meshvertex.bitangent;
+    if(!has_weights() || _skin_weights.empty()) {
+        for(int i=0; i<_vcount; ++i) {
+            const Vertex& meshvertex(_vertices[i]);
+
+            Vertex& vertex(vertices[vstart + i]);
+            vertex.index = meshvertex.index;
+            vertex.position = meshvertex.position;
+            vertex.normal = meshvertex.normal.normalized();
+            vertex.tangent = meshvertex.tangent.normalized();
+            vertex.bitangent = meshvertex.bitangent.normalized();
+            vertex.texture_coords = meshvertex.texture_coords;
         }
-
-        Vertex& vertex(vertices[vstart + i]);
-        vertex.index = meshvertex.index;
-        vertex.position = position;
-        vertex.normal = normal.normalized();
-        vertex.tangent = tangent.normalize();
-        vertex.bitangent = bitangent.normalized();
-        vertex.texture_coords = meshvertex.texture_coords;
-    }
-}
-
-void Mesh::weld_vertices(const boost::unordered_map<int, int>& vertices)
-{
-    if(0 == vertices.size()) {
         return;
     }
 
-    LOG_INFO("Welding " << vertices.size() << " vertices\n");
+    // skin into scratch space on the frame allocator
+    DoubleBufferedAllocator& allocator(Engine::instance().frame_allocator());
+    ScopedStackMarker<DoubleBufferedAllocator> marker(allocator);
 
-    // meshes go on the scene allocator
-    MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
+    SkinnedVertex* skinned = reinterpret_cast<SkinnedVertex*>(static_cast<MemoryAllocator&>(allocator).allocate(sizeof(SkinnedVertex) * _vcount, 16));
+    skin_vertices(palette, &_skin_weights[0], &_skin_counts[0], _vcount, skinned);
 
-    const size_t vcount = _vcount - vertices.size();
-    boost::shared_array<Vertex> v(Vertex::create_array(vcount, allocator),
-        boost::bind(&Vertex::destroy_array, _1, vcount, &allocator));
-
-    size_t j=0;
     for(int i=0; i<_vcount; ++i) {
-        const Vertex& vertex(_vertices[i]);
-        if(vertices.end() == vertices.find(vertex.index)) {
-            // copy the vertex and update it's index
-            Vertex& new_vertex(v[j]);
-            new_vertex = vertex;
-            new_vertex.index = j;
-            fix_triangles(vertex.index, new_vertex.index);
-            j++;
-        } else {
-            // point triangles at the new vertex
-            fix_triangles(i, vertices.at(i));
-        }
-    }
-
-    _vcount = vcount;
-    _vertices = v;
-}
-
-void Mesh::fix_triangles(int old_index, int new_index)
-{
-    for(int i=0; i<_tcount; ++i) {
-        Triangle& triangle(_triangles[i]);
-        if(triangle.v1 == old_index) {
-            triangle.v1 = new_index;
-        } else if(triangle.v2 == old_index) {
-            triangle.v2 = new_index;
-        } else if(triangle.v3 == old_index) {
-            triangle.v3 = new_index;
-        }
-    }
-}
-
-void Mesh::calculate_edge(const Triangle& triangle, int t)
-{
-    // Mathematics for 3D Game Programming and Computer Graphics, section 10.3.3
-    if(triangle.v1 < triangle.v2) {
-        Edge edge;
-        edge.v1 = triangle.v1;
-        edge.v2 = triangle.v2;
-        edge.t1 = t;
-        _edges.push_back(edge);
-    }
-
-    if(triangle.v2 < triangle.v3) {
-        Edge edge;
-        edge.v1 = triangle.v2;
-        edge.v2 = triangle.v3;
-        edge.t1 = t;
-        _edges.push_back(edge);
-    }
-
-    if(triangle.v3 < triangle.v1) {
-        Edge edge;
-        edge.v1 = triangle.v3;
-        edge.v2 = triangle.v1;
-        edge.t1 = t;
-        _edges.push_back(edge);
-    }
-}
-
-void Mesh::find_matching_edges()
-{
-    // Mathematics for 3D Game Programming and Computer Graphics, section 10.3.3
-    for(int i=0; i<_tcount; ++i) {
-        const Triangle& triangle(_triangles[i]);
-
-        if(triangle.v1 > triangle.v2) {
-            find_matching_edge(triangle.v2, triangle.v1, i);
-        }
-
-        if(triangle.v2 > triangle.v3) {
-            find_matching_edge(triangle.v3, triangle.v2, i);
-        }
-
-        if(triangle.v3 > triangle.v1) {
-            find_matching_edge(triangle.v1, triangle.v3, i);
-        }
-    }
-}
+        const Vertex& meshvertex(_vertices[i]);
+        const SkinnedVertex& skinned_vertex(skinned[i]);
 
-void Mesh::find_matching_edge(int v1, int v2, int t)
-{
-    // Mathematics for 3D Game Programming and Computer Graphics, section 10.3.3
-    BOOST_FOREACH(Edge& edge, _edges) {
-        if(edge.v1 == v1 && edge.v2 == v2 && edge.t2 < 0) {
-            edge.t2 = t;
-            return;
-        }
+        Vertex& vertex(vertices[vstart + i]);
+        vertex.index = meshvertex.index;
+        vertex.position = Position(skinned_vertex.position[0], skinned_vertex.position[1], skinned_vertex.position[2]);
+        vertex.normal = Vector3(skinned_vertex.normal[0], skinned_vertex.normal[1], skinned_vertex.normal[2]);
+        vertex.tangent = Vector3(skinned_vertex.tangent[0], skinned_vertex.tangent[1], skinned_vertex.tangent[2]);
+        vertex.bitangent = Vector3(skinned_vertex.bitangent[0], skinned_vertex.bitangent[1], skinned_vertex.bitangent[2]);
+        vertex.texture_coords = meshvertex.texture_coords;
     }
-
-    // didn't find a match, so this is a one-winged edge
-    // TODO: not sure if I'm setting the v1/v2 properties correctly
-    Edge edge;
-    edge.v1 = v1;
-    edge.v2 = v2;
-    edge.t1 = t;
-    _edges.push_back(edge);
 }
 
 }
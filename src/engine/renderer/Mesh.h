@@ -2,6 +2,7 @@
 #define __MESH_H__
 
 #include "src/core/math/Geometry.h"
+#include "src/core/math/simd_util.h"
 #include "src/core/physics/AABB.h"
 #include "Renderable.h"
 
@@ -54,12 +55,25 @@ public:
 
     void compute_normals(const Skeleton& skeleton, bool smooth=false);
     void weld_vertices();
+
+    // reorders the triangles for the vertex cache and then the vertices for fetching
+    // NOTE: this must be called before the edges are computed
+    void optimize_triangles();
+
     void compute_edges();
 
+    // flattens the (joint-space) weights into skinning order
+    // NOTE: this must be called after the normals are computed
+    void build_skin_weights();
+
     // puts the vertices for this mesh into the given buffers
-    // vstart is the vertex-based index into vertices
-    // tstart is the triangle-based buffer index
-    void calculate_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, size_t vstart, Geometry& geometry, size_t tstart) const;
+    // palette is the skeleton's matrix palette (ignored if the mesh has no weights)
+    // vstart is the vertex-based index into vertices and the geometry
+    void calculate_vertices(const float* palette, boost::shared_array<Vertex> vertices, size_t vstart, Geometry& geometry) const;
+
+    // puts the triangles for this mesh into the geometry's index buffer
+    // vstart is the mesh's first vertex and tstart is its first triangle
+    void calculate_indices(Geometry& geometry, size_t vstart, size_t tstart) const;
 
 private:
     friend class Model;
@@ -67,12 +81,7 @@ private:
     void init_textures();
 
 private:
-    void position_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, size_t vstart) const;
-    void weld_vertices(const boost::unordered_map<int, int>& vertices);
-    void fix_triangles(int old_index, int new_index);
-    void calculate_edge(const Triangle& triangle, int t);
-    void find_matching_edges();
-    void find_matching_edge(int v1, int v2, int t);
+    void position_vertices(const float* palette, boost::shared_array<Vertex> vertices, size_t vstart) const;
 
 private:
     boost::shared_ptr<Material> _material;
@@ -87,6 +96,10 @@ private:
     int _wcount;
     boost::shared_array<Weight> _weights;
 
+    // the weights in vertex order, ready for skin_vertices()
+    std::vector<SkinWeight> _skin_weights;
+    std::vector<uint32_t> _skin_counts;
+
     std::vector<Edge> _edges;
 
     Renderable::TextureBuffers _texture_buffers;
@@ -1,5 +1,6 @@
 #include "src/pch.h"
 #include "src/core/common.h"
+#include "src/core/util/ScopedStackMarker.h"
 #include "src/engine/DoomLexer.h"
 #include "src/engine/Engine.h"
 #include "src/engine/State.h"
@@ -9,12 +10,6 @@
 
 namespace energonsoftware {
 
-void Skeleton::Joint::destroy(Joint* const joint, MemoryAllocator* const allocator)
-{
-    joint->~Joint();
-    operator delete(joint, 16, *allocator);
-}
-
 void Skeleton::destroy(Skeleton* const skeleton, MemoryAllocator* const allocator)
 {
     skeleton->~Skeleton();
@@ -22,7 +17,7 @@ void Skeleton::destroy(Skeleton* const skeleton, MemoryAllocator* const allocato
 }
 
 Skeleton::Skeleton()
-    : _nonroot_joint_count(0)
+    : _stride(0), _nonroot_joint_count(0)
 {
 }
 
@@ -30,20 +25,94 @@ Skeleton::~Skeleton() throw()
 {
 }
 
-void Skeleton::add_joint(boost::shared_ptr<Joint> joint)
+void Skeleton::position(size_t idx, const Position& position)
+{
+    _pose[(PosePositionX * _stride) + idx] = position.x();
+    _pose[(PosePositionY * _stride) + idx] = position.y();
+    _pose[(PosePositionZ * _stride) + idx] = position.z();
+}
+
+Quaternion Skeleton::orientation(size_t idx) const
 {
-    _joints.push_back(joint);
-    if(joint->parent >= 0) {
+    Quaternion orientation;
+    orientation.vector() = Vector3(_pose[(PoseOrientationX * _stride) + idx], _pose[(PoseOrientationY * _stride) + idx], _pose[(PoseOrientationZ * _stride) + idx]);
+    orientation.scalar(_pose[(PoseOrientationW * _stride) + idx]);
+    return orientation;
+}
+
+void Skeleton::orientation(size_t idx, const Quaternion& orientation)
+{
+    _pose[(PoseOrientationX * _stride) + idx] = orientation.vector().x();
+    _pose[(PoseOrientationY * _stride) + idx] = orientation.vector().y();
+    _pose[(PoseOrientationZ * _stride) + idx] = orientation.vector().z();
+    _pose[(PoseOrientationW * _stride) + idx] = orientation.scalar();
+}
+
+void Skeleton::reserve(size_t count)
+{
+    _parents.reserve(count);
+    if(pose_stride(count) > _stride) {
+        relayout(pose_stride(count));
+    }
+}
+
+void Skeleton::add_joint(const std::string& name, int parent, const Position& position, const Quaternion& orientation)
+{
+    _names.resize(joint_count());
+    _names.push_back(name);
+    add_joint(parent, position, orientation);
+}
+
+void Skeleton::add_joint(int parent, const Position& position, const Quaternion& orientation)
+{
+    const size_t idx = joint_count();
+    if(idx >= _stride) {
+        relayout(pose_stride(idx + 1));
+    }
+
+    _parents.push_back(parent);
+    if(parent >= 0) {
         _nonroot_joint_count++;
     }
+
+    this->position(idx, position);
+    this->orientation(idx, orientation);
+}
+
+void Skeleton::copy_hierarchy(const Skeleton& skeleton)
+{
+    reset();
+
+    _parents = skeleton._parents;
+    _nonroot_joint_count = skeleton._nonroot_joint_count;
+    relayout(skeleton._stride);
 }
 
 void Skeleton::reset()
 {
-    _joints.clear();
+    _names.clear();
+    _parents.clear();
+    _pose.clear();
+    _stride = 0;
     _nonroot_joint_count = 0;
 }
 
+void Skeleton::relayout(size_t stride)
+{
+    // every joint (and the padding) starts at the identity
+    std::vector<float> pose(stride * PoseStreamCount, 0.0f);
+    std::fill(pose.begin() + (PoseOrientationW * stride), pose.end(), 1.0f);
+
+    // copy each stream over from the old layout
+    const size_t count = std::min(_stride, stride);
+    for(size_t i=0; i<PoseStreamCount && count > 0; ++i) {
+        std::copy(_pose.begin() + (i * _stride), _pose.begin() + (i * _stride) + count, pose.begin() + (i * stride));
+    }
+
+    _pose.swap(pose);
+    _stride = stride;
+}
+
 Logger& Model::logger(Logger::instance("gled.engine.renderer.Model"));
 
 void Model::destroy(Model* const model, MemoryAllocator* const allocator)
@@ -90,11 +159,31 @@ void Model::unload() throw()
 }
 
 void Model::calculate_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, Geometry& geometry) const
+{
+    // build the joint matrices once for every mesh to share
+    DoubleBufferedAllocator& allocator(Engine::instance().frame_allocator());
+    ScopedStackMarker<DoubleBufferedAllocator> marker(allocator);
+
+    float* palette = NULL;
+    if(skeleton.joint_count() > 0) {
+        palette = reinterpret_cast<float*>(static_cast<MemoryAllocator&>(allocator).allocate(sizeof(float) * PaletteMatrixSize * skeleton.joint_count(), 16));
+        skeleton.palette(palette);
+    }
+
+    size_t vstart=0;
+    for(size_t i=0; i<_meshes.size(); ++i) {
+        const Mesh& m(mesh(i));
+        m.calculate_vertices(palette, vertices, vstart, geometry);
+        vstart += m.vertex_count();
+    }
+}
+
+void Model::calculate_indices(Geometry& geometry) const
 {
     size_t vstart=0, tstart=0;
     for(size_t i=0; i<_meshes.size(); ++i) {
         const Mesh& m(mesh(i));
-        m.calculate_vertices(skeleton, vertices, vstart, geometry, tstart);
+        m.calculate_indices(geometry, vstart, tstart);
 
         vstart += m.vertex_count();
         tstart += m.triangle_count();
@@ -112,10 +201,14 @@ void Model::add_mesh(boost::shared_ptr<Mesh> mesh, bool has_normals, bool has_ed
         mesh->compute_normals(_skeleton);
     }
 
+    // NOTE: loaded edges refer to the triangles in their original order
     if(!has_edges) {
+        mesh->optimize_triangles();
         mesh->compute_edges();
     }
 
+    mesh->build_skin_weights();
+
     // update some model-wide properties
     _vcount += mesh->vertex_count();
     _tcount += mesh->triangle_count();
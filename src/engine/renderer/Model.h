@@ -3,6 +3,7 @@
 
 #include "src/core/math/Quaternion.h"
 #include "src/core/math/Vector.h"
+#include "src/core/math/simd_util.h"
 #include "src/core/physics/AABB.h"
 
 namespace energonsoftware {
@@ -13,19 +14,15 @@ class Geometry;
 struct Triangle;
 struct Vertex;
 
+/*
+A pose for every joint in a hierarchy
+
+Joint transforms live in a single flat pose buffer (see simd_util.h)
+so that whole skeletons can be blended at once, and the hierarchy is
+just an array of parent indices. Only bind skeletons keep joint names.
+*/
 class Skeleton
 {
-public:
-    struct Joint
-    {
-        static void destroy(Joint* const joint, MemoryAllocator* const allocator);
-
-        std::string name;
-        int parent;
-        Position position;
-        Quaternion orientation;
-    };
-
 public:
     static void destroy(Skeleton* const skeleton, MemoryAllocator* const allocator);
 
@@ -34,19 +31,56 @@ public:
     virtual ~Skeleton() throw();
 
 public:
-    size_t joint_count() const { return _joints.size(); }
+    size_t joint_count() const { return _parents.size(); }
     size_t nonroot_joint_count() const { return _nonroot_joint_count; }
 
-    Joint& joint(size_t idx) { return *_joints[idx]; }
-    const Joint& joint(size_t idx) const { return *_joints[idx]; }
+    // joints per pose stream
+    size_t stride() const { return _stride; }
+
+    bool has_names() const { return !_names.empty(); }
+    const std::string& name(size_t idx) const { return _names[idx]; }
+
+    // NOTE: roots have a negative parent
+    int parent(size_t idx) const { return _parents[idx]; }
+
+    Position position(size_t idx) const
+    {
+        return Position(_pose[(PosePositionX * _stride) + idx], _pose[(PosePositionY * _stride) + idx], _pose[(PosePositionZ * _stride) + idx]);
+    }
+
+    void position(size_t idx, const Position& position);
+
+    Quaternion orientation(size_t idx) const;
+    void orientation(size_t idx, const Quaternion& orientation);
+
+    float* pose() { return _pose.empty() ? NULL : &_pose[0]; }
+    const float* pose() const { return _pose.empty() ? NULL : &_pose[0]; }
+
+    // builds the matrix palette for the current pose,
+    // palette must hold joint_count() * PaletteMatrixSize floats
+    void palette(float* palette) const { pose_palette(pose(), _stride, joint_count(), palette); }
+
+    // avoids laying out the pose again while joints are added
+    void reserve(size_t count);
 
-    void add_joint(boost::shared_ptr<Joint> joint);
+    void add_joint(const std::string& name, int parent, const Position& position, const Quaternion& orientation);
+    void add_joint(int parent, const Position& position, const Quaternion& orientation);
+
+    // copies the hierarchy (but not the names) from another skeleton,
+    // every joint starts out at the identity
+    void copy_hierarchy(const Skeleton& skeleton);
 
     void reset();
 
 private:
-    std::vector<boost::shared_ptr<Joint> > _joints;
+    void relayout(size_t stride);
+
+private:
+    std::vector<std::string> _names;
+    std::vector<int> _parents;
+    std::vector<float> _pose;
 
+    size_t _stride;
     size_t _nonroot_joint_count;
 
 private:
@@ -70,8 +104,8 @@ public:
     const std::string& name() const { return _name; }
 
     size_t joint_count() const { return _skeleton.joint_count(); }
-    const Skeleton::Joint& joint(size_t idx) const { return _skeleton.joint(idx); }
 
+    // the bind pose
     Skeleton& skeleton() { return _skeleton; }
     const Skeleton& skeleton() const { return _skeleton; }
 
@@ -92,6 +126,9 @@ public:
 
     void calculate_vertices(const Skeleton& skeleton, boost::shared_array<Vertex> vertices, Geometry& geometry) const;
 
+    // the triangles don't change with the pose, so this only needs to be done once
+    void calculate_indices(Geometry& geometry) const;
+
 protected:
     void add_mesh(boost::shared_ptr<Mesh> mesh, bool has_normals, bool has_edges);
 
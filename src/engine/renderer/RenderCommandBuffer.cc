@@ -0,0 +1,360 @@
+#include "src/pch.h"
+#include "src/core/math/Matrix4.h"
+#include "src/core/math/VertexLayout.h"
+#include "Shader.h"
+#include "RenderCommandBuffer.h"
+
+namespace energonsoftware {
+
+RenderCommandBuffer::RenderCommandBuffer()
+    : _draw_count(0)
+{
+}
+
+RenderCommandBuffer::~RenderCommandBuffer() throw()
+{
+}
+
+void RenderCommandBuffer::clear()
+{
+    _commands.clear();
+    _data.clear();
+    _draw_count = 0;
+}
+
+void RenderCommandBuffer::reserve(size_t commands, size_t floats)
+{
+    _commands.reserve(commands);
+    _data.reserve(floats);
+}
+
+void RenderCommandBuffer::append(const RenderCommandBuffer& buffer)
+{
+    const uint32_t base = static_cast<uint32_t>(_data.size());
+    _data.insert(_data.end(), buffer._data.begin(), buffer._data.end());
+
+    const size_t start = _commands.size();
+    _commands.insert(_commands.end(), buffer._commands.begin(), buffer._commands.end());
+
+    // rebase the data offsets
+    for(size_t i=start; i<_commands.size(); ++i) {
+        Command& command(_commands[i]);
+        switch(command.type)
+        {
+        case Uniform3fv:
+        case Uniform4fv:
+        case UniformMatrix4fv:
+            command.params.uniformfv.offset += base;
+            break;
+        default:
+            break;
+        }
+    }
+
+    _draw_count += buffer._draw_count;
+}
+
+void RenderCommandBuffer::bind_program(const Shader& shader)
+{
+    Command command;
+    command.type = BindProgram;
+    command.params.program.program = shader.program();
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::bind_texture(GLuint unit, GLuint texture, GLenum target)
+{
+    assert(unit < MaxTextureUnits);
+
+    Command command;
+    command.type = BindTexture;
+    command.params.texture.unit = unit;
+    command.params.texture.target = target;
+    command.params.texture.texture = texture;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform1i(GLint location, GLint value)
+{
+    if(location < 0) {
+        return;
+    }
+
+    Command command;
+    command.type = Uniform1i;
+    command.params.uniform1i.location = location;
+    command.params.uniform1i.value = value;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform1f(GLint location, GLfloat value)
+{
+    if(location < 0) {
+        return;
+    }
+
+    Command command;
+    command.type = Uniform1f;
+    command.params.uniform1f.location = location;
+    command.params.uniform1f.value = value;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform3f(GLint location, const Vector3& value)
+{
+    if(location < 0) {
+        return;
+    }
+
+    Command command;
+    command.type = Uniform3fv;
+    command.params.uniformfv.location = location;
+    command.params.uniformfv.count = 1;
+    command.params.uniformfv.offset = push_data(value.array(), 3);
+    command.params.uniformfv.transpose = GL_FALSE;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform4f(GLint location, const Vector4& value)
+{
+    if(location < 0) {
+        return;
+    }
+
+    Command command;
+    command.type = Uniform4fv;
+    command.params.uniformfv.location = location;
+    command.params.uniformfv.count = 1;
+    command.params.uniformfv.offset = push_data(value.array(), 4);
+    command.params.uniformfv.transpose = GL_FALSE;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform_matrix4fv(GLint location, const Matrix4& value, bool transpose)
+{
+    if(location < 0) {
+        return;
+    }
+
+    Command command;
+    command.type = UniformMatrix4fv;
+    command.params.uniformfv.location = location;
+    command.params.uniformfv.count = 1;
+    command.params.uniformfv.offset = push_data(value.array(), 16);
+    command.params.uniformfv.transpose = transpose ? GL_TRUE : GL_FALSE;
+    _commands.push_back(command);
+}
+
+void RenderCommandBuffer::uniform1i(const Shader& shader, const std::string& name, GLint value)
+{
+    uniform1i(shader.find_uniform_location(name), value);
+}
+
+void RenderCommandBuffer::uniform1f(const Shader& shader, const std::string& name, GLfloat value)
+{
+    uniform1f(shader.find_uniform_location(name), value);
+}
+
+void RenderCommandBuffer::uniform3f(const Shader& shader, const std::string& name, const Vector3& value)
+{
+    uniform3f(shader.find_uniform_location(name), value);
+}
+
+void RenderCommandBuffer::uniform4f(const Shader& shader, const std::string& name, const Vector4& value)
+{
+    uniform4f(shader.find_uniform_location(name), value);
+}
+
+void RenderCommandBuffer::uniform_matrix4fv(const Shader& shader, const std::string& name, const Matrix4& value, bool transpose)
+{
+    uniform_matrix4fv(shader.find_uniform_location(name), value, transpose);
+}
+
+void RenderCommandBuffer::vertex_attrib(GLint location, GLuint buffer, GLint size, bool normalized)
+{
+    vertex_attrib(location, buffer, size, GL_FLOAT, normalized, 0, 0);
+}
+
+void RenderCommandBuffer::vertex_attrib(GLint location, GLuint buffer, GLint size, GLenum type, bool normalized, GLsizei stride, size_t offset)
+{
+    if(location < 0) {
+        return;
+    }
+    assert(location < MaxVertexAttribs);
+
+    Command command;
+    command.type = VertexAttrib;
+    command.params.attrib.location = location;
+    command.params.attrib.buffer = buffer;
+    command.params.attrib.size = size;
+    command.params.attrib.type = type;
+    command.params.attrib.normalized = normalized ? GL_TRUE : GL_FALSE;
+    command.params.attrib.stride = stride;
+    command.params.attrib.offset = static_cast<uint32_t>(offset);
+    _commands.push_back(command);
+}
+
+static GLenum attribute_type(VertexLayout::AttributeType type)
+{
+    switch(type)
+    {
+    case VertexLayout::Float:
+        return GL_FLOAT;
+    case VertexLayout::HalfFloat:
+        return GL_HALF_FLOAT;
+    case VertexLayout::Int2_10_10_10:
+        return GL_INT_2_10_10_10_REV;
+    }
+    return GL_FLOAT;
+}
+
+void RenderCommandBuffer::vertex_layout(const Shader& shader, GLuint buffer, const VertexLayout& layout)
+{
+    for(size_t i=0; i<layout.attribute_count(); ++i) {
+        const VertexLayout::Attribute& attribute(layout.attribute(i));
+        vertex_attrib(shader.find_attrib_location(attribute.name), buffer, static_cast<GLint>(attribute.size),
+            attribute_type(attribute.type), attribute.normalized, static_cast<GLsizei>(layout.stride()), attribute.offset);
+    }
+}
+
+void RenderCommandBuffer::draw_arrays(GLenum mode, GLint first, GLsizei count)
+{
+    Command command;
+    command.type = DrawArrays;
+    command.params.draw.mode = mode;
+    command.params.draw.first = first;
+    command.params.draw.count = count;
+    _commands.push_back(command);
+
+    _draw_count++;
+}
+
+void RenderCommandBuffer::draw_elements(GLenum mode, GLsizei count, GLenum type, GLuint buffer, size_t offset)
+{
+    Command command;
+    command.type = DrawElements;
+    command.params.elements.mode = mode;
+    command.params.elements.count = count;
+    command.params.elements.type = type;
+    command.params.elements.buffer = buffer;
+    command.params.elements.offset = static_cast<uint32_t>(offset);
+    _commands.push_back(command);
+
+    _draw_count++;
+}
+
+void RenderCommandBuffer::replay() const
+{
+    // shadow the state we change so that redundant binds can be skipped
+    GLuint program = 0;
+    GLuint active_unit = 0;
+    GLuint textures[MaxTextureUnits];
+    std::memset(textures, 0, sizeof(textures));
+    bool textures_valid[MaxTextureUnits];
+    std::memset(textures_valid, 0, sizeof(textures_valid));
+    uint32_t enabled_attribs = 0;
+    GLuint array_buffer = 0, element_buffer = 0;
+
+    glActiveTexture(GL_TEXTURE0);
+
+    const float* const data = _data.empty() ? NULL : &_data[0];
+    BOOST_FOREACH(const Command& command, _commands) {
+        switch(command.type)
+        {
+        case BindProgram:
+            if(command.params.program.program != program) {
+                // attribute locations belong to the program
+                for(GLuint i=0; enabled_attribs; ++i, enabled_attribs >>= 1) {
+                    if(enabled_attribs & 1) {
+                        glDisableVertexAttribArray(i);
+                    }
+                }
+
+                program = command.params.program.program;
+                glUseProgram(program);
+            }
+            break;
+        case BindTexture:
+            {
+                const GLuint unit = command.params.texture.unit;
+                if(!textures_valid[unit] || textures[unit] != command.params.texture.texture) {
+                    if(unit != active_unit) {
+                        glActiveTexture(GL_TEXTURE0 + unit);
+                        active_unit = unit;
+                    }
+                    glBindTexture(command.params.texture.target, command.params.texture.texture);
+                    textures[unit] = command.params.texture.texture;
+                    textures_valid[unit] = true;
+                }
+            }
+            break;
+        case Uniform1i:
+            glUniform1i(command.params.uniform1i.location, command.params.uniform1i.value);
+            break;
+        case Uniform1f:
+            glUniform1f(command.params.uniform1f.location, command.params.uniform1f.value);
+            break;
+        case Uniform3fv:
+            glUniform3fv(command.params.uniformfv.location, command.params.uniformfv.count, data + command.params.uniformfv.offset);
+            break;
+        case Uniform4fv:
+            glUniform4fv(command.params.uniformfv.location, command.params.uniformfv.count, data + command.params.uniformfv.offset);
+            break;
+        case UniformMatrix4fv:
+            glUniformMatrix4fv(command.params.uniformfv.location, command.params.uniformfv.count,
+                command.params.uniformfv.transpose, data + command.params.uniformfv.offset);
+            break;
+        case VertexAttrib:
+            {
+                const GLint location = command.params.attrib.location;
+                if(!(enabled_attribs & (1 << location))) {
+                    glEnableVertexAttribArray(location);
+                    enabled_attribs |= (1 << location);
+                }
+                if(command.params.attrib.buffer != array_buffer) {
+                    array_buffer = command.params.attrib.buffer;
+                    glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+                }
+                glVertexAttribPointer(location, command.params.attrib.size, command.params.attrib.type, command.params.attrib.normalized,
+                    command.params.attrib.stride, reinterpret_cast<const GLvoid*>(static_cast<size_t>(command.params.attrib.offset)));
+            }
+            break;
+        case DrawArrays:
+            glDrawArrays(command.params.draw.mode, command.params.draw.first, command.params.draw.count);
+            break;
+        case DrawElements:
+            if(command.params.elements.buffer != element_buffer) {
+                element_buffer = command.params.elements.buffer;
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+            }
+            glDrawElements(command.params.elements.mode, command.params.elements.count, command.params.elements.type,
+                reinterpret_cast<const GLvoid*>(static_cast<size_t>(command.params.elements.offset)));
+            break;
+        }
+    }
+
+    // leave things the way the immediate mode code expects them
+    for(GLuint i=0; enabled_attribs; ++i, enabled_attribs >>= 1) {
+        if(enabled_attribs & 1) {
+            glDisableVertexAttribArray(i);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if(element_buffer != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    if(active_unit != 0) {
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // NOTE: the last program is left bound, callers end() their shader as usual
+}
+
+uint32_t RenderCommandBuffer::push_data(const float* data, size_t count)
+{
+    const uint32_t offset = static_cast<uint32_t>(_data.size());
+    _data.insert(_data.end(), data, data + count);
+    return offset;
+}
+
+}
@@ -0,0 +1,184 @@
+#if !defined __RENDERCOMMANDBUFFER_H__
+#define __RENDERCOMMANDBUFFER_H__
+
+#include "src/core/math/Vector.h"
+
+namespace energonsoftware {
+
+class Matrix4;
+class Shader;
+class VertexLayout;
+
+/*
+A recorded list of draw state changes and draw calls
+
+Recording only touches plain memory (no GL calls),
+so any thread can record a buffer, and several threads can record
+their own buffers in parallel to be replayed in order afterwards.
+Replaying is a single switch over POD commands on the render thread
+that also skips redundant program, texture and buffer binds.
+
+Uniform and attribute locations are recorded rather than names,
+see Shader::find_uniform_location() and Shader::find_attrib_location().
+
+NOTE: the GL objects a buffer refers to must outlive its replay
+*/
+class RenderCommandBuffer
+{
+public:
+    enum CommandType
+    {
+        BindProgram,
+        BindTexture,
+        Uniform1i,
+        Uniform1f,
+        Uniform3fv,
+        Uniform4fv,
+        UniformMatrix4fv,
+        VertexAttrib,
+        DrawArrays,
+        DrawElements,
+    };
+
+    enum
+    {
+        MaxTextureUnits = 8,
+        MaxVertexAttribs = 16
+    };
+
+    struct Command
+    {
+        CommandType type;
+
+        union
+        {
+            struct
+            {
+                GLuint program;
+            } program;
+
+            struct
+            {
+                GLuint unit;
+                GLenum target;
+                GLuint texture;
+            } texture;
+
+            struct
+            {
+                GLint location;
+                GLint value;
+            } uniform1i;
+
+            struct
+            {
+                GLint location;
+                GLfloat value;
+            } uniform1f;
+
+            // vector and matrix values live in the buffer's data
+            struct
+            {
+                GLint location;
+                GLsizei count;
+                uint32_t offset;
+                GLboolean transpose;
+            } uniformfv;
+
+            struct
+            {
+                GLint location;
+                GLuint buffer;
+                GLint size;
+                GLenum type;
+                GLboolean normalized;
+                GLsizei stride;
+
+                // in bytes
+                uint32_t offset;
+            } attrib;
+
+            struct
+            {
+                GLenum mode;
+                GLint first;
+                GLsizei count;
+            } draw;
+
+            struct
+            {
+                GLenum mode;
+                GLsizei count;
+                GLenum type;
+                GLuint buffer;
+
+                // in bytes
+                uint32_t offset;
+            } elements;
+        } params;
+    };
+
+public:
+    RenderCommandBuffer();
+    virtual ~RenderCommandBuffer() throw();
+
+public:
+    size_t size() const { return _commands.size(); }
+    bool empty() const { return _commands.empty(); }
+    size_t draw_count() const { return _draw_count; }
+
+    // NOTE: this keeps the storage around for the next frame
+    void clear();
+    void reserve(size_t commands, size_t floats);
+
+    // copies another buffer's commands onto the end of this one
+    void append(const RenderCommandBuffer& buffer);
+
+    void bind_program(const Shader& shader);
+    void bind_texture(GLuint unit, GLuint texture, GLenum target=GL_TEXTURE_2D);
+
+    // NOTE: uniforms that the shader doesn't have (location -1) aren't recorded
+    void uniform1i(GLint location, GLint value);
+    void uniform1f(GLint location, GLfloat value);
+    void uniform3f(GLint location, const Vector3& value);
+    void uniform4f(GLint location, const Vector4& value);
+    void uniform_matrix4fv(GLint location, const Matrix4& value, bool transpose=true);
+
+    // convenience versions that look up the location
+    void uniform1i(const Shader& shader, const std::string& name, GLint value);
+    void uniform1f(const Shader& shader, const std::string& name, GLfloat value);
+    void uniform3f(const Shader& shader, const std::string& name, const Vector3& value);
+    void uniform4f(const Shader& shader, const std::string& name, const Vector4& value);
+    void uniform_matrix4fv(const Shader& shader, const std::string& name, const Matrix4& value, bool transpose=true);
+
+    // binds a tightly packed float array to an attribute
+    void vertex_attrib(GLint location, GLuint buffer, GLint size, bool normalized=false);
+    void vertex_attrib(GLint location, GLuint buffer, GLint size, GLenum type, bool normalized, GLsizei stride, size_t offset);
+
+    // binds every attribute of an interleaved buffer
+    // NOTE: attributes the shader doesn't use are skipped
+    void vertex_layout(const Shader& shader, GLuint buffer, const VertexLayout& layout);
+
+    void draw_arrays(GLenum mode, GLint first, GLsizei count);
+
+    // draws count indices from an element array buffer, starting offset bytes in
+    void draw_elements(GLenum mode, GLsizei count, GLenum type, GLuint buffer, size_t offset);
+
+    // NOTE: render thread only
+    void replay() const;
+
+private:
+    uint32_t push_data(const float* data, size_t count);
+
+private:
+    std::vector<Command> _commands;
+    std::vector<float> _data;
+    size_t _draw_count;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(RenderCommandBuffer);
+};
+
+}
+
+#endif
@@ -8,144 +8,246 @@
 
 namespace energonsoftware {
 
-boost::shared_ptr<RenderCommand> RenderCommand::new_render_command(RenderCommandType type)
+RenderCommand RenderCommand::polygon_mode(GLenum face, GLenum mode)
 {
-    // commands go on the frame allocator
-    MemoryAllocator& allocator(Engine::instance().frame_allocator());
-    switch(type)
-    {
-    case RC_POLYGON_MODE:
-        return boost::shared_ptr<RenderCommand>(new(allocator) PolygonModeRenderCommand(),
-            boost::bind(&PolygonModeRenderCommand::destroy, _1, &allocator));
-    case RC_GEN_BUFFERS:
-        return boost::shared_ptr<RenderCommand>(new(allocator) GenBuffersRenderCommand(),
-            boost::bind(&GenBuffersRenderCommand::destroy, _1, &allocator));
-    case RC_DELETE_BUFFERS:
-        return boost::shared_ptr<RenderCommand>(new(allocator) DeleteBuffersRenderCommand(),
-            boost::bind(&DeleteBuffersRenderCommand::destroy, _1, &allocator));
-    case RC_GEN_TEXTURES:
-        return boost::shared_ptr<RenderCommand>(new(allocator) GenTexturesRenderCommand(),
-            boost::bind(&GenTexturesRenderCommand::destroy, _1, &allocator));
-    case RC_DELETE_TEXTURES:
-        return boost::shared_ptr<RenderCommand>(new(allocator) DeleteTexturesRenderCommand(),
-            boost::bind(&DeleteTexturesRenderCommand::destroy, _1, &allocator));
-    case RC_GEN_TEXTURE:
-        return boost::shared_ptr<RenderCommand>(new(allocator) GenTextureRenderCommand(),
-            boost::bind(&GenTextureRenderCommand::destroy, _1, &allocator));
-    case RC_DELETE_TEXTURE:
-        return boost::shared_ptr<RenderCommand>(new(allocator) DeleteTextureRenderCommand(),
-            boost::bind(&DeleteTextureRenderCommand::destroy, _1, &allocator));
-    }
-    return boost::shared_ptr<RenderCommand>();
+    RenderCommand command(RC_POLYGON_MODE);
+    command._params.polygon_mode.face = face;
+    command._params.polygon_mode.mode = mode;
+    return command;
 }
 
-void PolygonModeRenderCommand::destroy(PolygonModeRenderCommand* const command, MemoryAllocator* const allocator)
+RenderCommand RenderCommand::gen_buffers(GLsizei n, const NamesCallback& callback)
 {
-    command->~PolygonModeRenderCommand();
-    operator delete(command, *allocator);
+    RenderCommand command(RC_GEN_BUFFERS);
+    command._params.names.n = n;
+    command._params.names.names = NULL;
+    command._names_callback = callback;
+    return command;
 }
 
-void PolygonModeRenderCommand::handle()
+RenderCommand RenderCommand::delete_buffers(GLsizei n, const GLuint* buffers)
 {
-    glPolygonMode(face, mode);
+    RenderCommand command(RC_DELETE_BUFFERS);
+    command._params.names.n = n;
+    command._params.names.names = buffers;
+    return command;
 }
 
-void GenBuffersRenderCommand::destroy(GenBuffersRenderCommand* const command, MemoryAllocator* const allocator)
+RenderCommand RenderCommand::gen_textures(GLsizei n, const NamesCallback& callback)
 {
-    command->~GenBuffersRenderCommand();
-    operator delete(command, *allocator);
+    RenderCommand command(RC_GEN_TEXTURES);
+    command._params.names.n = n;
+    command._params.names.names = NULL;
+    command._names_callback = callback;
+    return command;
 }
 
-void GenBuffersRenderCommand::handle()
+RenderCommand RenderCommand::delete_textures(GLsizei n, const GLuint* textures)
 {
-    MemoryAllocator& allocator(Engine::instance().frame_allocator());
-    boost::shared_array<GLuint> buffers(new(allocator) GLuint[n], boost::bind(&MemoryAllocator::release, &allocator, _1));
-    glGenBuffers(n, buffers.get());
-    callback(buffers);
+    RenderCommand command(RC_DELETE_TEXTURES);
+    command._params.names.n = n;
+    command._params.names.names = textures;
+    return command;
 }
 
-void DeleteBuffersRenderCommand::destroy(DeleteBuffersRenderCommand* const command, MemoryAllocator* const allocator)
+RenderCommand RenderCommand::gen_texture(const NameCallback& callback)
 {
-    command->~DeleteBuffersRenderCommand();
-    operator delete(command, *allocator);
+    RenderCommand command(RC_GEN_TEXTURE);
+    command._params.name = 0;
+    command._name_callback = callback;
+    return command;
 }
 
-void DeleteBuffersRenderCommand::handle()
+RenderCommand RenderCommand::delete_texture(GLuint texture)
 {
-    glDeleteBuffers(n, buffers);
+    RenderCommand command(RC_DELETE_TEXTURE);
+    command._params.name = texture;
+    return command;
 }
 
-void GenTexturesRenderCommand::destroy(GenTexturesRenderCommand* const command, MemoryAllocator* const allocator)
+void RenderCommand::reset()
 {
-    command->~GenTexturesRenderCommand();
-    operator delete(command, *allocator);
+    _type = RC_NONE;
+    _names_callback.clear();
+    _name_callback.clear();
 }
 
-void GenTexturesRenderCommand::handle()
+void RenderCommand::handle()
 {
-    MemoryAllocator& allocator(Engine::instance().frame_allocator());
-    boost::shared_array<GLuint> textures(new(allocator) GLuint[n], boost::bind(&MemoryAllocator::release, &allocator, _1));
-    glGenTextures(n, textures.get());
-    callback(textures);
+    switch(_type)
+    {
+    case RC_NONE:
+        break;
+    case RC_POLYGON_MODE:
+        glPolygonMode(_params.polygon_mode.face, _params.polygon_mode.mode);
+        break;
+    case RC_GEN_BUFFERS:
+        {
+            MemoryAllocator& allocator(Engine::instance().frame_allocator());
+            boost::shared_array<GLuint> buffers(new(allocator) GLuint[_params.names.n], boost::bind(&MemoryAllocator::release, &allocator, _1));
+            glGenBuffers(_params.names.n, buffers.get());
+            _names_callback(buffers);
+        }
+        break;
+    case RC_DELETE_BUFFERS:
+        glDeleteBuffers(_params.names.n, _params.names.names);
+        break;
+    case RC_GEN_TEXTURES:
+        {
+            MemoryAllocator& allocator(Engine::instance().frame_allocator());
+            boost::shared_array<GLuint> textures(new(allocator) GLuint[_params.names.n], boost::bind(&MemoryAllocator::release, &allocator, _1));
+            glGenTextures(_params.names.n, textures.get());
+            _names_callback(textures);
+        }
+        break;
+    case RC_DELETE_TEXTURES:
+        glDeleteTextures(_params.names.n, _params.names.names);
+        break;
+    case RC_GEN_TEXTURE:
+        {
+            GLuint texture = 0;
+            glGenTextures(1, &texture);
+            _name_callback(texture);
+        }
+        break;
+    case RC_DELETE_TEXTURE:
+        glDeleteTextures(1, &_params.name);
+        break;
+    }
 }
 
-void DeleteTexturesRenderCommand::destroy(DeleteTexturesRenderCommand* const command, MemoryAllocator* const allocator)
-{
-    command->~DeleteTexturesRenderCommand();
-    operator delete(command, *allocator);
-}
+Logger& RenderCommandQueue::logger(Logger::instance("energonsoftware.engine.renderer.RenderCommandQueue"));
 
-void DeleteTexturesRenderCommand::handle()
+RenderCommandQueue::RenderCommandQueue(size_t capacity)
+    : _capacity(capacity), _mask(capacity - 1), _slots(new Slot[capacity]),
+        _tail(0), _head(0), _consumer(boost::this_thread::get_id()),
+        _high_water_mark(0), _full_count(0),
+        _last_drain_count(0), _max_drain_count(0), _total_drain_count(0), _drain_calls(0)
 {
-    glDeleteTextures(n, textures);
+    assert(capacity > 1 && 0 == (capacity & _mask));
+
+    // slot i is free for the producer that claims position i
+    for(size_t i=0; i<_capacity; ++i) {
+        _slots[i].sequence.store(i, boost::memory_order_relaxed);
+    }
 }
 
-void GenTextureRenderCommand::destroy(GenTextureRenderCommand* const command, MemoryAllocator* const allocator)
+RenderCommandQueue::~RenderCommandQueue() throw()
 {
-    command->~GenTextureRenderCommand();
-    operator delete(command, *allocator);
+    const size_t count = size();
+    if(count > 0) {
+        LOG_WARNING("Dropping " << count << " unhandled render commands\n");
+    }
 }
 
-void GenTextureRenderCommand::handle()
+size_t RenderCommandQueue::size() const
 {
-    GLuint texture = 0;
-    glGenTextures(1, &texture);
-    callback(texture);
+    const size_t head = _head.load(boost::memory_order_acquire);
+    const size_t tail = _tail.load(boost::memory_order_acquire);
+    return tail > head ? tail - head : 0;
 }
 
-void DeleteTextureRenderCommand::destroy(DeleteTextureRenderCommand* const command, MemoryAllocator* const allocator)
+bool RenderCommandQueue::try_push(const RenderCommand& command)
 {
-    command->~DeleteTextureRenderCommand();
-    operator delete(command, *allocator);
+    size_t position = _tail.load(boost::memory_order_relaxed);
+    while(true) {
+        Slot& slot(_slots[position & _mask]);
+        const size_t sequence = slot.sequence.load(boost::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if(0 == diff) {
+            // the slot is free, try and claim it
+            if(_tail.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed)) {
+                slot.command = command;
+
+                // publish it to the consumer
+                slot.sequence.store(position + 1, boost::memory_order_release);
+
+                const size_t head = _head.load(boost::memory_order_relaxed);
+                update_high_water_mark(position + 1 > head ? position + 1 - head : 0);
+                return true;
+            }
+        } else if(diff < 0) {
+            // the consumer hasn't gotten to this slot yet
+            return false;
+        } else {
+            // another producer claimed it first
+            position = _tail.load(boost::memory_order_relaxed);
+        }
+    }
 }
 
-void DeleteTextureRenderCommand::handle()
+void RenderCommandQueue::push(const RenderCommand& command)
 {
-    glDeleteTextures(1, &texture);
-}
+    if(try_push(command)) {
+        return;
+    }
 
-Logger& RenderCommandQueue::logger(Logger::instance("energonsoftware.engine.renderer.RenderCommandQueue"));
+    _full_count.fetch_add(1, boost::memory_order_relaxed);
+    if(boost::this_thread::get_id() == _consumer) {
+        // nobody else is going to make room
+        while(!try_push(command)) {
+            drain();
+        }
+        return;
+    }
 
-RenderCommandQueue::RenderCommandQueue()
-{
+    LOG_DEBUG("Render command queue is full, waiting on the render thread...\n");
+    while(!try_push(command)) {
+        boost::this_thread::yield();
+    }
 }
 
-RenderCommandQueue::~RenderCommandQueue() throw()
+void RenderCommandQueue::bind_consumer()
 {
+    _consumer = boost::this_thread::get_id();
 }
 
-void RenderCommandQueue::push(boost::shared_ptr<RenderCommand> command)
+size_t RenderCommandQueue::drain()
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-    _queue.push_back(command);
+    assert(boost::this_thread::get_id() == _consumer);
+
+    // only run what was published before we started
+    // so that commands pushed while draining wait for the next frame
+    const size_t end = _tail.load(boost::memory_order_acquire);
+
+    size_t count = 0;
+    while(true) {
+        // NOTE: re-read every time in case a command pushed into a full ring and drained it
+        const size_t position = _head.load(boost::memory_order_relaxed);
+        if(position >= end) {
+            break;
+        }
+
+        Slot& slot(_slots[position & _mask]);
+        if(slot.sequence.load(boost::memory_order_acquire) != position + 1) {
+            // claimed but not yet published
+            break;
+        }
+
+        // copy the command out and hand the slot back to the producers
+        // for the next lap before running it, so that it's safe to push from a command
+        RenderCommand command(slot.command);
+        slot.command.reset();
+        _head.store(position + 1, boost::memory_order_release);
+        slot.sequence.store(position + _capacity, boost::memory_order_release);
+
+        command.handle();
+        ++count;
+    }
+
+    _last_drain_count = count;
+    _max_drain_count = std::max(_max_drain_count, count);
+    _total_drain_count += count;
+    _drain_calls++;
+
+    return count;
 }
 
-boost::shared_ptr<RenderCommand> RenderCommandQueue::pop()
+void RenderCommandQueue::update_high_water_mark(size_t depth)
 {
-    boost::lock_guard<boost::recursive_mutex> guard(_mutex);
-    boost::shared_ptr<RenderCommand> ret(_queue.front());
-    _queue.pop_front();
-    return ret;
+    size_t mark = _high_water_mark.load(boost::memory_order_relaxed);
+    while(depth > mark && !_high_water_mark.compare_exchange_weak(mark, depth, boost::memory_order_relaxed)) {
+    }
 }
 
 }
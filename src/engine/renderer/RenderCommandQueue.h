@@ -3,11 +3,20 @@
 
 namespace energonsoftware {
 
+/*
+A single command for the render thread
+
+Commands are small values that are copied straight into the
+RenderCommandQueue ring, so pushing one doesn't allocate anything
+(beyond whatever the callback functor itself needs).
+Use the static builders to create them.
+*/
 class RenderCommand
 {
 public:
     enum RenderCommandType
     {
+        RC_NONE,
         RC_POLYGON_MODE,
         RC_GEN_BUFFERS,
         RC_DELETE_BUFFERS,
@@ -17,167 +26,146 @@ public:
         RC_DELETE_TEXTURE,
     };
 
-    static boost::shared_ptr<RenderCommand> new_render_command(RenderCommandType type);
+    typedef boost::function<void(boost::shared_array<GLuint>)> NamesCallback;
+    typedef boost::function<void(GLuint)> NameCallback;
 
 public:
-    virtual ~RenderCommand() throw() {}
+    static RenderCommand polygon_mode(GLenum face, GLenum mode);
+    static RenderCommand gen_buffers(GLsizei n, const NamesCallback& callback);
+    static RenderCommand delete_buffers(GLsizei n, const GLuint* buffers);
+    static RenderCommand gen_textures(GLsizei n, const NamesCallback& callback);
+    static RenderCommand delete_textures(GLsizei n, const GLuint* textures);
+    static RenderCommand gen_texture(const NameCallback& callback);
+    static RenderCommand delete_texture(GLuint texture);
 
 public:
-    RenderCommandType type() const { return _type; }
-
-protected:
-    friend class Renderer;
-    friend class RenderCommandQueue;
-    virtual void handle() = 0;
-
-private:
-    RenderCommandType _type;
-
-protected:
-    explicit RenderCommand(RenderCommandType type) : _type(type) {}
+    RenderCommand() : _type(RC_NONE) {}
 
-private:
-    RenderCommand();
-};
-
-class PolygonModeRenderCommand : public RenderCommand
-{
 public:
-    static void destroy(PolygonModeRenderCommand* const command, MemoryAllocator* const allocator);
+    RenderCommandType type() const { return _type; }
 
-public:
-    PolygonModeRenderCommand() : RenderCommand(RC_POLYGON_MODE), face(GL_FRONT_AND_BACK), mode(GL_FILL) {}
-    virtual ~PolygonModeRenderCommand() throw() {}
+    // drops the callbacks so a slot doesn't keep their bound arguments alive
+    void reset();
 
 private:
-    virtual void handle();
-
-public:
-    GLenum face, mode;
-};
-
-class GenBuffersRenderCommand : public RenderCommand
-{
-public:
-    static void destroy(GenBuffersRenderCommand* const command, MemoryAllocator* const allocator);
-
-public:
-    GenBuffersRenderCommand() : RenderCommand(RC_GEN_BUFFERS), n(0) {}
-    virtual ~GenBuffersRenderCommand() throw() {}
+    friend class RenderCommandQueue;
+    void handle();
 
 private:
-    virtual void handle();
-
-public:
-    GLsizei n;
-    boost::function<void(boost::shared_array<GLuint>)> callback;
-};
-
-class DeleteBuffersRenderCommand : public RenderCommand
-{
-public:
-    static void destroy(DeleteBuffersRenderCommand* const command, MemoryAllocator* const allocator);
-
-public:
-    DeleteBuffersRenderCommand() : RenderCommand(RC_DELETE_BUFFERS), n(0), buffers(NULL) {}
-    virtual ~DeleteBuffersRenderCommand() throw() {}
+    explicit RenderCommand(RenderCommandType type) : _type(type) {}
 
 private:
-    virtual void handle();
+    RenderCommandType _type;
 
-public:
-    GLsizei n;
-    const GLuint* buffers;
+    // NOTE: the parameters for each type share storage
+    union
+    {
+        struct
+        {
+            GLenum face, mode;
+        } polygon_mode;
+
+        struct
+        {
+            GLsizei n;
+            const GLuint* names;
+        } names;
+
+        GLuint name;
+    } _params;
+
+    NamesCallback _names_callback;
+    NameCallback _name_callback;
 };
 
-class GenTexturesRenderCommand : public RenderCommand
-{
-public:
-    static void destroy(GenTexturesRenderCommand* const command, MemoryAllocator* const allocator);
+/*
+Bounded lock-free multi-producer / single-consumer command ring
+based on Dmitry Vyukov's bounded MPMC queue
 
-public:
-    GenTexturesRenderCommand() : RenderCommand(RC_GEN_TEXTURES), n(0) {}
-    virtual ~GenTexturesRenderCommand() throw() {}
-
-private:
-    virtual void handle();
+Any thread may push(), only the render thread may drain().
+Each slot carries a sequence number that tells producers when it's free
+and the consumer when it's been published, so producers only contend
+on a single fetch-and-add style compare-and-swap of the tail.
 
-public:
-    GLsizei n;
-    boost::function<void(boost::shared_array<GLuint>)> callback;
-};
-
-class DeleteTexturesRenderCommand : public RenderCommand
+The render thread drains everything that's been published once per frame.
+If the ring is full a producer waits for the render thread to make room,
+unless the producer *is* the render thread in which case it drains in place.
+*/
+class RenderCommandQueue
 {
 public:
-    static void destroy(DeleteTexturesRenderCommand* const command, MemoryAllocator* const allocator);
+    enum
+    {
+        DefaultCapacity = 4096,
+        CacheLineSize = 64
+    };
 
-public:
-    DeleteTexturesRenderCommand() : RenderCommand(RC_DELETE_TEXTURES), n(0), textures(NULL) {}
-    virtual ~DeleteTexturesRenderCommand() throw() {}
+private:
+    static Logger& logger;
 
 private:
-    virtual void handle();
+    struct Slot
+    {
+        boost::atomic<size_t> sequence;
+        RenderCommand command;
+    };
 
 public:
-    GLsizei n;
-    const GLuint* textures;
-};
+    virtual ~RenderCommandQueue() throw();
 
-class GenTextureRenderCommand : public RenderCommand
-{
 public:
-    static void destroy(GenTextureRenderCommand* const command, MemoryAllocator* const allocator);
+    size_t capacity() const { return _capacity; }
 
-public:
-    GenTextureRenderCommand() : RenderCommand(RC_GEN_TEXTURE) {}
-    virtual ~GenTextureRenderCommand() throw() {}
+    // NOTE: these are only a snapshot while other threads are pushing
+    size_t size() const;
+    bool empty() const { return 0 == size(); }
 
-private:
-    virtual void handle();
+    void push(const RenderCommand& command);
 
-public:
-    boost::function<void(GLuint)> callback;
-};
+    // runs every published command, returns the number run
+    // NOTE: render thread only
+    size_t drain();
 
-class DeleteTextureRenderCommand : public RenderCommand
-{
-public:
-    static void destroy(DeleteTextureRenderCommand* const command, MemoryAllocator* const allocator);
+    // makes the calling thread the one that drains the queue
+    // NOTE: this must happen before any other thread pushes
+    void bind_consumer();
 
 public:
-    DeleteTextureRenderCommand() : RenderCommand(RC_DELETE_TEXTURE), texture(0) {}
-    virtual ~DeleteTextureRenderCommand() throw() {}
+    // stats
+    size_t high_water_mark() const { return _high_water_mark.load(boost::memory_order_relaxed); }
+    size_t full_count() const { return _full_count.load(boost::memory_order_relaxed); }
+    size_t last_drain_count() const { return _last_drain_count; }
+    size_t max_drain_count() const { return _max_drain_count; }
+    size_t total_drain_count() const { return _total_drain_count; }
+    size_t drain_calls() const { return _drain_calls; }
 
 private:
-    virtual void handle();
+    bool try_push(const RenderCommand& command);
+    void update_high_water_mark(size_t depth);
 
-public:
-    GLuint texture;
-};
-
-class RenderCommandQueue
-{
 private:
-    static Logger& logger;
+    const size_t _capacity, _mask;
+    boost::scoped_array<Slot> _slots;
 
-public:
-    virtual ~RenderCommandQueue() throw();
+    // the producers' end and the consumer's end are kept on separate cache lines
+    char _pad0[CacheLineSize];
+    boost::atomic<size_t> _tail;
+    char _pad1[CacheLineSize - sizeof(boost::atomic<size_t>)];
+    boost::atomic<size_t> _head;
+    char _pad2[CacheLineSize - sizeof(boost::atomic<size_t>)];
 
-public:
-    size_t size() const { return _queue.size(); }
-    bool empty() const { return _queue.empty(); }
+    // NOTE: only written by bind_consumer(), producers read it without locking
+    boost::thread::id _consumer;
 
-    void push(boost::shared_ptr<RenderCommand> command);
-    boost::shared_ptr<RenderCommand> pop();
+    boost::atomic<size_t> _high_water_mark;
+    boost::atomic<size_t> _full_count;
 
-private:
-    boost::recursive_mutex _mutex;
-    std::list<boost::shared_ptr<RenderCommand> > _queue;
+    // only touched by the consumer
+    size_t _last_drain_count, _max_drain_count, _total_drain_count, _drain_calls;
 
 private:
     friend class Renderer;
-    RenderCommandQueue();
+    explicit RenderCommandQueue(size_t capacity=DefaultCapacity);
     DISALLOW_COPY_AND_ASSIGN(RenderCommandQueue);
 };
 
@@ -5,6 +5,8 @@
 #include "src/engine/EngineConfiguration.h"
 #include "src/engine/ResourceManager.h"
 #include "src/engine/State.h"
+#include "src/engine/scene/Scene.h"
+#include "src/engine/scene/SceneSnapshot.h"
 #include "Camera.h"
 #include "Light.h"
 #include "Mesh.h"
@@ -34,40 +36,25 @@ Renderable::TextureBuffers::~TextureBuffers() throw()
 }
 
 Renderable::Renderable(const std::string& name)
-    : Physical(), _name(name)
+    : Physical(), _name(name), _snapshot_index(static_cast<size_t>(-1))
 {
-    boost::shared_ptr<GenBuffersRenderCommand> command(
-        boost::dynamic_pointer_cast<GenBuffersRenderCommand, RenderCommand>(
-            RenderCommand::new_render_command(RenderCommand::RC_GEN_BUFFERS)));
-    command->n = RenderBuffers::GeometryVBOCount;
-    command->callback = boost::bind(&RenderBuffers::geometry_buffers_callback, &_buffers, _1);
-    Engine::instance().renderer().command_queue().push(command);
-
-    command = boost::dynamic_pointer_cast<GenBuffersRenderCommand, RenderCommand>(
-        RenderCommand::new_render_command(RenderCommand::RC_GEN_BUFFERS));
-    command->n = RenderBuffers::ShadowVBOCount;
-    command->callback = boost::bind(&RenderBuffers::shadow_buffers_callback, &_buffers, _1);
-    Engine::instance().renderer().command_queue().push(command);
+    RenderCommandQueue& queue(Engine::instance().renderer().command_queue());
+    queue.push(RenderCommand::gen_buffers(RenderBuffers::GeometryVBOCount,
+        boost::bind(&RenderBuffers::geometry_buffers_callback, &_buffers, _1)));
+    queue.push(RenderCommand::gen_buffers(RenderBuffers::ShadowVBOCount,
+        boost::bind(&RenderBuffers::shadow_buffers_callback, &_buffers, _1)));
 }
 
 Renderable::~Renderable() throw()
 {
     if(_buffers.shadow_buffers()) {
-        boost::shared_ptr<DeleteBuffersRenderCommand> command(
-            boost::dynamic_pointer_cast<DeleteBuffersRenderCommand, RenderCommand>(
-                RenderCommand::new_render_command(RenderCommand::RC_DELETE_BUFFERS)));
-        command->n = RenderBuffers::ShadowVBOCount;
-        command->buffers = _buffers.shadow_buffers();
-        Engine::instance().renderer().command_queue().push(command);
+        Engine::instance().renderer().command_queue().push(
+            RenderCommand::delete_buffers(RenderBuffers::ShadowVBOCount, _buffers.shadow_buffers()));
     }
 
     if(_buffers.geometry_buffers()) {
-        boost::shared_ptr<DeleteBuffersRenderCommand> command(
-            boost::dynamic_pointer_cast<DeleteBuffersRenderCommand, RenderCommand>(
-                RenderCommand::new_render_command(RenderCommand::RC_DELETE_BUFFERS)));
-        command->n = RenderBuffers::GeometryVBOCount;
-        command->buffers = _buffers.geometry_buffers();
-        Engine::instance().renderer().command_queue().push(command);
+        Engine::instance().renderer().command_queue().push(
+            RenderCommand::delete_buffers(RenderBuffers::GeometryVBOCount, _buffers.geometry_buffers()));
     }
 }
 
@@ -77,15 +64,57 @@ void Renderable::model(boost::shared_ptr<Model> model)
 
     // geometry goes on the scene allocator
     MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
-    _geometry.reset(new(allocator) Geometry(_model->triangle_count() * 3, allocator),
+    _geometry.reset(new(allocator) Geometry(_model->triangle_count(), _model->vertex_count(), allocator),
         boost::bind(&Geometry::destroy, _1, &allocator));
 
     _vertices.reset(Vertex::create_array(model->vertex_count(), allocator),
         boost::bind(&Vertex::destroy_array, _1, model->vertex_count(), &allocator));
 
+    // the triangles never change, so the index array is only set up once
+    _model->calculate_indices(*_geometry);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers.index_array());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, _geometry->index_buffer_size(), _geometry->index_buffer().get(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
     calculate_vertices(_model->skeleton());
 }
 
+void Renderable::snapshot(Snapshot& snapshot) const
+{
+    snapshot.renderable = this;
+    Physical::snapshot(snapshot.physical);
+    snapshot.pose.animated = false;
+}
+
+const Renderable::Snapshot* Renderable::render_state() const
+{
+    const SceneSnapshot& snapshot(Engine::instance().state().scene().snapshot());
+    if(_snapshot_index >= snapshot.renderables.size()) {
+        return NULL;
+    }
+
+    // the slot may still belong to a renderable from a previous scene
+    const Snapshot& state(snapshot.renderables[_snapshot_index]);
+    return state.renderable == this ? &state : NULL;
+}
+
+AABB Renderable::render_bounds() const
+{
+    const Snapshot* const state = render_state();
+    return NULL != state ? state->physical.absolute_bounds() : AABB();
+}
+
+bool Renderable::render_transform(Matrix4& matrix) const
+{
+    const Snapshot* const state = render_state();
+    if(NULL == state) {
+        return false;
+    }
+
+    state->physical.transform(matrix, Engine::instance().interpolation());
+    return true;
+}
+
 void Renderable::init_textures()
 {
     if(_model) {
@@ -96,7 +125,9 @@ void Renderable::init_textures()
 size_t Renderable::compute_silhouette(const Light& light)
 {
     Matrix4 matrix;
-    transform(matrix);
+    if(!render_transform(matrix)) {
+        return 0;
+    }
 
     // allocate enough space for every edge, on the frame allocator
     MemoryAllocator& allocator(Engine::instance().frame_allocator());
@@ -244,24 +275,17 @@ void Renderable::render() const
         return;
     }
 
-    Matrix4 matrix;
-    transform(matrix);
-
-    boost::lock_guard<boost::recursive_mutex> guard(_geometry->mutex());
-
     Renderer& renderer(Engine::instance().renderer());
-    renderer.push_model_matrix();
-    renderer.multiply_model_matrix(matrix);
 
-    // render the meshes
-    size_t tcount = 0;
-    for(size_t i=0; i<model().mesh_count(); ++i) {
-        const Mesh& mesh(model().mesh(i));
-        render_mesh(mesh, tcount);
-        tcount += mesh.triangle_count();
+    Matrix4 matrix;
+    if(!render_transform(matrix)) {
+        return;
     }
 
-    renderer.pop_model_matrix();
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record_meshes(buffer, renderer.model_matrix() * matrix, NULL, NULL);
+    renderer.submit(buffer);
 }
 
 void Renderable::render(const Light& light, const Camera& camera) const
@@ -270,24 +294,43 @@ void Renderable::render(const Light& light, const Camera& camera) const
         return;
     }
 
+    Renderer& renderer(Engine::instance().renderer());
+
     Matrix4 matrix;
-    transform(matrix);
+    if(!render_transform(matrix)) {
+        return;
+    }
 
-    boost::lock_guard<boost::recursive_mutex> guard(_geometry->mutex());
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record_meshes(buffer, renderer.model_matrix() * matrix, &light, &camera);
+    renderer.submit(buffer);
+}
 
-    Renderer& renderer(Engine::instance().renderer());
-    renderer.push_model_matrix();
-    renderer.multiply_model_matrix(matrix);
+void Renderable::record(RenderCommandBuffer& buffer) const
+{
+    if(!ready()) {
+        return;
+    }
 
-    // render the meshes
-    size_t tcount = 0;
-    for(size_t i=0; i<model().mesh_count(); ++i) {
-        const Mesh& mesh(model().mesh(i));
-        render_mesh(mesh, tcount, light, camera);
-        tcount += mesh.triangle_count();
+    Matrix4 matrix;
+    if(!render_transform(matrix)) {
+        return;
     }
+    record_meshes(buffer, matrix, NULL, NULL);
+}
 
-    renderer.pop_model_matrix();
+void Renderable::record(RenderCommandBuffer& buffer, const Light& light, const Camera& camera) const
+{
+    if(!ready()) {
+        return;
+    }
+
+    Matrix4 matrix;
+    if(!render_transform(matrix)) {
+        return;
+    }
+    record_meshes(buffer, matrix, &light, &camera);
 }
 
 void Renderable::render_shadow(boost::shared_ptr<Shader> shader, const Light& light, const Camera& camera, size_t vcount, bool cap) const
@@ -297,9 +340,9 @@ void Renderable::render_shadow(boost::shared_ptr<Shader> shader, const Light& li
     }
 
     Matrix4 matrix;
-    transform(matrix);
-
-    boost::lock_guard<boost::recursive_mutex> guard(_geometry->mutex());
+    if(!render_transform(matrix)) {
+        return;
+    }
 
     Renderer& renderer(Engine::instance().renderer());
     renderer.push_model_matrix();
@@ -326,9 +369,9 @@ void Renderable::render_shadow(boost::shared_ptr<Shader> shader, const Light& li
 void Renderable::render_unlit(const Camera& camera)
 {
     Matrix4 matrix;
-    transform(matrix);
-
-    boost::lock_guard<boost::recursive_mutex> guard(_geometry->mutex());
+    if(!render_transform(matrix)) {
+        return;
+    }
 
     Renderer& renderer(Engine::instance().renderer());
     renderer.push_model_matrix();
@@ -379,142 +422,68 @@ void Renderable::render_shadow_positional(boost::shared_ptr<Shader> shader, cons
     glDisableVertexAttribArray(vloc);
 }
 
-void Renderable::render_mesh(const Mesh& mesh, size_t start) const
+void Renderable::record_meshes(RenderCommandBuffer& buffer, const Matrix4& matrix, const Light* const light, const Camera* const camera) const
 {
-    boost::shared_ptr<Shader> shader(mesh.shader());
-    Engine::instance().renderer().init_shader_matrices(*shader);
-
-    // setup the detail texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mesh.detail_texture());
-    shader->uniform1i("detail_texture", 0);
-
-    // setup the normal map
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, mesh.normal_map());
-    shader->uniform1i("normal_map", 1);
-
-    // setup the specular map
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, mesh.specular_map());
-    shader->uniform1i("specular_map", 2);
-
-    // setup the emission map
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, mesh.emission_map());
-    shader->uniform1i("emission_map", 3);
-
-    // get the attribute locations
-    GLint vloc = shader->attrib_location("vertex");
-    GLint nloc = shader->attrib_location("normal");
-    GLint tnloc = shader->attrib_location("tangent");
-    GLint tloc = shader->attrib_location("texture_coord");
-
-    // render the mesh
-    glEnableVertexAttribArray(vloc);
-    glEnableVertexAttribArray(nloc);
-    glEnableVertexAttribArray(tnloc);
-    glEnableVertexAttribArray(tloc);
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.texture_array());
-        glVertexAttribPointer(tloc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    const Renderer& renderer(Engine::instance().renderer());
+    const GLenum index_type = sizeof(uint16_t) == _geometry->index_size() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.normal_array());
-        glVertexAttribPointer(nloc, 3, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.tangent_array());
-        glVertexAttribPointer(tnloc, 4, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.vertex_array());
-        glVertexAttribPointer(vloc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    size_t tcount = 0;
+    for(size_t i=0; i<model().mesh_count(); ++i) {
+        const Mesh& mesh(model().mesh(i));
+        const Shader& shader(*mesh.shader());
 
-        glDrawArrays(GL_TRIANGLES, start * 3, mesh.triangle_count() * 3);
-    glDisableVertexAttribArray(tloc);
-    glDisableVertexAttribArray(tnloc);
-    glDisableVertexAttribArray(nloc);
-    glDisableVertexAttribArray(vloc);
-}
+        buffer.bind_program(shader);
+        renderer.record_shader_matrices(buffer, shader, matrix);
+        if(NULL != light) {
+            renderer.record_shader_light(buffer, shader, *mesh.material(), *light, *camera, matrix);
+        }
 
-void Renderable::render_mesh(const Mesh& mesh, size_t start, const Light& light, const Camera& camera) const
-{
-    boost::shared_ptr<Material> material(mesh.material());
-    boost::shared_ptr<Shader> shader(mesh.shader());
-    Engine::instance().renderer().init_shader_matrices(*shader);
-    Engine::instance().renderer().init_shader_light(*shader, *material, light, camera);
-
-    // setup the detail texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mesh.detail_texture());
-    shader->uniform1i("detail_texture", 0);
-
-    // setup the normal map
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, mesh.normal_map());
-    shader->uniform1i("normal_map", 1);
-
-    // setup the specular map
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, mesh.specular_map());
-    shader->uniform1i("specular_map", 2);
-
-    // setup the emission map
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, mesh.emission_map());
-    shader->uniform1i("emission_map", 3);
+        // setup the textures
+        buffer.bind_texture(0, mesh.detail_texture());
+        buffer.uniform1i(shader, "detail_texture", 0);
 
-    // get the attribute locations
-    GLint vloc = shader->attrib_location("vertex");
-    GLint nloc = shader->attrib_location("normal");
-    GLint tnloc = shader->attrib_location("tangent");
-    GLint tloc = shader->attrib_location("texture_coord");
+        buffer.bind_texture(1, mesh.normal_map());
+        buffer.uniform1i(shader, "normal_map", 1);
 
-    // render the mesh
-    glEnableVertexAttribArray(vloc);
-    glEnableVertexAttribArray(nloc);
-    glEnableVertexAttribArray(tnloc);
-    glEnableVertexAttribArray(tloc);
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.texture_array());
-        glVertexAttribPointer(tloc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        buffer.bind_texture(2, mesh.specular_map());
+        buffer.uniform1i(shader, "specular_map", 2);
 
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.normal_array());
-        glVertexAttribPointer(nloc, 3, GL_FLOAT, GL_TRUE, 0, 0);
+        buffer.bind_texture(3, mesh.emission_map());
+        buffer.uniform1i(shader, "emission_map", 3);
 
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.tangent_array());
-        glVertexAttribPointer(tnloc, 4, GL_FLOAT, GL_TRUE, 0, 0);
+        // render the mesh
+        buffer.vertex_layout(shader, _buffers.vertex_array(), Geometry::layout());
 
-        glBindBuffer(GL_ARRAY_BUFFER, _buffers.vertex_array());
-        glVertexAttribPointer(vloc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        buffer.draw_elements(GL_TRIANGLES, mesh.triangle_count() * 3, index_type, _buffers.index_array(), tcount * 3 * _geometry->index_size());
 
-        glDrawArrays(GL_TRIANGLES, start * 3, mesh.triangle_count() * 3);
-    glDisableVertexAttribArray(tloc);
-    glDisableVertexAttribArray(tnloc);
-    glDisableVertexAttribArray(nloc);
-    glDisableVertexAttribArray(vloc);
+        tcount += mesh.triangle_count();
+    }
 }
 
 void Renderable::render_normals() const
 {
     // render the mesh normals
-    size_t tcount = 0;
+    size_t vstart = 0;
     for(size_t i=0; i<model().mesh_count(); ++i) {
         const Mesh& mesh(model().mesh(i));
-        render_normals(mesh, tcount);
-        tcount += mesh.triangle_count();
+        render_normals(mesh, vstart);
+        vstart += mesh.vertex_count();
     }
 }
 
-void Renderable::render_normals(const Mesh& mesh, size_t start) const
+void Renderable::render_normals(const Mesh& mesh, size_t vstart) const
 {
-    const size_t vstart = start * 3 * 2 * 3;
+    const size_t start = vstart * 2 * 3;
 
     // setup the normal line array
     glBindBuffer(GL_ARRAY_BUFFER, _buffers.normal_line_array());
     glBufferData(GL_ARRAY_BUFFER, mesh.vertex_count() * 2 * 3 * sizeof(float),
-        _geometry->normal_line_buffer().get() + vstart, GL_DYNAMIC_DRAW);
+        _geometry->normal_line_buffer().get() + start, GL_DYNAMIC_DRAW);
 
     // setup the tangent line array
     glBindBuffer(GL_ARRAY_BUFFER, _buffers.tangent_line_array());
     glBufferData(GL_ARRAY_BUFFER, mesh.vertex_count() * 2 * 3 * sizeof(float),
-        _geometry->tangent_line_buffer().get() + vstart, GL_DYNAMIC_DRAW);
+        _geometry->tangent_line_buffer().get() + start, GL_DYNAMIC_DRAW);
 
     // render the normals
     boost::shared_ptr<Shader> rshader(Engine::instance().resource_manager().shader("red"));
@@ -559,23 +528,8 @@ void Renderable::calculate_vertices(const Skeleton& skeleton)
 
     // setup the vertex array
     glBindBuffer(GL_ARRAY_BUFFER, _buffers.vertex_array());
-    glBufferData(GL_ARRAY_BUFFER, _geometry->vertex_buffer_size() * sizeof(float),
+    glBufferData(GL_ARRAY_BUFFER, _geometry->vertex_buffer_size(),
         _geometry->vertex_buffer().get(), is_static() ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-
-    // setup the normal array
-    glBindBuffer(GL_ARRAY_BUFFER, _buffers.normal_array());
-    glBufferData(GL_ARRAY_BUFFER, _geometry->normal_buffer_size() * sizeof(float),
-        _geometry->normal_buffer().get(), is_static() ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-
-    // setup the tangent array
-    glBindBuffer(GL_ARRAY_BUFFER, _buffers.tangent_array());
-    glBufferData(GL_ARRAY_BUFFER, _geometry->tangent_buffer_size() * sizeof(float),
-        _geometry->tangent_buffer().get(), is_static() ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-
-    // setup the texture array
-    glBindBuffer(GL_ARRAY_BUFFER, _buffers.texture_array());
-    glBufferData(GL_ARRAY_BUFFER, _geometry->texture_buffer_size() * sizeof(float),
-        _geometry->texture_buffer().get(), is_static() ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
 }
 
 }
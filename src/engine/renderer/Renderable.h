@@ -12,6 +12,7 @@ class DirectionalLight;
 class PositionalLight;
 class Mesh;
 class Model;
+class RenderCommandBuffer;
 class Shader;
 class Skeleton;
 
@@ -23,10 +24,9 @@ public:
     public:
         enum GeometryVBO
         {
+            // interleaved, see Geometry::layout()
             VertexArray,
-            NormalArray,
-            TangentArray,
-            TextureArray,
+            IndexArray,
 
             // debugging buffers
             NormalLineArray,
@@ -50,9 +50,7 @@ public:
         bool has_geometry_buffers() const { return static_cast<bool>(_geometry_buffers); }
         const GLuint* geometry_buffers() const { return _geometry_buffers.get(); }
         GLuint vertex_array() const { return _geometry_buffers[VertexArray]; }
-        GLuint normal_array() const { return _geometry_buffers[NormalArray]; }
-        GLuint tangent_array() const { return _geometry_buffers[TangentArray]; }
-        GLuint texture_array() const { return _geometry_buffers[TextureArray]; }
+        GLuint index_array() const { return _geometry_buffers[IndexArray]; }
 
         // debugging buffers
         GLuint normal_line_array() const { return _geometry_buffers[NormalLineArray]; }
@@ -109,6 +107,25 @@ public:
         void emission_map(GLuint texture) { _buffers[EmissionMap] = texture; }
     };
 
+    // everything the render thread needs to draw a renderable
+    // published by the update thread with the rest of the SceneSnapshot
+    struct Snapshot
+    {
+        // identifies the renderable the snapshot was taken from
+        const Renderable* renderable;
+
+        Physical::Snapshot physical;
+
+        struct
+        {
+            bool animated;
+            size_t frame, next_frame;
+            float percent;
+        } pose;
+
+        Snapshot() : renderable(NULL) { pose.animated = false; pose.frame = pose.next_frame = 0; pose.percent = 0.0f; }
+    };
+
 public:
     virtual ~Renderable() throw();
 
@@ -125,6 +142,20 @@ public:
 
     const Vertex& vertex(size_t idx) const { return _vertices[idx]; }
 
+    // NOTE: update thread only
+    virtual void snapshot(Snapshot& snapshot) const;
+
+    // the state from the render thread's current SceneSnapshot
+    // NULL until the renderable has been published in one
+    const Snapshot* render_state() const;
+
+    // the world-space bounds from the render state
+    AABB render_bounds() const;
+
+    // builds the interpolated model matrix from the render state
+    // returns false if there's no render state yet
+    bool render_transform(Matrix4& matrix) const;
+
     // NOTE: all of the following must be called from the render thread
 
     // returns the number of vertices in the silhouette
@@ -133,6 +164,12 @@ public:
 
     void render() const;
     void render(const Light& light, const Camera& camera) const;
+
+    // these record what render() does without making any GL calls
+    // so they may be called from any thread once the camera has looked for the frame
+    // NOTE: unlike render() these ignore the renderer's model matrix
+    void record(RenderCommandBuffer& buffer) const;
+    void record(RenderCommandBuffer& buffer, const Light& light, const Camera& camera) const;
     void render_shadow(boost::shared_ptr<Shader> shader, const Light& light, const Camera& camera, size_t vcount, bool cap) const;
     void render_unlit(const Camera& camera);
 
@@ -150,21 +187,26 @@ protected:
     virtual void on_render_unlit(const Camera& camera) const {}
 
 private:
-    void render_mesh(const Mesh& mesh, size_t start) const;
-    void render_mesh(const Mesh& mesh, size_t start, const Light& light, const Camera& camera) const;
+    // light and camera are NULL for the unlit pass
+    void record_meshes(RenderCommandBuffer& buffer, const Matrix4& matrix, const Light* const light, const Camera* const camera) const;
 
     void render_shadow_directional(boost::shared_ptr<Shader> shader, const DirectionalLight& light, size_t vcount) const;
     void render_shadow_positional(boost::shared_ptr<Shader> shader, const PositionalLight& light, size_t vcount, bool cap) const;
     void render_normals() const;
-    void render_normals(const Mesh& mesh, size_t start) const;
+    void render_normals(const Mesh& mesh, size_t vstart) const;
 
     bool is_silhouette_edge(const Mesh& mesh, const Edge& edge, const Vector4& light_position, size_t vstart, bool& faces_light1) const;
     size_t compute_silhouette_directional(const Direction& light_direction, boost::shared_array<float> varray);
     size_t compute_silhouette_positional(const Position& light_position, boost::shared_array<float> varray);
 
 private:
+    friend class Scene;
+
     std::string _name;
 
+    // our slot in SceneSnapshot::renderables, assigned when registered with the scene
+    size_t _snapshot_index;
+
     boost::shared_ptr<Model> _model;
     boost::shared_ptr<Geometry> _geometry;
     boost::shared_array<Vertex> _vertices;
@@ -184,7 +226,7 @@ struct CompareRenderablesOpaque
     {
         // closer objects get rendered first
         // to take advantage of early-out depth testing
-        return lhs->absolute_bounds().distance(_camera) < rhs->absolute_bounds().distance(_camera);
+        return lhs->render_bounds().distance(_camera) < rhs->render_bounds().distance(_camera);
     }
 
 private:
@@ -202,7 +244,7 @@ struct CompareRenderablesTransparent
     bool operator()(const boost::shared_ptr<const Renderable> lhs, const boost::shared_ptr<const Renderable> rhs) const
     {
         // further objects get rendered first
-        return lhs->absolute_bounds().distance(_camera) > rhs->absolute_bounds().distance(_camera);
+        return lhs->render_bounds().distance(_camera) > rhs->render_bounds().distance(_camera);
     }
 
 private:
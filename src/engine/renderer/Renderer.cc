@@ -11,6 +11,7 @@
 #include "src/engine/State.h"
 #include "src/engine/scene/Actor.h"
 #include "src/engine/scene/Map.h"
+#include "src/engine/scene/Scene.h"
 #include "gl_defs.h"
 #include "Camera.h"
 #include "Light.h"
@@ -36,7 +37,7 @@ void Renderer::destroy(Renderer* const renderer, MemoryAllocator* const allocato
 
 Renderer::Renderer()
     : _width(0), _height(0), _bpp(0),
-        _frame_start(0.0), _frame_count(0),
+        _frame_start(0.0), _frame_count(0), _frame_draw_count(0),
         _near_plane(0.0f), _far_plane(0.0f), _aspect_ratio(0.0f), _fov(0.0f)
 {
     ZeroMemory(_fbo, BufferCount * sizeof(GLuint));
@@ -213,17 +214,16 @@ void Renderer::resize_viewport(int width, int height, int fov)
 void Renderer::start_frame()
 {
     _frame_start = get_time();
+    _frame_draw_count = 0;
 
-    // pump any commands generated by other threads
-    while(!_command_queue.empty()) {
-        boost::shared_ptr<RenderCommand> command(_command_queue.pop());
-        command->handle();
-    }
+    // pump any commands generated by other threads in one batch
+    _command_queue.drain();
 }
 
 void Renderer::render_frame()
 {
-    Scene::instance().camera().look();
+    Scene& scene(Engine::instance().state().scene());
+    scene.camera().look(scene.snapshot().camera);
 
     // clear the ambient buffer
     glBindFramebuffer(GL_FRAMEBUFFER, _fbo[AmbientBuffer]);
@@ -526,54 +526,21 @@ void Renderer::render_sphere() const
 
 void Renderer::render_geometry(const Geometry& geometry, Shader& shader) const
 {
-    GLuint vbo[4];
-    glGenBuffers(4, vbo);
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
 
     // setup the vertex array
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-    glBufferData(GL_ARRAY_BUFFER, geometry.vertex_buffer_size() * sizeof(float), geometry.vertex_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the normal array
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo[1]);
-    glBufferData(GL_ARRAY_BUFFER, geometry.normal_buffer_size() * sizeof(float), geometry.normal_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the tangent array
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo[2]);
-    glBufferData(GL_ARRAY_BUFFER, geometry.tangent_buffer_size() * sizeof(float), geometry.tangent_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the texture array
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[3]);
-    glBufferData(GL_ARRAY_BUFFER, geometry.texture_buffer_size() * sizeof(float), geometry.texture_buffer().get(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, geometry.vertex_buffer_size(), geometry.vertex_data(), GL_STATIC_DRAW);
 
-    // get the attribute locations
-    GLuint vloc = shader.attrib_location("vertex");
-    GLint nloc = shader.attrib_location("normal");
-    GLint tnloc = shader.attrib_location("tangent");
-    GLuint tloc = shader.attrib_location("texture_coord");
-
-    glEnableVertexAttribArray(vloc);
-    glEnableVertexAttribArray(nloc);
-    glEnableVertexAttribArray(tnloc);
-    glEnableVertexAttribArray(tloc);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo[3]);
-        glVertexAttribPointer(tloc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    // render the geometry
+    RenderCommandBuffer buffer;
+    buffer.bind_program(shader);
+    buffer.vertex_layout(shader, vbo, geometry.vertex_layout());
+    buffer.draw_arrays(GL_TRIANGLES, 0, geometry.vertex_count());
+    buffer.replay();
 
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo[1]);
-        glVertexAttribPointer(nloc, 3, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo[2]);
-        glVertexAttribPointer(tnloc, 4, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-        glVertexAttribPointer(vloc, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-        glDrawArrays(GL_TRIANGLES, 0, geometry.vertex_count());
-    glDisableVertexAttribArray(tloc);
-    glDisableVertexAttribArray(tnloc);
-    glDisableVertexAttribArray(nloc);
-    glDisableVertexAttribArray(vloc);
-
-    glDeleteBuffers(4, vbo);
+    glDeleteBuffers(1, &vbo);
 }
 
 void Renderer::render_fullscreen_quad(Shader& shader)
@@ -608,6 +575,9 @@ bool Renderer::init(int width, int height, int bpp)
 {
     LOG_INFO("Initializing renderer...\n");
 
+    // whoever owns the context drains the command queue
+    _command_queue.bind_consumer();
+
     GLenum err = glewInit();
     if(GLEW_OK != err) {
         LOG_CRITICAL("GLEW error: " << glewGetErrorString(err) << "\n");
@@ -766,6 +736,20 @@ bool Renderer::init_framebuffers(int width, int height)
     return true;
 }
 
+void Renderer::print_command_queue_details() const
+{
+    LOG_INFO("Render Command Queue Details:\n");
+    LOG_INFO("\tDepth: " << _command_queue.size() << " / " << _command_queue.capacity()
+        << " (high water mark: " << _command_queue.high_water_mark() << ")\n");
+    LOG_INFO("\tFull waits: " << _command_queue.full_count() << "\n");
+    LOG_INFO("\tCommands last frame: " << _command_queue.last_drain_count()
+        << ", max per frame: " << _command_queue.max_drain_count() << "\n");
+
+    const size_t drains = _command_queue.drain_calls();
+    LOG_INFO("\tTotal commands: " << _command_queue.total_drain_count() << " over " << drains << " frames"
+        << " (avg " << (drains > 0 ? static_cast<double>(_command_queue.total_drain_count()) / drains : 0.0) << " per frame)\n");
+}
+
 void Renderer::print_video_memory_details()
 {
     LOG_INFO("Video Memory Details:\n");
@@ -870,58 +854,115 @@ void Renderer::init_shader_light(Shader& shader, const Material& material, const
         return;
     }
 
-    Color light_ambient = light.ambient_color();
-    Color light_diffuse = light.diffuse_color();
-    Color light_specular = light.specular_color();
+    LightParameters parameters;
+    light_parameters(light, parameters);
+
+    // pass in the camera position (object-space)
+    shader.uniform3f("camera", (-_model * camera.eye().homogeneous_position()).xyz());
+
+    // pass in the light parameters
+    shader.uniform4f("light_ambient", parameters.ambient);
+    shader.uniform4f("light_diffuse", parameters.diffuse);
+    shader.uniform4f("light_specular", parameters.specular);
+    shader.uniform4f("light_position", parameters.position);
+    shader.uniform1f("light_constant_attenuation", parameters.constant_attenuation);
+    shader.uniform1f("light_linear_attenuation", parameters.linear_attenuation);
+    shader.uniform1f("light_quadratic_attenuation", parameters.quadratic_attenuation);
+    shader.uniform4f("light_spotlight_direction", parameters.spotlight_direction);
+    shader.uniform1f("light_spotlight_cutoff", parameters.spotlight_cutoff);
+    shader.uniform1f("light_spotlight_exponent", parameters.spotlight_exponent);
+
+    // pass in the material parameters
+    shader.uniform4f("material_ambient", Light::lighting_enabled() ? material.ambient_color() : Color(1.0f, 1.0f, 1.0f, 1.0f));
+    shader.uniform4f("material_diffuse", Light::lighting_enabled() ? material.diffuse_color() : Color(0.0f, 0.0f, 0.0f, 1.0f));
+    shader.uniform4f("material_specular",Light::lighting_enabled() ? material.specular_color() : Color(0.0f, 0.0f, 0.0f, 1.0f));
+    shader.uniform1f("material_shininess", Light::lighting_enabled() ? material.shininess() : 0.0f);
+}
+
+void Renderer::record_shader_matrices(RenderCommandBuffer& buffer, const Shader& shader, const Matrix4& model) const
+{
+    const Matrix4 modelview(_view * model);
+    buffer.uniform_matrix4fv(shader, "mvp", _projection * modelview);
+    buffer.uniform_matrix4fv(shader, "modelview", modelview);
+}
+
+void Renderer::record_shader_light(RenderCommandBuffer& buffer, const Shader& shader, const Material& material,
+    const Light& light, const Camera& camera, const Matrix4& model) const
+{
+    if(!Light::lighting_enabled() || !light.enabled()) {
+        return;
+    }
+
+    LightParameters parameters;
+    light_parameters(light, parameters);
+
+    // pass in the camera position (object-space)
+    buffer.uniform3f(shader, "camera", (-model * camera.eye().homogeneous_position()).xyz());
+
+    // pass in the light parameters
+    buffer.uniform4f(shader, "light_ambient", parameters.ambient);
+    buffer.uniform4f(shader, "light_diffuse", parameters.diffuse);
+    buffer.uniform4f(shader, "light_specular", parameters.specular);
+    buffer.uniform4f(shader, "light_position", parameters.position);
+    buffer.uniform1f(shader, "light_constant_attenuation", parameters.constant_attenuation);
+    buffer.uniform1f(shader, "light_linear_attenuation", parameters.linear_attenuation);
+    buffer.uniform1f(shader, "light_quadratic_attenuation", parameters.quadratic_attenuation);
+    buffer.uniform4f(shader, "light_spotlight_direction", parameters.spotlight_direction);
+    buffer.uniform1f(shader, "light_spotlight_cutoff", parameters.spotlight_cutoff);
+    buffer.uniform1f(shader, "light_spotlight_exponent", parameters.spotlight_exponent);
+
+    // pass in the material parameters
+    buffer.uniform4f(shader, "material_ambient", material.ambient_color());
+    buffer.uniform4f(shader, "material_diffuse", material.diffuse_color());
+    buffer.uniform4f(shader, "material_specular", material.specular_color());
+    buffer.uniform1f(shader, "material_shininess", material.shininess());
+}
+
+void Renderer::submit(const RenderCommandBuffer& buffer)
+{
+    buffer.replay();
+    _frame_draw_count += buffer.draw_count();
+}
+
+void Renderer::light_parameters(const Light& light, LightParameters& parameters) const
+{
+    parameters.ambient = light.ambient_color();
+    parameters.diffuse = light.diffuse_color();
+    parameters.specular = light.specular_color();
+
+    parameters.position = Color();
+    parameters.spotlight_direction = Color();
+    parameters.constant_attenuation = 1.0f;
+    parameters.linear_attenuation = 0.0f;
+    parameters.quadratic_attenuation = 0.0f;
+    parameters.spotlight_cutoff = 180.0f;
+    parameters.spotlight_exponent = 0.0f;
 
-    Color light_position, light_spotlight_direction;
-    float light_constant_attenuation=1.0f, light_linear_attenuation=0.0f, light_quadratic_attenuation=0.0f, light_spotlight_cutoff=180.0f, light_spotlight_exponent=0.0f;
     if(typeid(light) == typeid(DirectionalLight)) {
         const DirectionalLight& directional(dynamic_cast<const DirectionalLight&>(light));
-        light_position = directional.direction();
+        parameters.position = directional.direction();
     } else if(typeid(light) == typeid(PositionalLight)) {
         const PositionalLight& positional(dynamic_cast<const PositionalLight&>(light));
-        light_position = positional.position().homogeneous_position();
+        parameters.position = positional.position().homogeneous_position();
 
-        light_constant_attenuation = positional.constant_attenuation();
-        light_linear_attenuation = positional.linear_attenuation();
-        light_quadratic_attenuation = positional.quadratic_attenuation();
+        parameters.constant_attenuation = positional.constant_attenuation();
+        parameters.linear_attenuation = positional.linear_attenuation();
+        parameters.quadratic_attenuation = positional.quadratic_attenuation();
     } else if(typeid(light) == typeid(SpotLight)) {
         const SpotLight& spot(dynamic_cast<const SpotLight&>(light));
-        light_position = spot.position().homogeneous_position();
-
-        light_spotlight_direction = Color(spot.direction(), 0.0f);
-        light_spotlight_cutoff = spot.cutoff();
-        light_spotlight_exponent = spot.exponent();
-        light_constant_attenuation = spot.constant_attenuation();
-        light_linear_attenuation = spot.linear_attenuation();
-        light_quadratic_attenuation = spot.quadratic_attenuation();
+        parameters.position = spot.position().homogeneous_position();
+
+        parameters.spotlight_direction = Color(spot.direction(), 0.0f);
+        parameters.spotlight_cutoff = spot.cutoff();
+        parameters.spotlight_exponent = spot.exponent();
+        parameters.constant_attenuation = spot.constant_attenuation();
+        parameters.linear_attenuation = spot.linear_attenuation();
+        parameters.quadratic_attenuation = spot.quadratic_attenuation();
     }
 
     // put the light position/directions into eye space
-    light_position = _view * light_position;
-    light_spotlight_direction = _view * light_spotlight_direction;
-
-    // pass in the camera position (object-space)
-    shader.uniform3f("camera", (-_model * camera.position().homogeneous_position()).xyz());
-
-    // pass in the light parameters
-    shader.uniform4f("light_ambient", light_ambient);
-    shader.uniform4f("light_diffuse", light_diffuse);
-    shader.uniform4f("light_specular", light_specular);
-    shader.uniform4f("light_position", light_position);
-    shader.uniform1f("light_constant_attenuation", light_constant_attenuation);
-    shader.uniform1f("light_linear_attenuation", light_linear_attenuation);
-    shader.uniform1f("light_quadratic_attenuation", light_quadratic_attenuation);
-    shader.uniform4f("light_spotlight_direction", light_spotlight_direction);
-    shader.uniform1f("light_spotlight_cutoff", light_spotlight_cutoff);
-    shader.uniform1f("light_spotlight_exponent", light_spotlight_exponent);
-
-    // pass in the material parameters
-    shader.uniform4f("material_ambient", Light::lighting_enabled() ? material.ambient_color() : Color(1.0f, 1.0f, 1.0f, 1.0f));
-    shader.uniform4f("material_diffuse", Light::lighting_enabled() ? material.diffuse_color() : Color(0.0f, 0.0f, 0.0f, 1.0f));
-    shader.uniform4f("material_specular",Light::lighting_enabled() ? material.specular_color() : Color(0.0f, 0.0f, 0.0f, 1.0f));
-    shader.uniform1f("material_shininess", Light::lighting_enabled() ? material.shininess() : 0.0f);
+    parameters.position = _view * parameters.position;
+    parameters.spotlight_direction = _view * parameters.spotlight_direction;
 }
 
 void Renderer::print_info()
@@ -1093,7 +1134,7 @@ bool Renderer::require_shadow_volume_cap(const Renderable& renderable, const Lig
     const float e = 1.0f / std::tan(_fov / 2.0f);
 
     // world-space bounds
-    const AABB bounds(renderable.absolute_bounds());
+    const AABB bounds(renderable.render_bounds());
     const Position C(bounds.center(), 1.0f);
     const float r = bounds.radius();
 
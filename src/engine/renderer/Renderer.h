@@ -3,6 +3,7 @@
 
 #include "src/core/math/Matrix4.h"
 #include "src/engine/scene/Map.h"
+#include "RenderCommandBuffer.h"
 #include "RenderCommandQueue.h"
 
 namespace energonsoftware {
@@ -30,6 +31,14 @@ private:
         VBOCount
     };
 
+    struct LightParameters
+    {
+        Color ambient, diffuse, specular;
+        Color position, spotlight_direction;
+        float constant_attenuation, linear_attenuation, quadratic_attenuation;
+        float spotlight_cutoff, spotlight_exponent;
+    };
+
 public:
     static void destroy(Renderer* const renderer, MemoryAllocator* const allocator);
 
@@ -127,6 +136,7 @@ public:
     void render_fullscreen_quad(Shader& shader);*/
 //// END OLD
 
+    void print_command_queue_details() const;
     void print_video_memory_details();
     void dump_matrices() const;
 
@@ -138,6 +148,22 @@ public:
     void init_shader_ambient(Shader& shader, const Material& material) const;
     void init_shader_light(Shader& shader, const Material& material, const Light& light, const Camera& camera) const;
 
+    // recorded versions of the init_shader_*() methods
+    // these take the model matrix instead of using the matrix stack so that
+    // they can be called off of the render thread once the camera has looked for the frame
+    void record_shader_matrices(RenderCommandBuffer& buffer, const Shader& shader, const Matrix4& model) const;
+    void record_shader_light(RenderCommandBuffer& buffer, const Shader& shader, const Material& material,
+        const Light& light, const Camera& camera, const Matrix4& model) const;
+
+    // scratch buffer for render thread code that records and submits right away
+    RenderCommandBuffer& immediate_commands() { return _immediate_commands; }
+
+    // replays a recorded buffer
+    // NOTE: render thread only
+    void submit(const RenderCommandBuffer& buffer);
+
+    size_t frame_draw_count() const { return _frame_draw_count; }
+
 private:
     friend class Engine;
     bool init(int width, int height, int bpp);
@@ -147,6 +173,8 @@ private:
     void print_info();
     bool check_extensions();
 
+    void light_parameters(const Light& light, LightParameters& parameters) const;
+
     /*void render_ambient(const Camera& camera, Map& map) const;
     void render_shadows(const Light& light, const Camera& camera);
     void render_shadow(const Renderable& renderable, const Light& light, const Camera& camera, size_t vcount) const;
@@ -166,8 +194,11 @@ private:
     double _frame_start;
     size_t _frame_count;
 
+    size_t _frame_draw_count;
+
     // render commands
     RenderCommandQueue _command_queue;
+    RenderCommandBuffer _immediate_commands;
 
     // matrix state
     Matrix4 _projection;
@@ -76,6 +76,12 @@ GLint Shader::uniform_location(const std::string& name)
     return location;
 }
 
+GLint Shader::find_uniform_location(const std::string& name) const
+{
+    boost::unordered_map<std::string, GLint>::const_iterator it(_uniform_map.find(name));
+    return it == _uniform_map.end() ? -1 : it->second;
+}
+
 void Shader::uniform1f(const std::string& name, GLfloat v0)
 {
     glUniform1f(uniform_location(name), v0);
@@ -208,6 +214,12 @@ GLint Shader::attrib_location(const std::string& name)
     return location;
 }
 
+GLint Shader::find_attrib_location(const std::string& name) const
+{
+    boost::unordered_map<std::string, GLint>::const_iterator it(_attrib_map.find(name));
+    return it == _attrib_map.end() ? -1 : it->second;
+}
+
 void Shader::bind_attrib(GLuint index, const std::string& name) const
 {
     glBindAttribLocation(_program, index, name.c_str());
@@ -287,6 +299,50 @@ void Shader::link() throw(ShaderError)
         _program = 0;
         throw ShaderError("Failed to link shader!");
     }
+
+    cache_locations();
+}
+
+void Shader::cache_locations()
+{
+    GLint max_length=0;
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    GLint attrib_max_length=0;
+    glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attrib_max_length);
+    std::vector<GLchar> name(std::max(max_length, attrib_max_length) + 1);
+
+    GLint count=0;
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
+    for(GLint i=0; i<count; ++i) {
+        GLsizei length=0;
+        GLint size=0;
+        GLenum type;
+        glGetActiveUniform(_program, i, name.size(), &length, &size, &type, &name[0]);
+
+        std::string uniform(&name[0], length);
+        const GLint location = glGetUniformLocation(_program, uniform.c_str());
+
+        // arrays are reported as "name[0]", allow them to be looked up either way
+        if(uniform.size() > 3 && 0 == uniform.compare(uniform.size() - 3, 3, "[0]")) {
+            _uniform_map[uniform] = location;
+            uniform.erase(uniform.size() - 3);
+        }
+        _uniform_map[uniform] = location;
+    }
+
+    count = 0;
+    glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTES, &count);
+    for(GLint i=0; i<count; ++i) {
+        GLsizei length=0;
+        GLint size=0;
+        GLenum type;
+        glGetActiveAttrib(_program, i, name.size(), &length, &size, &type, &name[0]);
+
+        const std::string attrib(&name[0], length);
+        _attrib_map[attrib] = glGetAttribLocation(_program, attrib.c_str());
+    }
+
+    LOG_DEBUG("Shader '" << _name << "' has " << _uniform_map.size() << " uniforms and " << _attrib_map.size() << " attributes\n");
 }
 
 boost::shared_array<char> Shader::read_shader_file(const boost::filesystem::path& filename) throw(ShaderError)
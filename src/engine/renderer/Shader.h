@@ -33,9 +33,16 @@ public:
 
 public:
     const std::string& name() const { return _name; }
+    GLuint program() const { return _program; }
 
     GLint uniform_location(const std::string& name);
 
+    // these only search the locations cached when the shader was linked
+    // so they make no GL calls and are safe to use from any thread
+    // returns -1 if the shader has no such active uniform / attribute
+    GLint find_uniform_location(const std::string& name) const;
+    GLint find_attrib_location(const std::string& name) const;
+
     void uniform1f(const std::string& name, GLfloat v0);
     void uniform1fv(const std::string& name, size_t count, const GLfloat* value);
 
@@ -72,6 +79,7 @@ private:
     void compile_fragment_shader(const char* source) throw(ShaderError);
 
     void link() throw(ShaderError);
+    void cache_locations();
 
     // NOTE: this returns a *temporary* buffer that will be free'd on the next frame
     boost::shared_array<char> read_shader_file(const boost::filesystem::path& filename) throw(ShaderError);
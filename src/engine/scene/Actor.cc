@@ -31,23 +31,15 @@ boost::shared_ptr<Actor> Actor::new_actor(const std::string& type, const std::st
 Actor::Actor(const std::string& name)
     : Renderable(name), _cframe(0), _ftime(0.0)
 {
-    boost::shared_ptr<GenBuffersRenderCommand> command(
-        boost::dynamic_pointer_cast<GenBuffersRenderCommand, RenderCommand>(
-            RenderCommand::new_render_command(RenderCommand::RC_GEN_BUFFERS)));
-    command->n = SkeletonVBOCount;
-    command->callback = boost::bind(&Actor::skeleton_buffer_callback, this, _1);
-    Engine::instance().renderer().command_queue().push(command);
+    Engine::instance().renderer().command_queue().push(
+        RenderCommand::gen_buffers(SkeletonVBOCount, boost::bind(&Actor::skeleton_buffer_callback, this, _1)));
 }
 
 Actor::~Actor() throw()
 {
     if(_skeleton_vbo) {
-        boost::shared_ptr<DeleteBuffersRenderCommand> command(
-            boost::dynamic_pointer_cast<DeleteBuffersRenderCommand, RenderCommand>(
-                RenderCommand::new_render_command(RenderCommand::RC_DELETE_BUFFERS)));
-        command->n = SkeletonVBOCount;
-        command->buffers = _skeleton_vbo.get();
-        Engine::instance().renderer().command_queue().push(command);
+        Engine::instance().renderer().command_queue().push(
+            RenderCommand::delete_buffers(SkeletonVBOCount, _skeleton_vbo.get()));
     }
 }
 
@@ -66,6 +58,9 @@ void Actor::animation(boost::shared_ptr<Animation> animation)
     }
 
     _animation = animation;
+
+    // the pose is blended in place every frame
+    _skeleton.copy_hierarchy(model().skeleton());
 }
 
 void Actor::current_frame(size_t frame)
@@ -78,10 +73,26 @@ double Actor::frame_percent() const
     return _ftime / _animation->frame_duration();
 }
 
+void Actor::snapshot(Snapshot& snapshot) const
+{
+    Renderable::snapshot(snapshot);
+
+    snapshot.pose.animated = static_cast<bool>(_animation);
+    if(snapshot.pose.animated) {
+        snapshot.pose.frame = current_frame();
+        snapshot.pose.next_frame = next_frame();
+        snapshot.pose.percent = static_cast<float>(frame_percent());
+    }
+}
+
 void Actor::animate()
 {
-    _skeleton.reset();
-    _animation->interpolate_skeleton(current_frame(), next_frame(), _skeleton, frame_percent());
+    const Snapshot* const state = render_state();
+    if(NULL == state || !state->pose.animated) {
+        return;
+    }
+
+    _animation->interpolate_skeleton(state->pose.frame, state->pose.next_frame, _skeleton, state->pose.percent);
     calculate_vertices(_skeleton);
 }
 
@@ -104,7 +115,9 @@ void Actor::advance_frame()
 void Actor::render_skeleton() const
 {
     Matrix4 matrix;
-    transform(matrix);
+    if(!render_transform(matrix)) {
+        return;
+    }
 
     Engine::instance().renderer().push_model_matrix();
     Engine::instance().renderer().multiply_model_matrix(matrix);
@@ -115,13 +128,13 @@ void Actor::render_skeleton() const
     MemoryAllocator& allocator(Engine::instance().frame_allocator());
     boost::shared_array<float> v(new(allocator) float[vcount], boost::bind(&MemoryAllocator::release, &allocator, _1));
     for(size_t i=0, j=0; i<model().joint_count(); ++i) {
-        const Skeleton::Joint& joint(_skeleton.joint(i));
-        if(joint.parent < 0) {
+        const int parent = _skeleton.parent(i);
+        if(parent < 0) {
             continue;
         }
 
-        const Position& pp(_skeleton.joint(joint.parent).position);
-        const Position& p(joint.position);
+        const Position pp(_skeleton.position(parent));
+        const Position p(_skeleton.position(i));
 
         const size_t idx = j * 3 * 2;
         v[idx + 0] = pp.x();
@@ -163,7 +176,7 @@ void Actor::skeleton_buffer_callback(boost::shared_array<GLuint> buffers)
     _skeleton_vbo = buffers;
 }
 
-bool Actor::on_think(double dt)
+bool Actor::on_simulate(double dt)
 {
 // TODO: this should run the current animation until it's done
 // then update the position
@@ -185,19 +198,24 @@ bool Actor::on_think(double dt)
         bounds(model().bounds());
     }
 
-    return true;
+    return on_think(dt);
 }
 
 void Actor::on_render_unlit(const Camera& camera) const
 {
+    const Snapshot* const state = render_state();
+    if(NULL == state) {
+        return;
+    }
+
     Matrix4 matrix;
-    transform(matrix);
+    state->physical.transform(matrix, Engine::instance().interpolation());
 
     Engine::instance().renderer().push_modelview_matrix();
     Engine::instance().renderer().multiply_model_matrix(matrix);
     Engine::instance().renderer().modelview_rotation_identity();
 
-    const AABB& bounds(relative_bounds());
+    const AABB& bounds(state->physical.relative_bounds);
     const Position& center(bounds.center());
     _nameplate.render(name(), Vector3(center.x(), bounds.maximum().y(), center.z()), camera);
 
@@ -47,6 +47,9 @@ public:
     virtual bool is_static() const { return false; }
     virtual bool has_shadow() const { return true; }
 
+    virtual void snapshot(Snapshot& snapshot) const;
+
+    // poses the skeleton from the render state
     virtual void animate();
 
     void render_skeleton() const;
@@ -58,7 +61,13 @@ private:
 
     void skeleton_buffer_callback(boost::shared_array<GLuint> buffers);
 
-    virtual bool on_think(double dt);
+    // advances the animation and updates the bounds
+    // NOTE: this runs in parallel with the other physicals
+    virtual bool on_simulate(double dt);
+
+    // AI hook for subclasses, called every simulation step
+    virtual bool on_think(double dt) { return true; }
+
     virtual void on_render_unlit(const Camera& camera) const;
 
 private:
@@ -67,8 +76,7 @@ private:
     size_t _cframe;
     double _ftime;
 
-    // this is a "temporary" skeleton
-    // that is wiped with the frame allocator
+    // the current pose, laid out once when the animation is set
     Skeleton _skeleton;
     boost::shared_array<GLuint> _skeleton_vbo;
 
@@ -1,5 +1,6 @@
 #include "src/pch.h"
 #include "src/core/common.h"
+#include "src/core/util/ScopedStackMarker.h"
 #include "src/engine/DoomLexer.h"
 #include "src/engine/Engine.h"
 #include "src/engine/ResourceManager.h"
@@ -13,6 +14,7 @@
 namespace energonsoftware {
 
 D3Map::Surface::Surface()
+    : original_cache_misses(0), cache_misses(0)
 {
     glGenBuffers(Renderable::RenderBuffers::GeometryVBOCount, vbo);
 }
@@ -25,30 +27,33 @@ D3Map::Surface::~Surface() throw()
 
 void D3Map::Surface::init()
 {
+    // dmap writes the triangles out in whatever order it built them
+    original_cache_misses = vertex_cache_misses(triangles.get(), triangle_count, vertex_count);
+    optimize_vertex_cache(triangles.get(), triangle_count, vertex_count);
+    optimize_vertex_fetch(vertices.get(), vertex_count, triangles.get(), triangle_count);
+    cache_misses = vertex_cache_misses(triangles.get(), triangle_count, vertex_count);
+
     // store the temporary vectors on the frame allocator
-    compute_tangents(triangles, triangle_count, vertices, vertex_count, Engine::instance().frame_allocator());
+    {
+        DoubleBufferedAllocator& allocator(Engine::instance().frame_allocator());
+        ScopedStackMarker<DoubleBufferedAllocator> marker(allocator);
+        compute_tangents(triangles, triangle_count, vertices, vertex_count, allocator);
+    }
 
     // geometry goes on the scene allocator
     MemoryAllocator& allocator(Engine::instance().state().scene().allocator());
-    geometry.reset(new(allocator) Geometry(triangle_count, vertex_count, allocator),
+    geometry.reset(new(allocator) Geometry(triangle_count, vertex_count, allocator, Geometry::StaticVertices),
         boost::bind(&Geometry::destroy, _1, &allocator));
-    geometry->copy_triangles(triangles.get(), triangle_count, vertices.get(), vertex_count, 0);
+    geometry->copy_triangles(triangles.get(), triangle_count, vertices.get(), vertex_count);
+
+    // setup the index array
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::IndexArray]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry->index_buffer_size(), geometry->index_buffer().get(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     // setup the vertex array
     glBindBuffer(GL_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::VertexArray]);
-    glBufferData(GL_ARRAY_BUFFER, geometry->vertex_buffer_size() * sizeof(float), geometry->vertex_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the normal array
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::NormalArray]);
-    glBufferData(GL_ARRAY_BUFFER, geometry->normal_buffer_size() * sizeof(float), geometry->normal_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the tangent array
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::TangentArray]);
-    glBufferData(GL_ARRAY_BUFFER, geometry->tangent_buffer_size() * sizeof(float), geometry->tangent_buffer().get(), GL_STATIC_DRAW);
-
-    // setup the texture array
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::TextureArray]);
-    glBufferData(GL_ARRAY_BUFFER, geometry->texture_buffer_size() * sizeof(float), geometry->texture_buffer().get(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, geometry->vertex_buffer_size(), geometry->vertex_data(), GL_STATIC_DRAW);
 
     // setup the normal line array
     glBindBuffer(GL_ARRAY_BUFFER, vbo[Renderable::RenderBuffers::NormalLineArray]);
@@ -215,36 +220,52 @@ void D3Map::on_unload()
 }
 
 void D3Map::render(const Camera& camera, Shader& shader) const
+{
+    Renderer& renderer(Engine::instance().renderer());
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record(buffer, camera, shader);
+    renderer.submit(buffer);
+}
+
+void D3Map::render(const Camera& camera, Shader& shader, const Light& light) const
+{
+    Renderer& renderer(Engine::instance().renderer());
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record(buffer, camera, shader, light);
+    renderer.submit(buffer);
+}
+
+void D3Map::record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader) const
 {
     Matrix4 matrix;
     matrix.translate(Position());
 
-    Engine::instance().renderer().push_model_matrix();
-    Engine::instance().renderer().multiply_model_matrix(matrix);
-
-    Engine::instance().renderer().init_shader_matrices(shader);
+    buffer.bind_program(shader);
+    Engine::instance().renderer().record_shader_matrices(buffer, shader, matrix);
 
     // TODO: BSP and portal this shit
     BOOST_FOREACH(boost::shared_ptr<Model> model, _models) {
         if(model->is_area()) {
-            render_area(camera, *model, shader);
+            record_area(buffer, camera, *model, shader);
         }
     }
-
-    Engine::instance().renderer().pop_model_matrix();
 }
 
-
-void D3Map::render(const Camera& camera, Shader& shader, const Light& light) const
+void D3Map::record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader, const Light& light) const
 {
-    Engine::instance().renderer().init_shader_matrices(shader);
-    Engine::instance().renderer().init_shader_light(shader, material(), light, camera);
+    Matrix4 matrix;
+
+    buffer.bind_program(shader);
+    Engine::instance().renderer().record_shader_matrices(buffer, shader, matrix);
+    Engine::instance().renderer().record_shader_light(buffer, shader, material(), light, camera, matrix);
 
     // TODO: BSP and portal this shit
     // for now we'll just do a bounds check
     BOOST_FOREACH(boost::shared_ptr<Model> model, _models) {
         if(model->is_area() && camera.visible(model->bounds)) {
-            render_area(camera, *model, shader);
+            record_area(buffer, camera, *model, shader);
         }
     }
 }
@@ -260,12 +281,12 @@ void D3Map::render_normals(const Camera& camera) const
     }
 }
 
-void D3Map::render_area(const Camera& camera, const Model& area, Shader& shader) const
+void D3Map::record_area(RenderCommandBuffer& buffer, const Camera& camera, const Model& area, const Shader& shader) const
 {
     for(int i=0; i<area.surface_count; ++i) {
         const Surface& surface(*(area.surfaces[i]));
         if(camera.visible(surface.bounds)) {
-            render_surface(surface, shader);
+            record_surface(buffer, surface, shader);
         }
     }
 }
@@ -280,56 +301,28 @@ void D3Map::render_area_normals(const Camera& camera, const Model& area) const
     }
 }
 
-void D3Map::render_surface(const Surface& surface, Shader& shader) const
+void D3Map::record_surface(RenderCommandBuffer& buffer, const Surface& surface, const Shader& shader) const
 {
-    // setup the detail texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, surface.textures[ResourceManager::DetailTexture]);
-    shader.uniform1i("detail_texture", 0);
+    // setup the textures
+    buffer.bind_texture(0, surface.textures[Renderable::TextureBuffers::DetailTexture]);
+    buffer.uniform1i(shader, "detail_texture", 0);
 
-    // setup the normal map
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, surface.textures[ResourceManager::NormalMap]);
-    shader.uniform1i("normal_map", 1);
+    buffer.bind_texture(1, surface.textures[Renderable::TextureBuffers::NormalMap]);
+    buffer.uniform1i(shader, "normal_map", 1);
 
-    // setup the specular map
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, surface.textures[ResourceManager::SpecularMap]);
-    shader.uniform1i("specular_map", 2);
+    buffer.bind_texture(2, surface.textures[Renderable::TextureBuffers::SpecularMap]);
+    buffer.uniform1i(shader, "specular_map", 2);
 
     // setup the emission map
-    /*glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, mesh.texture(ResourceManager::EmissionMap));
-    shader.uniform1i("emission_map", 3);*/
+    /*buffer.bind_texture(3, surface.textures[Renderable::TextureBuffers::EmissionMap]);
+    buffer.uniform1i(shader, "emission_map", 3);*/
 
-    // get the attribute locations
-    GLint vloc = shader.attrib_location("vertex");
-    GLint nloc = shader.attrib_location("normal");
-    GLint tnloc = shader.attrib_location("tangent");
-    GLint tloc = shader.attrib_location("texture_coord");
+    // render the surface
+    buffer.vertex_layout(shader, surface.vbo[Renderable::RenderBuffers::VertexArray], surface.geometry->vertex_layout());
 
-    // render the mesh
-    glEnableVertexAttribArray(vloc);
-    glEnableVertexAttribArray(nloc);
-    glEnableVertexAttribArray(tnloc);
-    glEnableVertexAttribArray(tloc);
-        glBindBuffer(GL_ARRAY_BUFFER, surface.vbo[Renderable::RenderBuffers::TextureArray]);
-        glVertexAttribPointer(tloc, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, surface.vbo[Renderable::RenderBuffers::NormalArray]);
-        glVertexAttribPointer(nloc, 3, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, surface.vbo[Renderable::RenderBuffers::TangentArray]);
-        glVertexAttribPointer(tnloc, 4, GL_FLOAT, GL_TRUE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, surface.vbo[Renderable::RenderBuffers::VertexArray]);
-        glVertexAttribPointer(vloc, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-        glDrawArrays(GL_TRIANGLES, 0, surface.triangle_count * 3);
-    glDisableVertexAttribArray(tloc);
-    glDisableVertexAttribArray(tnloc);
-    glDisableVertexAttribArray(nloc);
-    glDisableVertexAttribArray(vloc);
+    buffer.draw_elements(GL_TRIANGLES, surface.triangle_count * 3,
+        sizeof(uint16_t) == surface.geometry->index_size() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+        surface.vbo[Renderable::RenderBuffers::IndexArray], 0);
 }
 
 void D3Map::render_surface_normals(const Surface& surface) const
@@ -911,6 +904,21 @@ bool D3Map::load_proc(const boost::filesystem::path& path)
         }
     }
 
+    size_t triangle_count = 0, original_cache_misses = 0, cache_misses = 0;
+    BOOST_FOREACH(boost::shared_ptr<Model> model, _models) {
+        for(int i=0; i<model->surface_count; ++i) {
+            const Surface& surface(*model->surfaces[i]);
+            triangle_count += surface.triangle_count;
+            original_cache_misses += surface.original_cache_misses;
+            cache_misses += surface.cache_misses;
+        }
+    }
+
+    if(triangle_count > 0) {
+        LOG_INFO("Vertex cache ACMR " << (original_cache_misses / static_cast<float>(triangle_count))
+            << " -> " << (cache_misses / static_cast<float>(triangle_count)) << "\n");
+    }
+
     return true;
 }
 
@@ -34,6 +34,9 @@ private:
 
         AABB bounds;
 
+        // post-transform vertex cache misses before and after init() reordered the triangles
+        size_t original_cache_misses, cache_misses;
+
         Surface();
         virtual ~Surface() throw();
 
@@ -116,10 +119,13 @@ public:
     virtual void render(const Camera& camera, Shader& shader, const Light& light) const;
     virtual void render_normals(const Camera& camera) const;
 
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader) const;
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader, const Light& light) const;
+
 private:
-    void render_area(const Camera& camera, const Model& area, Shader& shader) const;
+    void record_area(RenderCommandBuffer& buffer, const Camera& camera, const Model& area, const Shader& shader) const;
     void render_area_normals(const Camera& camera, const Model& area) const;
-    void render_surface(const Surface& surface, Shader& shader) const;
+    void record_surface(RenderCommandBuffer& buffer, const Surface& surface, const Shader& shader) const;
     void render_surface_normals(const Surface& surface) const;
 
 private:
@@ -6,6 +6,7 @@
 namespace energonsoftware {
 
 class Camera;
+class RenderCommandBuffer;
 class Shader;
 
 class Light;
@@ -42,6 +43,10 @@ public:
     virtual void render(const Camera& camera, Shader& shader, const Light& light) const = 0;
     virtual void render_normals(const Camera& camera) const = 0;
 
+    // records what render() does without making any GL calls
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader) const = 0;
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader, const Light& light) const = 0;
+
 private:
     std::string _name;
     Lights _lights;
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include "src/core/common.h"
+#include "src/core/math/VertexLayout.h"
 #include "src/engine/Engine.h"
 #include "src/engine/ResourceManager.h"
 #include "src/engine/State.h"
@@ -17,6 +18,26 @@
 
 namespace energonsoftware {
 
+// what the faces are drawn from, see face_vertex_layout()
+// NOTE: the texture coordinates stay full floats because
+// they tile too far outside of [0, 1] for half floats
+struct FaceVertex
+{
+    float position[3];
+    float texture_coords[2];
+};
+
+static VertexLayout face_vertex_layout()
+{
+    VertexLayout layout;
+    layout.add("vertex", VertexLayout::Float, 3)
+        .add("texture_coord", VertexLayout::Float, 2)
+        .stride(sizeof(FaceVertex));
+    return layout;
+}
+
+static const VertexLayout g_face_vertex_layout(face_vertex_layout());
+
 Logger& Q3BSP::logger(Logger::instance("gled.engine.scene.Q3BSP"));
 
 void Q3BSP::destroy(Q3BSP* const map, MemoryAllocator* const allocator)
@@ -462,6 +483,7 @@ bool Q3BSP::load(const boost::filesystem::path& path)
     }
 
     glGenBuffers(VBOCount, _vbo);
+    init_buffers();
 
     return true;
 }
@@ -489,6 +511,7 @@ void Q3BSP::on_unload()
     _mesh_verts.reset();
     _effects.reset();
     _faces.reset();
+    _face_index_offsets.clear();
     _light_maps.reset();
     _light_vols.reset();
 
@@ -498,28 +521,44 @@ void Q3BSP::on_unload()
 }
 
 void Q3BSP::render(const Camera& camera, Shader& shader) const
+{
+    Renderer& renderer(Engine::instance().renderer());
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record(buffer, camera, shader);
+    renderer.submit(buffer);
+}
+
+void Q3BSP::render(const Camera& camera, Shader& shader, const Light& light) const
+{
+    Renderer& renderer(Engine::instance().renderer());
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record(buffer, camera, shader, light);
+    renderer.submit(buffer);
+}
+
+void Q3BSP::record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader) const
 {
     std::vector<int> faces;
     visible_faces(camera, faces);
 
-    Engine::instance().renderer().init_shader_matrices(shader);
+    buffer.bind_program(shader);
+    Engine::instance().renderer().record_shader_matrices(buffer, shader, Matrix4());
 
-    BOOST_FOREACH(int face, faces) {
-        //render_face(_faces[face], shader);
-    }
+    record_faces(buffer, faces, shader);
 }
 
-void Q3BSP::render(const Camera& camera, Shader& shader, const Light& light) const
+void Q3BSP::record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader, const Light& light) const
 {
     std::vector<int> faces;
     visible_faces(camera, faces);
 
-    Engine::instance().renderer().init_shader_matrices(shader);
-    Engine::instance().renderer().init_shader_light(shader, material(), light, camera);
+    buffer.bind_program(shader);
+    Engine::instance().renderer().record_shader_matrices(buffer, shader, Matrix4());
+    Engine::instance().renderer().record_shader_light(buffer, shader, material(), light, camera, Matrix4());
 
-    BOOST_FOREACH(int face, faces) {
-        //render_face(_faces[face], shader);
-    }
+    record_faces(buffer, faces, shader);
 }
 
 void Q3BSP::render_normals(const Camera& camera) const
@@ -529,7 +568,7 @@ void Q3BSP::render_normals(const Camera& camera) const
 
 void Q3BSP::visible_faces(const Camera& camera, std::vector<int>& faces) const
 {
-    int leaf = find_leaf(camera.position());
+    int leaf = find_leaf(camera.eye());
     for(size_t i=0; i<_leaf_count; ++i) {
         const Leaf& tl(_leaves[i]);
         const AABB bounds(Point3(tl.mins), Point3(tl.maxs));
@@ -581,87 +620,83 @@ bool Q3BSP::cluster_visible(int from, int cluster) const
     return (_vis_data.vecs[idx] & (1 << (cluster & 7))) != 0;
 }
 
-void Q3BSP::render_face(const Face& face, Shader& shader) const
+void Q3BSP::init_buffers()
 {
-    // store the temporary vertex data on the frame allocator
-    MemoryAllocator& allocator(Engine::instance().frame_allocator());
+    const size_t vertex_count = _header.direntries[DirEntryVertices].length / sizeof(BSPVertex);
+    const size_t face_count = _header.direntries[DirEntryFaces].length / sizeof(Face);
 
-    size_t vcount = 0;
-    boost::shared_array<float> vertices;
-    boost::shared_array<float> textures;
-    switch(face.type)
-    {
-    case 1:
-    case 3:
-        {
-            vcount = face.n_meshverts;
-            vertices.reset(new(allocator) float[vcount * 3], boost::bind(&MemoryAllocator::release, &allocator, _1));
-            textures.reset(new(allocator) float[vcount * 2], boost::bind(&MemoryAllocator::release, &allocator, _1));
+    std::vector<FaceVertex> vertices(vertex_count);
+    for(size_t i=0; i<vertex_count; ++i) {
+        const BSPVertex& vertex(_vertices[i]);
+        FaceVertex& packed(vertices[i]);
 
-            // setup the vertex buffer
-            float *va = vertices.get(), *ta = textures.get();
-            for(int i=0; i<face.n_meshverts; ++i) {
-                const MeshVert& meshvert(_mesh_verts[face.meshvert + i]);
-                const BSPVertex& vertex(_vertices[face.vertex + meshvert.offset]);
+        packed.position[0] = vertex.position[0];
+        packed.position[1] = vertex.position[1];
+        packed.position[2] = vertex.position[2];
 
-                const size_t idx = i * 3;
-
-                *(va + idx + 0) = vertex.position[0];
-                *(va + idx + 1) = vertex.position[1];
-                *(va + idx + 2) = vertex.position[2];
-
-                const size_t tidx = i * 2;
+        packed.texture_coords[0] = vertex.texcoord[0][0];
+        packed.texture_coords[1] = vertex.texcoord[0][1];
+    }
 
-                *(ta + tidx + 0) = vertex.texcoord[0][0];
-                *(ta + tidx + 1) = vertex.texcoord[0][1];
+    // meshverts are relative to their face's first vertex,
+    // so each face gets its own range of rebased indices to let every face
+    // draw out of one buffer (faces with the same meshverts can't share a range)
+    std::vector<uint32_t> indices;
+    indices.reserve(_header.direntries[DirEntryMeshVerts].length / sizeof(MeshVert));
+    _face_index_offsets.assign(face_count, 0);
+    for(size_t i=0; i<face_count; ++i) {
+        const Face& face(_faces[i]);
+        switch(face.type)
+        {
+        case 1:
+        case 3:
+            _face_index_offsets[i] = indices.size();
+            for(int j=0; j<face.n_meshverts; ++j) {
+                indices.push_back(face.vertex + _mesh_verts[face.meshvert + j].offset);
             }
+            break;
+        case 2:
+            // TODO: handle patches
+            break;
+        case 4:
+            // TODO: handle billboards
+            break;
+        default:
+            LOG_WARNING("Unknown face type: " << face.type << "\n");
+            break;
         }
-        break;
-    case 2:
-        // TODO: handle patches
-        return;
-    case 4:
-        // TODO: handle billboards
-        return;
-    default:
-        LOG_WARNING("Unknown face type: " << face.type << "\n");
-        return;
     }
 
     // setup the vertex array
     glBindBuffer(GL_ARRAY_BUFFER, _vbo[VertexArray]);
-    glBufferData(GL_ARRAY_BUFFER, vcount * 3 * sizeof(float), vertices.get(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(FaceVertex), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // setup the texture array
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo[TextureArray]);
-    glBufferData(GL_ARRAY_BUFFER, vcount * 2 * sizeof(float), textures.get(), GL_DYNAMIC_DRAW);
+    // setup the index array
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo[IndexArray]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
 
+void Q3BSP::record_faces(RenderCommandBuffer& buffer, const std::vector<int>& faces, const Shader& shader) const
+{
     // setup the detail texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, Engine::instance().resource_manager().texture(ResourceManager::DEFAULT_DETAIL_TEXTURE));
-    shader.uniform1i("detail_texture", 0);
+    buffer.bind_texture(0, Engine::instance().resource_manager().texture(ResourceManager::DEFAULT_DETAIL_TEXTURE));
+    buffer.uniform1i(shader, "detail_texture", 0);
 
     // setup the normal map
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, Engine::instance().resource_manager().texture(ResourceManager::DEFAULT_NORMALMAP_TEXTURE));
-    shader.uniform1i("normal_map", 1);
-
-    // get the attribute locations
-    GLint vloc = shader.attrib_location("vertex");
-    GLint tloc = shader.attrib_location("texture_coord");
-
-    // render the mesh
-    glEnableVertexAttribArray(vloc);
-    glEnableVertexAttribArray(tloc);
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo[TextureArray]);
-        glVertexAttribPointer(tloc, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo[VertexArray]);
-        glVertexAttribPointer(vloc, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-        glDrawArrays(GL_TRIANGLES, 0, vcount);
-    glDisableVertexAttribArray(tloc);
-    glDisableVertexAttribArray(vloc);
+    buffer.bind_texture(1, Engine::instance().resource_manager().texture(ResourceManager::DEFAULT_NORMALMAP_TEXTURE));
+    buffer.uniform1i(shader, "normal_map", 1);
+
+    // every face draws out of the same buffers
+    buffer.vertex_layout(shader, _vbo[VertexArray], g_face_vertex_layout);
+
+    BOOST_FOREACH(int f, faces) {
+        const Face& face(_faces[f]);
+        if(1 == face.type || 3 == face.type) {
+            buffer.draw_elements(GL_TRIANGLES, face.n_meshverts, GL_UNSIGNED_INT, _vbo[IndexArray], _face_index_offsets[f] * sizeof(uint32_t));
+        }
+    }
 }
 
 bool Q3BSP::read_entities(std::ifstream& f)
@@ -12,8 +12,9 @@ class Q3BSP : public Map
 private:
     enum
     {
+        // interleaved, see face_vertex_layout()
         VertexArray,
-        TextureArray,
+        IndexArray,
         VBOCount
     };
 
@@ -309,6 +310,9 @@ public:
     virtual void render(const Camera& camera, Shader& shader, const Light& light) const;
     virtual void render_normals(const Camera& camera) const;
 
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader) const;
+    virtual void record(RenderCommandBuffer& buffer, const Camera& camera, const Shader& shader, const Light& light) const;
+
 private:
     void visible_faces(const Camera& camera, std::vector<int>& faces) const;
 
@@ -318,7 +322,10 @@ private:
     // tests to see if one cluster is visible from another
     bool cluster_visible(int from, int cluster) const;
 
-    void render_face(const Face& face, Shader& shader) const;
+    // uploads the vertices and the polygon and mesh face indices
+    void init_buffers();
+
+    void record_faces(RenderCommandBuffer& buffer, const std::vector<int>& faces, const Shader& shader) const;
 
 private:
     bool read_entities(std::ifstream& f);
@@ -367,6 +374,9 @@ private:
     LightVols _light_vols;
     VisData _vis_data;
 
+    // where each face's rebased indices start in the index array
+    std::vector<size_t> _face_index_offsets;
+
 private:
     Q3BSP();
     DISALLOW_COPY_AND_ASSIGN(Q3BSP);
@@ -2,6 +2,7 @@
 #include <iostream>
 #include "src/core/common.h"
 #include "src/core/math/math_util.h"
+#include "src/core/thread/thread_util.h"
 #include "src/core/util/util.h"
 #include "src/engine/DoomLexer.h"
 #include "src/engine/Engine.h"
@@ -26,9 +27,10 @@ Logger& Scene::logger(Logger::instance("gled.engine.scene.Scene"));
 Scene::Scene()
     : _loaded(false)
 {
-    // TODO: split the sizes of the pools into two config options
     const EngineConfiguration& config(EngineConfiguration::instance());
-    _allocator = MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeStack, config.memory_pool() * 1024 * 1024);
+    // NOTE: scene objects come and go in any order, so this can't be a stack
+    _allocator = boost::static_pointer_cast<TLSFAllocator>(MemoryAllocator::new_allocator(MemoryAllocator::AllocatorTypeTLSF,
+        config.memory_scene_pool() * 1024 * 1024, config.memory_huge_pages()));
 }
 
 Scene::~Scene() throw()
@@ -94,9 +96,26 @@ void Scene::unload()
 
     _physicals.clear();
     _renderables.clear();
+    _renderable_flags.clear();
     _windows.clear();
 
-    _allocator->reset();
+    // NOTE: the heap isn't reset here, everything on it releases itself
+    // and the resource and model caches keep their allocations across scenes
+}
+
+void Scene::register_renderable(boost::shared_ptr<Renderable> renderable)
+{
+    renderable->_snapshot_index = _renderables.size();
+    _renderables.push_back(renderable);
+
+    uint32_t flags = 0;
+    if(renderable->is_transparent()) {
+        flags |= SceneCuller::FlagTransparent;
+    }
+    if(NULL != dynamic_cast<const Pickable*>(renderable.get())) {
+        flags |= SceneCuller::FlagPickable;
+    }
+    _renderable_flags.push_back(flags);
 }
 
 bool Scene::renderables_ready() const
@@ -116,59 +135,125 @@ void Scene::init_renderables()
     }
 }
 
-void Scene::update()
+void Scene::update(double now, double dt)
+{
+    // the update thread runs a share of the batches while it waits
+    Physical::simulate_all(Engine::instance().job_pool(), _physicals, now, dt);
+
+    // NOTE: the camera goes last so that it follows
+    // whatever it's attached to to its new position
+    _camera.simulate(now, dt);
+}
+
+void Scene::publish_snapshot(uint64_t tick, double time)
 {
-    _camera.simulate();
-    BOOST_FOREACH(boost::shared_ptr<Physical> physical, _physicals) {
-        physical->simulate();
+    SceneSnapshot& snapshot(_snapshots.back());
+    snapshot.tick = tick;
+    snapshot.time = time;
+
+    _camera.snapshot(snapshot.camera);
+
+    // NOTE: resizing reuses the buffer's storage from the last time it was published
+    snapshot.renderables.resize(_renderables.size());
+    for(size_t i=0; i<_renderables.size(); ++i) {
+        _renderables[i]->snapshot(snapshot.renderables[i]);
     }
+
+    _snapshots.publish();
 }
 
 void Scene::create_scene_graph()
 {
-    _visible_renderables.clear();
-    _pickable_renderables.clear();
-_lit_renderables.clear();
+    const SceneSnapshot& snapshot(this->snapshot());
+
+    _culler.clear();
+    _culler.reserve(_renderables.size());
+    for(size_t i=0; i<_renderables.size(); ++i) {
+        // not published yet
+        if(i >= snapshot.renderables.size() || snapshot.renderables[i].renderable != _renderables[i].get()) {
+            _culler.add(Position(), AABB(), SceneCuller::FlagDisabled);
+            continue;
+        }
 
-    BOOST_FOREACH(boost::shared_ptr<Renderable> renderable, _renderables) {
-        if(_camera.visible(renderable->absolute_bounds())) {
-            // TODO: add transparent renderables to a separate list
-            if(renderable->is_transparent()) {
-                LOG_ERROR("TODO: Transparent renderables not supported!\n");
-                continue;
-            }
+        const Physical::Snapshot& state(snapshot.renderables[i].physical);
+        _culler.add(state.position, state.relative_bounds, _renderable_flags[i]);
+    }
 
-            _visible_renderables.push_back(renderable);
+    _culler.cull(Engine::instance().job_pool(), _camera.frustum(), _camera.eye());
 
-            boost::shared_ptr<Pickable> pickable(boost::dynamic_pointer_cast<Pickable, Renderable>(renderable));
-            if(pickable) {
-                _pickable_renderables.push_back(renderable);
-            }
-        }
+    if(_culler.transparent_count() > 0) {
+        LOG_ERROR("TODO: Transparent renderables not supported!\n");
+    }
+}
+
+void Scene::record_unlit(RenderCommandBuffer& buffer)
+{
+    record(buffer, NULL);
+}
 
-        // TODO: find all of the lights that intersect this and add it to the per-light renderables
-_lit_renderables.push_back(renderable);
+void Scene::record_lit(RenderCommandBuffer& buffer, const Light& light)
+{
+    record(buffer, &light);
+}
+
+void Scene::record(RenderCommandBuffer& buffer, const Light* const light)
+{
+    const size_t count = _culler.visible().size();
+    const size_t batches = (count + RecordBatchSize - 1) / RecordBatchSize;
+    while(_record_buffers.size() < batches) {
+        _record_buffers.push_back(boost::shared_ptr<RenderCommandBuffer>(new RenderCommandBuffer()));
     }
 
-    // sort the renderables for "efficient" rendering (lol)
-    std::sort(_visible_renderables.begin(), _visible_renderables.end(), CompareRenderablesOpaque(_camera.position()));
+    parallel_for(Engine::instance().job_pool(), 0, count, RecordBatchSize,
+        boost::bind(&Scene::record_batch, this, light, _1, _2));
+
+    // stitch the batches back together in draw order
+    for(size_t i=0; i<batches; ++i) {
+        buffer.append(*_record_buffers[i]);
+    }
+}
+
+void Scene::record_batch(const Light* const light, size_t begin, size_t end)
+{
+    RenderCommandBuffer& buffer(*_record_buffers[begin / RecordBatchSize]);
+    buffer.clear();
+
+    const std::vector<uint32_t>& visible(_culler.visible());
+    for(size_t i=begin; i<end; ++i) {
+        const Renderable& renderable(*_renderables[visible[i]]);
+        if(NULL != light) {
+            renderable.record(buffer, *light, _camera);
+        } else {
+            renderable.record(buffer);
+        }
+    }
 }
 
 void Scene::render_geometry()
 {
+    Renderer& renderer(Engine::instance().renderer());
     if(!_loaded) {
-        Engine::instance().renderer().render(_camera);
+        renderer.render(_camera);
         return;
     }
 
-    // TODO: we should call map->render() here and let it decide which actors to register
-    BOOST_FOREACH(boost::shared_ptr<Renderable> renderable, _renderables) {
+    // TODO: we should call map->render() here and let it decide which actors are visible
+    create_scene_graph();
+
+    // NOTE: skinning uses the render thread's frame allocator,
+    // so the visible actors are animated here rather than while recording
+    BOOST_FOREACH(uint32_t index, _culler.visible()) {
+        boost::shared_ptr<Renderable> renderable(_renderables[index]);
         if(!renderable->is_static()) {
             boost::dynamic_pointer_cast<Actor, Renderable>(renderable)->animate();
         }
-        Engine::instance().renderer().register_renderable(_camera, renderable);
     }
 
+    RenderCommandBuffer& buffer(renderer.immediate_commands());
+    buffer.clear();
+    record_unlit(buffer);
+    renderer.submit(buffer);
+
     // TODO: same for the lights
     /*if(Engine::instance().state().render_lights()) {
         BOOST_FOREACH(boost::shared_ptr<Light> light, _map->lights()) {
@@ -179,7 +264,7 @@ void Scene::render_geometry()
     }*/
 
     // TODO: and obviously this would change as well
-    Engine::instance().renderer().render(_camera, *_map);
+    renderer.render(_camera, *_map);
 }
 
 void Scene::render_2d()
@@ -389,7 +474,7 @@ bool Scene::scan_static(Lexer& lexer)
         return false;
     }
 
-    _renderables.push_back(renderable);
+    register_renderable(renderable);
     return true;
 }
 
@@ -455,7 +540,7 @@ bool Scene::scan_actor(Lexer& lexer, const std::string& type)
 
     LOG_INFO("Pick id=" << actor->pick_id() << ", color=" << actor->pick_color().str() << "\n");
     _physicals.push_back(actor);
-    _renderables.push_back(actor);
+    register_renderable(actor);
     return true;
 }
 
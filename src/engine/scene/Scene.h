@@ -1,13 +1,19 @@
 #if !defined __SCENE_H__
 #define __SCENE_H__
 
+#include "src/core/thread/TripleBuffer.h"
+#include "src/core/util/TLSFAllocator.h"
 #include "src/engine/renderer/Camera.h"
+#include "SceneCuller.h"
+#include "SceneSnapshot.h"
 
 namespace energonsoftware {
 
 class Lexer;
+class Light;
 class Map;
 class Physical;
+class RenderCommandBuffer;
 class Renderable;
 class PositionalLight;
 class SpotLight;
@@ -21,6 +27,12 @@ class Scene
 public:
     typedef boost::function<void (float, const std::string&)> LoadProgressCallback;
 
+    enum
+    {
+        // visible renderables recorded per job
+        RecordBatchSize = 32
+    };
+
 private:
     static Logger& logger;
 
@@ -35,13 +47,32 @@ public:
 
     void register_physical(boost::shared_ptr<Physical> physical) { _physicals.push_back(physical); }
 
-    void register_renderable(boost::shared_ptr<Renderable> renderable) { _renderables.push_back(renderable); }
+    void register_renderable(boost::shared_ptr<Renderable> renderable);
     bool renderables_ready() const;
     void init_renderables();
 
-    void update();
+    // runs one fixed simulation step
+    void update(double now, double dt);
+
+    // copies the simulated state for the render thread
+    // NOTE: update thread only
+    void publish_snapshot(uint64_t tick, double time);
+
+    // picks up the newest published snapshot, returns false if there wasn't a new one
+    // NOTE: render thread only, call once at the start of the frame
+    bool acquire_snapshot() { return _snapshots.acquire(); }
+
+    // NOTE: render thread only
+    const SceneSnapshot& snapshot() const { return _snapshots.front(); }
 
     void create_scene_graph();
+
+    // records the visible renderables into buffer, in parallel on the engine job pool
+    // the unlit version records the ambient pass
+    // NOTE: this makes no GL calls, call create_scene_graph() first
+    void record_unlit(RenderCommandBuffer& buffer);
+    void record_lit(RenderCommandBuffer& buffer, const Light& light);
+
     void render_geometry();
     void render_lit();
     void render_unlit();
@@ -49,7 +80,7 @@ public:
 public:
     bool loaded() const { return _loaded; }
 
-    MemoryAllocator& allocator() { return *_allocator; }
+    TLSFAllocator& allocator() { return *_allocator; }
 
     const Camera& camera() const { return _camera; }
     Camera& camera() { return _camera; }
@@ -60,6 +91,9 @@ public:
 private:
     void callback(float percent, const std::string& status);
 
+    void record(RenderCommandBuffer& buffer, const Light* const light);
+    void record_batch(const Light* const light, size_t begin, size_t end);
+
     bool scan_map(Lexer& lexer);
     bool scan_global_ambient_color(Lexer& lexer);
     bool scan_models(Lexer& lexer);
@@ -74,19 +108,26 @@ private:
     bool _loaded;
     LoadProgressCallback _callback;
 
-    boost::shared_ptr<MemoryAllocator> _allocator;
+    boost::shared_ptr<TLSFAllocator> _allocator;
 
     Camera _camera;
 
+    TripleBuffer<SceneSnapshot> _snapshots;
+
     boost::shared_ptr<Map> _map;
 
     std::vector<boost::shared_ptr<Physical> > _physicals;
     std::vector<boost::shared_ptr<Renderable> > _renderables;
     std::vector<boost::shared_ptr<Window> > _windows;
 
-    std::vector<boost::shared_ptr<Renderable> > _visible_renderables;
-    std::vector<boost::shared_ptr<Renderable> > _pickable_renderables;
-std::vector<boost::shared_ptr<Renderable> > _lit_renderables;
+    // SceneCuller flags for each renderable, worked out when it's registered
+    std::vector<uint32_t> _renderable_flags;
+
+    // entries are in renderable order, so its index lists index _renderables
+    SceneCuller _culler;
+
+    // one per record batch, kept around between frames
+    std::vector<boost::shared_ptr<RenderCommandBuffer> > _record_buffers;
 
 /*public:
 boost::shared_ptr<Q3BSP> _bsp;*/
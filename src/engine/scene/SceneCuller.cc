@@ -0,0 +1,135 @@
+#include "src/pch.h"
+#include "src/core/physics/AABB.h"
+#include "src/core/physics/Frustum.h"
+#include "src/core/thread/thread_util.h"
+#include "SceneCuller.h"
+
+namespace energonsoftware {
+
+SceneCuller::SceneCuller()
+    : _transparent_count(0)
+{
+}
+
+SceneCuller::~SceneCuller() throw()
+{
+}
+
+void SceneCuller::clear()
+{
+    _center_x.clear();
+    _center_y.clear();
+    _center_z.clear();
+    _extent_x.clear();
+    _extent_y.clear();
+    _extent_z.clear();
+    _flags.clear();
+    _visible.clear();
+    _pickable.clear();
+    _lit.clear();
+    _transparent_count = 0;
+}
+
+void SceneCuller::reserve(size_t count)
+{
+    _center_x.reserve(count);
+    _center_y.reserve(count);
+    _center_z.reserve(count);
+    _extent_x.reserve(count);
+    _extent_y.reserve(count);
+    _extent_z.reserve(count);
+    _flags.reserve(count);
+}
+
+size_t SceneCuller::add(const Position& position, const AABB& relative_bounds, uint32_t flags)
+{
+    const Point3& minimum(relative_bounds.minimum());
+    const Point3& maximum(relative_bounds.maximum());
+
+    _center_x.push_back(position.x() + (minimum.x() + maximum.x()) * 0.5f);
+    _center_y.push_back(position.y() + (minimum.y() + maximum.y()) * 0.5f);
+    _center_z.push_back(position.z() + (minimum.z() + maximum.z()) * 0.5f);
+    _extent_x.push_back((maximum.x() - minimum.x()) * 0.5f);
+    _extent_y.push_back((maximum.y() - minimum.y()) * 0.5f);
+    _extent_z.push_back((maximum.z() - minimum.z()) * 0.5f);
+    _flags.push_back(flags);
+    return _flags.size() - 1;
+}
+
+void SceneCuller::cull(ThreadPool& pool, const Frustum& frustum, const Position& eye)
+{
+    const size_t count = size();
+    _visibility.resize((count + 31) >> 5);
+    _distances.resize(count);
+
+    parallel_for(pool, 0, count, CullBatchSize,
+        boost::bind(&SceneCuller::cull_batch, this, boost::cref(frustum), boost::cref(eye), _1, _2));
+
+    compact();
+}
+
+void SceneCuller::cull_batch(const Frustum& frustum, const Position& eye, size_t begin, size_t end)
+{
+    for(size_t word=begin; word<end; word+=32) {
+        const size_t count = std::min(static_cast<size_t>(32), end - word);
+
+        uint32_t bits = frustum.visible(&_center_x[word], &_center_y[word], &_center_z[word],
+            &_extent_x[word], &_extent_y[word], &_extent_z[word], count);
+
+        for(size_t i=0; i<count; ++i) {
+            const uint32_t bit = 1u << i;
+            if(!(bits & bit)) {
+                continue;
+            }
+
+            const size_t idx = word + i;
+            if(_flags[idx] & FlagDisabled) {
+                bits &= ~bit;
+                continue;
+            }
+
+            // squared distance to the closest point on the box
+            const float dx = std::max(std::fabs(eye.x() - _center_x[idx]) - _extent_x[idx], 0.0f);
+            const float dy = std::max(std::fabs(eye.y() - _center_y[idx]) - _extent_y[idx], 0.0f);
+            const float dz = std::max(std::fabs(eye.z() - _center_z[idx]) - _extent_z[idx], 0.0f);
+            _distances[idx] = dx * dx + dy * dy + dz * dz;
+        }
+
+        _visibility[word >> 5] = bits;
+    }
+}
+
+void SceneCuller::compact()
+{
+    const size_t count = size();
+    for(size_t i=0; i<count; ++i) {
+        const uint32_t flags = _flags[i];
+        if(flags & FlagDisabled) {
+            continue;
+        }
+
+        // TODO: find all of the lights that intersect this and add it to the per-light lists
+        _lit.push_back(static_cast<uint32_t>(i));
+
+        if(!visible(i)) {
+            continue;
+        }
+
+        // TODO: add transparent entries to a separate list
+        if(flags & FlagTransparent) {
+            _transparent_count++;
+            continue;
+        }
+
+        _visible.push_back(static_cast<uint32_t>(i));
+        if(flags & FlagPickable) {
+            _pickable.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // closer objects get rendered first
+    // to take advantage of early-out depth testing
+    std::sort(_visible.begin(), _visible.end(), CompareDistance(_distances));
+}
+
+}
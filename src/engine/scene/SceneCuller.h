@@ -0,0 +1,112 @@
+#if !defined __SCENECULLER_H__
+#define __SCENECULLER_H__
+
+#include "src/core/math/Vector.h"
+
+namespace energonsoftware {
+
+class AABB;
+class Frustum;
+class ThreadPool;
+
+/*
+Flat visibility culling for the scene graph
+
+The scene adds one entry (world-space bounds plus a few flags) per renderable,
+in renderable order, and cull() tests them against the view frustum
+in parallel. Each job writes its own run of visibility bits, which are then
+compacted into lists of entry indices, so nothing is reference counted
+or locked while culling.
+
+Bounds are stored as separate center and extent arrays so that
+the frustum can test a full SIMD register of boxes at a time.
+*/
+class SceneCuller
+{
+public:
+    enum
+    {
+        // entries tested per job
+        // NOTE: this must be a multiple of 32 so that jobs never share a visibility word
+        CullBatchSize = 512
+    };
+
+    enum Flags
+    {
+        FlagPickable = 0x01,
+        FlagTransparent = 0x02,
+
+        // never visible or lit (the renderable hasn't been published yet)
+        FlagDisabled = 0x04
+    };
+
+public:
+    SceneCuller();
+    virtual ~SceneCuller() throw();
+
+public:
+    size_t size() const { return _flags.size(); }
+
+    // NOTE: this keeps the storage around for the next frame
+    void clear();
+    void reserve(size_t count);
+
+    // returns the index of the new entry
+    size_t add(const Position& position, const AABB& relative_bounds, uint32_t flags);
+
+    // tests every entry against the frustum and builds the index lists,
+    // visible entries are sorted front to back from eye
+    void cull(ThreadPool& pool, const Frustum& frustum, const Position& eye);
+
+public:
+    bool visible(size_t idx) const { return 0 != (_visibility[idx >> 5] & (1u << (idx & 31))); }
+
+    // opaque visible entries, closest first
+    const std::vector<uint32_t>& visible() const { return _visible; }
+
+    // visible entries that can be picked
+    const std::vector<uint32_t>& pickable() const { return _pickable; }
+
+    // every enabled entry
+    // TODO: only the entries each light touches
+    const std::vector<uint32_t>& lit() const { return _lit; }
+
+    // visible transparent entries that were left out of visible()
+    size_t transparent_count() const { return _transparent_count; }
+
+private:
+    struct CompareDistance
+    {
+        explicit CompareDistance(const std::vector<float>& distances) : _distances(distances) {}
+
+        bool operator()(uint32_t lhs, uint32_t rhs) const { return _distances[lhs] < _distances[rhs]; }
+
+    private:
+        const std::vector<float>& _distances;
+    };
+
+private:
+    void cull_batch(const Frustum& frustum, const Position& eye, size_t begin, size_t end);
+    void compact();
+
+private:
+    std::vector<float> _center_x, _center_y, _center_z;
+    std::vector<float> _extent_x, _extent_y, _extent_z;
+    std::vector<uint32_t> _flags;
+
+    // one bit per entry
+    std::vector<uint32_t> _visibility;
+
+    // squared distance from the eye, only written for visible entries
+    std::vector<float> _distances;
+
+    std::vector<uint32_t> _visible, _pickable, _lit;
+    size_t _transparent_count;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SceneCuller);
+};
+
+}
+
+#endif
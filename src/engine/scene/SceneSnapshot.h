@@ -0,0 +1,35 @@
+#if !defined __SCENESNAPSHOT_H__
+#define __SCENESNAPSHOT_H__
+
+#include "src/engine/renderer/Renderable.h"
+
+namespace energonsoftware {
+
+/*
+Everything the render thread reads from the scene for a frame
+
+The update thread fills one in after each batch of simulation ticks
+and publishes it through the scene's triple buffer, the render thread
+acquires the newest one at the start of each frame and reads only that
+until the next frame. This way the render thread never reads a
+physical that's in the middle of being simulated.
+*/
+struct SceneSnapshot
+{
+    // the update tick that this is the state after
+    uint64_t tick;
+
+    // real (monotonic) time that this state corresponds to
+    double time;
+
+    Physical::Snapshot camera;
+
+    // indexed by Renderable::_snapshot_index
+    std::vector<Renderable::Snapshot> renderables;
+
+    SceneSnapshot() : tick(0), time(0.0) {}
+};
+
+}
+
+#endif
@@ -40,14 +40,8 @@ void GameUIController::key_down(energonsoftware::InputKeySym key)
     case energonsoftware::InputKeySym_f:
         LOG_INFO("Rendering wireframe...\n");
         config.render_wireframe(!config.render_wireframe());
-        {
-            boost::shared_ptr<energonsoftware::PolygonModeRenderCommand> command(
-                boost::dynamic_pointer_cast<energonsoftware::PolygonModeRenderCommand, energonsoftware::RenderCommand>(
-                    energonsoftware::RenderCommand::new_render_command(energonsoftware::RenderCommand::RC_POLYGON_MODE)));
-            command->face = GL_FRONT_AND_BACK;
-            command->mode = config.render_wireframe() ? GL_LINE : GL_FILL;
-            energonsoftware::Engine::instance().renderer().command_queue().push(command);
-        }
+        energonsoftware::Engine::instance().renderer().command_queue().push(
+            energonsoftware::RenderCommand::polygon_mode(GL_FRONT_AND_BACK, config.render_wireframe() ? GL_LINE : GL_FILL));
         break;
     case energonsoftware::InputKeySym_h:
         LOG_INFO("Rendering shadows...\n");
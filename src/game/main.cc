@@ -229,7 +229,7 @@ int main(int argc, char* argv[])
 
     float angle(energonsoftware::Engine::instance().state().scene().map().player_spawn_angle());
     LOG_INFO("Rotating " << angle << " degrees\n");
-    player->rotate(DEG_RAD(angle), energonsoftware::Vector3(0.0f, 1.0f, 0.0f));
+    player->orientation(energonsoftware::Quaternion::new_axis(DEG_RAD(angle), energonsoftware::Vector3(0.0f, 1.0f, 0.0f)) * player->orientation());
 
     // setup the UI controller
     //energonsoftware::UIController::controller()->grab_input(true);